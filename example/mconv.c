@@ -328,7 +328,9 @@ main (int argc, char **argv)
   MConverter *converter;
   int i;
 
-  /* Initialize the m17n library.  */
+  /* Initialize the m17n library.  Only a few charsets are used, so
+     define them on demand.  */
+  m17n_lazy_init = 1;
   M17N_INIT ();
   if (merror_code != MERROR_NONE)
     FATAL_ERROR ("%s\n", "Fail to initialize the m17n library.");
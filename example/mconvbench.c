@@ -0,0 +1,416 @@
+/* mconvbench.c -- Benchmark of code conversion.	-*- coding: euc-jp; -*-
+   Copyright (C) 2026
+     National Institute of Advanced Industrial Science and Technology (AIST)
+     Registration Number H15PRO112
+
+
+   This file is part of the m17n library.
+
+   The m17n library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   The m17n library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the m17n library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.  */
+
+/***en
+    @enpage m17n-convbench measure the speed of decoding
+
+    @section m17n-convbench-synopsis SYNOPSIS
+
+    m17n-convbench [ OPTION ... ] [ FILE ]
+
+    @section m17n-convbench-description DESCRIPTION
+
+    Decode FILE by each coding system repeatedly, and print the time
+    spent and the throughput.  If FILE is omitted, a mail-like text
+    mixing ASCII words with runs of the other characters the coding
+    system can encode is generated for each coding system, and
+    encoded by it.  The default coding systems are ISO-2022-JP and
+    ISO-2022-KR.
+
+    This program is not installed.  It is for comparing one build of
+    the m17n library with another.
+
+    The following OPTIONs are available.
+
+    <ul>
+
+    <li> -c CODING
+
+    Decode by CODING instead of the default coding systems.  This
+    option can be specified multiple times.
+
+    <li> -n PASSES
+
+    Decode the text PASSES times.  The default is 10.
+
+    <li> -s SIZE
+
+    Generate a text of about SIZE bytes.  The default is 4194304.
+
+    <li> --version
+
+    Print version number.
+
+    <li> -h, --help
+
+    Print this message.
+
+    </ul>
+*/
+/***ja
+    @japage m17n-convbench ǥɤ®פ
+
+    @section m17n-convbench-synopsis SYNOPSIS
+
+    m17n-convbench [ OPTION ... ] [ FILE ]
+
+    @section m17n-convbench-description 
+
+    FILE ƥɷϤǷ֤ǥɤä֤Ƚ®٤ɽ롣
+    FILE ά줿ˤϡASCII ñȤΥɷϤǥ󥳡ɤǤ¾ʸ¤ӤȤä᡼Τ褦ʥƥȤ
+    ɷϤȤƤΥɷϤǥ󥳡ɤΤѤ롣
+    ǥեȤΥɷϤ ISO-2022-JP  ISO-2022-KR Ǥ롣
+
+    Υץϥ󥹥ȡ뤵ʤ
+    m17n 饤֥ΥӥƱΤӤ뤿ΤΤǤ롣
+
+    ʲΥץѤǤ롣
+
+    <ul>
+
+    <li> -c CODING
+
+    ǥեȤΥɷϤ CODING ǥǥɤ롣
+    ΥץʣǤ롣
+
+    <li> -n PASSES
+
+    ƥȤ PASSES ǥɤ롣ǥեȤ 10 Ǥ롣
+
+    <li> -s SIZE
+
+     SIZE ХȤΥƥȤ롣ǥեȤ 4194304 Ǥ롣
+
+    <li> --version
+
+    Сֹɽ롣
+
+    <li> -h, --help
+
+    Υåɽ롣
+
+    </ul>
+*/
+
+#ifndef FOR_DOXYGEN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <m17n.h>
+#include <m17n-misc.h>
+
+#define MAX_CODINGS 16
+
+/* Ranges of characters tried for the non-ASCII part of a generated
+   text.  Only those encodable by the coding system are used.  */
+
+static int candidate_ranges[][2] =
+  { { 0x00A1, 0x00FF },		/* Latin-1 */
+    { 0x0391, 0x03C9 },		/* Greek */
+    { 0x0410, 0x044F },		/* Cyrillic */
+    { 0x3041, 0x3093 },		/* Hiragana */
+    { 0x30A1, 0x30F6 },		/* Katakana */
+    { 0x4E00, 0x9FA5 },		/* CJK Unified Ideographs */
+    { 0xAC00, 0xD7A3 } };	/* Hangul syllables */
+
+/* Print the usage of this program (the name is PROG), and exit with
+   EXIT_CODE.  */
+
+void
+help_exit (char *prog, int exit_code)
+{
+  char *p = prog;
+
+  while (*p)
+    if (*p++ == '/')
+      prog = p;
+
+  printf ("Usage: %s [ OPTION ... ] [ FILE ]\n", prog);
+  printf ("Measure the speed of decoding FILE or a generated text.\n");
+  printf ("The following OPTIONs are available.\n");
+  printf ("  %-13s %s", "-c CODING",
+	  "Decode by CODING (default: iso-2022-jp and iso-2022-kr).\n");
+  printf ("  %-13s %s", "-n PASSES", "Decode PASSES times (default: 10).\n");
+  printf ("  %-13s %s", "-s SIZE",
+	  "Generate a text of about SIZE bytes (default: 4194304).\n");
+  printf ("  %-13s %s", "--version", "Print version number.\n");
+  printf ("  %-13s %s", "-h, --help", "Print this message.\n");
+  exit (exit_code);
+}
+
+/* Return a pseudo random number in the range [0, N).  The sequence
+   is the same on any platform so that two builds decode the same
+   text.  */
+
+static int
+random_number (int n)
+{
+  static unsigned long seed = 1;
+
+  seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF;
+  return (seed >> 8) % n;
+}
+
+/* Return a newly allocated array of the characters in
+   candidate_ranges that CODING can encode, and store the number of
+   them in *NUM.  */
+
+static int *
+encodable_chars (MSymbol coding, int *num)
+{
+  unsigned char work[64];
+  MConverter *converter = mconv_buffer_converter (coding, work, sizeof work);
+  MText *mt = mtext ();
+  int *chars = NULL;
+  int i, c, n = 0, size = 0;
+
+  if (! converter)
+    return NULL;
+  for (i = 0; i < sizeof candidate_ranges / sizeof candidate_ranges[0]; i++)
+    for (c = candidate_ranges[i][0]; c <= candidate_ranges[i][1]; c++)
+      {
+	mtext_del (mt, 0, mtext_len (mt));
+	mtext_cat_char (mt, c);
+	mconv_reset_converter (converter);
+	mconv_rebind_buffer (converter, work, sizeof work);
+	if (mconv_encode (converter, mt) > 0
+	    && converter->result == MCONVERSION_RESULT_SUCCESS
+	    && converter->nchars == 1)
+	  {
+	    if (n == size)
+	      {
+		size = size ? size * 2 : 1024;
+		chars = realloc (chars, sizeof (int) * size);
+		if (! chars)
+		  exit (1);
+	      }
+	    chars[n++] = c;
+	  }
+      }
+  mconv_free_converter (converter);
+  m17n_object_unref (mt);
+  *num = n;
+  return chars;
+}
+
+/* Generate a mail-like text of about SIZE bytes encoded by CODING,
+   store it in a newly allocated buffer, and return the buffer.  The
+   length is stored in *NBYTES.  */
+
+static unsigned char *
+generate_text (MSymbol coding, int size, int *nbytes)
+{
+  int nchars, *chars = encodable_chars (coding, &nchars);
+  MText *mt = mtext ();
+  unsigned char *buf;
+  int len, bufsize, i;
+
+  if (! chars)
+    return NULL;
+  for (len = 0; len < size; )
+    {
+      int column = 0;
+
+      while (column < 64)
+	{
+	  int n = 1 + random_number (8);
+
+	  /* An ASCII word.  */
+	  for (i = 0; i < n; i++)
+	    mtext_cat_char (mt, 'a' + random_number (26));
+	  mtext_cat_char (mt, ' ');
+	  column += n + 1, len += n + 1;
+	  if (nchars > 0)
+	    {
+	      /* A run of the other characters.  */
+	      n = 4 + random_number (20);
+	      for (i = 0; i < n; i++)
+		mtext_cat_char (mt, chars[random_number (nchars)]);
+	      column += n * 2, len += n * 2;
+	    }
+	}
+      mtext_cat_char (mt, '\n');
+      len++;
+    }
+  free (chars);
+
+  bufsize = mtext_len (mt) * 8;
+  buf = malloc (bufsize);
+  if (! buf)
+    exit (1);
+  *nbytes = mconv_encode_buffer (coding, mt, buf, bufsize);
+  m17n_object_unref (mt);
+  if (*nbytes < 0)
+    {
+      free (buf);
+      return NULL;
+    }
+  return buf;
+}
+
+/* Read the contents of FILENAME into a newly allocated buffer, and
+   return the buffer.  The length is stored in *NBYTES.  */
+
+static unsigned char *
+read_file (char *filename, int *nbytes)
+{
+  FILE *fp = fopen (filename, "r");
+  unsigned char *buf = NULL;
+  int size = 0, n = 0;
+
+  if (! fp)
+    return NULL;
+  while (n == size)
+    {
+      size = size ? size * 2 : 0x10000;
+      buf = realloc (buf, size);
+      if (! buf)
+	exit (1);
+      n += fread (buf + n, 1, size - n, fp);
+    }
+  fclose (fp);
+  *nbytes = n;
+  return buf;
+}
+
+int
+main (int argc, char **argv)
+{
+  MSymbol codings[MAX_CODINGS];
+  int ncodings = 0;
+  int passes = 10, size = 4194304;
+  char *filename = NULL;
+  unsigned char *file_buf = NULL;
+  int file_nbytes = 0;
+  int nfailed = 0;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (! strcmp (argv[i], "--help")
+	  || ! strcmp (argv[i], "-h")
+	  || ! strcmp (argv[i], "-?"))
+	help_exit (argv[0], 0);
+      else if (! strcmp (argv[i], "--version"))
+	{
+	  printf ("m17n-convbench (m17n library) %s\n", M17NLIB_VERSION_NAME);
+	  printf ("Copyright (C) 2026 AIST, JAPAN\n");
+	  exit (0);
+	}
+      else if (! strcmp (argv[i], "-c") && i + 1 < argc)
+	{
+	  if (ncodings == MAX_CODINGS)
+	    help_exit (argv[0], 1);
+	  codings[ncodings++] = msymbol (argv[++i]);
+	}
+      else if (! strcmp (argv[i], "-n") && i + 1 < argc)
+	passes = atoi (argv[++i]);
+      else if (! strcmp (argv[i], "-s") && i + 1 < argc)
+	size = atoi (argv[++i]);
+      else if (argv[i][0] != '-' && ! filename)
+	filename = argv[i];
+      else
+	help_exit (argv[0], 1);
+    }
+  if (passes <= 0 || size <= 0)
+    help_exit (argv[0], 1);
+  if (ncodings == 0)
+    {
+      codings[ncodings++] = msymbol ("iso-2022-jp");
+      codings[ncodings++] = msymbol ("iso-2022-kr");
+    }
+
+  /* Initialize the m17n library.  */
+  M17N_INIT ();
+  if (merror_code != MERROR_NONE)
+    {
+      fprintf (stderr, "Fail to initialize the m17n library.\n");
+      exit (1);
+    }
+
+  if (filename)
+    {
+      file_buf = read_file (filename, &file_nbytes);
+      if (! file_buf)
+	{
+	  fprintf (stderr, "Fail to read %s.\n", filename);
+	  exit (1);
+	}
+    }
+
+  for (i = 0; i < ncodings; i++)
+    {
+      MSymbol coding = mconv_resolve_coding (codings[i]);
+      unsigned char *buf;
+      int nbytes, nchars = 0, pass;
+      clock_t t;
+      double sec;
+
+      if (coding == Mnil)
+	{
+	  fprintf (stderr, "Unknown coding: %s\n", msymbol_name (codings[i]));
+	  nfailed++;
+	  continue;
+	}
+      if (file_buf)
+	buf = file_buf, nbytes = file_nbytes;
+      else if (! (buf = generate_text (coding, size, &nbytes)))
+	{
+	  fprintf (stderr, "Fail to generate a text for %s\n",
+		   msymbol_name (coding));
+	  nfailed++;
+	  continue;
+	}
+
+      t = clock ();
+      for (pass = 0; pass < passes; pass++)
+	{
+	  MText *mt = mconv_decode_buffer (coding, buf, nbytes);
+
+	  if (! mt)
+	    break;
+	  nchars = mtext_len (mt);
+	  m17n_object_unref (mt);
+	}
+      sec = (double) (clock () - t) / CLOCKS_PER_SEC;
+      if (pass < passes)
+	{
+	  fprintf (stderr, "Fail to decode by %s\n", msymbol_name (coding));
+	  nfailed++;
+	}
+      else
+	printf ("%-16s %9d bytes %9d chars %3d passes %8.3f sec %8.1f MB/s\n",
+		msymbol_name (coding), nbytes, nchars, passes, sec,
+		sec > 0 ? (double) nbytes * passes / sec / 1048576 : 0);
+      if (buf != file_buf)
+	free (buf);
+    }
+  free (file_buf);
+
+  M17N_FINI ();
+  exit (nfailed > 0);
+}
+#endif /* not FOR_DOXYGEN */
@@ -0,0 +1,207 @@
+/* mdbcache.c -- Database cache compiler.		-*- coding: euc-jp; -*-
+   Copyright (C) 2026
+     National Institute of Advanced Industrial Science and Technology (AIST)
+     Registration Number H15PRO112
+
+   This file is part of the m17n library.
+
+   The m17n library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   The m17n library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the m17n library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.  */
+
+/***en
+    @enpage m17n-dbcache compile the m17n database into cache files
+
+    @section m17n-dbcache-synopsis SYNOPSIS
+
+    m17n-dbcache [ OPTION ... ]
+
+    @section m17n-dbcache-description DESCRIPTION
+
+    Compile all data of the m17n database into binary cache files so
+    that the m17n library loads them faster.  Each cache file is
+    created in the same directory as the file containing the data.
+    Data of the @e charset @e type are not compiled.  Each input
+    method is also compiled by minput_compile_im ().
+
+    The following OPTIONs are available.
+
+    <ul>
+
+    <li> -d DIR
+
+    Compile also the data listed in the file "mdb.dir" in directory
+    DIR.
+
+    <li> -v
+
+    Print the tags of each compiled data.
+
+    <li> --version
+
+    Print version number.
+
+    <li> -h, --help
+
+    Print this message.
+
+    </ul>
+*/
+/***ja
+    @japage m17n-dbcache m17n ǡ١򥭥åե˥ѥ뤹
+
+    @section m17n-dbcache-synopsis SYNOPSIS
+
+    m17n-dbcache [ OPTION ... ]
+
+    @section m17n-dbcache-description 
+
+    m17n 饤֥꤬®ɤǤ褦ˡm17n 
+    ǡ١ǡХʥΥåե˥ѥ뤹롣
+    ƥåեϥǡޤեƱǥ쥯ȥ˺롣
+    @e charset Υǡϥѥ뤵ʤ
+    ϥ᥽åɤ minput_compile_im () ǥѥ뤵롣
+
+    ʲΥץѤǤ롣
+
+    <ul>
+
+    <li> -d DIR
+
+    ǥ쥯ȥ DIR ˤե "mdb.dir" 
+    ˵Ҥ줿ǡ⥳ѥ뤹롣
+
+    <li> -v
+
+    ѥ뤷ƥǡΥɽ롣
+
+    <li> --version
+
+    Сֹɽ롣
+
+    <li> -h, --help
+
+    Υåɽ롣
+
+    </ul>
+*/
+
+#ifndef FOR_DOXYGEN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <m17n.h>
+#include <m17n-misc.h>
+
+/* Print the usage of this program (the name is PROG), and exit with
+   EXIT_CODE.  */
+
+void
+help_exit (char *prog, int exit_code)
+{
+  char *p = prog;
+
+  while (*p)
+    if (*p++ == '/')
+      prog = p;
+
+  printf ("Usage: %s [ OPTION ... ]\n", prog);
+  printf ("Compile the m17n database into cache files.\n");
+  printf ("The following OPTIONs are available.\n");
+  printf ("  %-13s %s", "-d DIR",
+	  "Compile also the data listed in DIR/mdb.dir.\n");
+  printf ("  %-13s %s", "-v", "Print the tags of each compiled data.\n");
+  printf ("  %-13s %s", "--version", "Print version number.\n");
+  printf ("  %-13s %s", "-h, --help", "Print this message.\n");
+  exit (exit_code);
+}
+
+int
+main (int argc, char **argv)
+{
+  int verbose = 0;
+  int ncompiled = 0, nfailed = 0;
+  MPlist *list, *plist;
+  MSymbol input_method;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (! strcmp (argv[i], "--help")
+	  || ! strcmp (argv[i], "-h")
+	  || ! strcmp (argv[i], "-?"))
+	help_exit (argv[0], 0);
+      else if (! strcmp (argv[i], "--version"))
+	{
+	  printf ("m17n-dbcache (m17n library) %s\n", M17NLIB_VERSION_NAME);
+	  printf ("Copyright (C) 2026 AIST, JAPAN\n");
+	  exit (0);
+	}
+      else if (! strcmp (argv[i], "-d") && i + 1 < argc)
+	mdatabase_dir = argv[++i];
+      else if (! strcmp (argv[i], "-v"))
+	verbose = 1;
+      else
+	help_exit (argv[0], 1);
+    }
+
+  /* Initialize the m17n library.  */
+  M17N_INIT ();
+  if (merror_code != MERROR_NONE)
+    {
+      fprintf (stderr, "Fail to initialize the m17n library.\n");
+      exit (1);
+    }
+
+  /* Minput_method is not yet initialized until the input method
+     module is used.  */
+  input_method = msymbol ("input-method");
+  list = mdatabase_list (Mnil, Mnil, Mnil, Mnil);
+  for (plist = list; plist && mplist_key (plist) != Mnil;
+       plist = mplist_next (plist))
+    {
+      MDatabase *mdb = mplist_value (plist);
+      MSymbol *tags = mdatabase_tag (mdb);
+
+      if (tags[0] == Mcharset)
+	continue;
+      if (mdatabase_compile (mdb) < 0
+	  || (tags[0] == input_method && tags[2] != Mnil && tags[3] == Mnil
+	      && minput_compile_im (tags[1], tags[2]) < 0))
+	{
+	  fprintf (stderr, "Fail to compile <%s, %s, %s, %s>\n",
+		   msymbol_name (tags[0]), msymbol_name (tags[1]),
+		   msymbol_name (tags[2]), msymbol_name (tags[3]));
+	  nfailed++;
+	}
+      else
+	{
+	  if (verbose)
+	    printf ("<%s, %s, %s, %s>\n",
+		    msymbol_name (tags[0]), msymbol_name (tags[1]),
+		    msymbol_name (tags[2]), msymbol_name (tags[3]));
+	  ncompiled++;
+	}
+    }
+  if (list)
+    m17n_object_unref (list);
+  if (verbose)
+    printf ("%d compiled, %d failed\n", ncompiled, nfailed);
+
+  M17N_FINI ();
+  exit (nfailed > 0);
+}
+#endif /* not FOR_DOXYGEN */
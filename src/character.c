@@ -549,6 +549,7 @@ mchar_get_prop (int c, MSymbol key)
       record->table = mdatabase_load (record->mdb);
       if (! record->table)
 	MERROR (MERROR_DB, NULL);
+      mchartable_freeze (record->table);
       record->mdb = NULL;
     }
   return mchartable_lookup (record->table, c);
@@ -556,6 +557,69 @@ mchar_get_prop (int c, MSymbol key)
 
 /*=*/
 
+/***en
+    @brief Get the values of a character property for an M-text.
+
+    The mchar_get_prop_mtext () function searches the characters of
+    M-text $MT between $FROM (inclusive) and $TO (exclusive) for the
+    character property whose key is $KEY, and stores the values in
+    order in the array pointed to by $VALUES, which must have at least
+    ($TO - $FROM) elements.  Each element is what mchar_get_prop ()
+    returns for the corresponding character, but the whole region is
+    handled in a single pass.
+
+    @return
+    If the operation was successful, mchar_get_prop_mtext () returns
+    0.  Otherwise it returns -1 and assigns an error code to the
+    external variable #merror_code.  */
+
+/***ja
+    @brief M-text ʸץѥƥͤ.
+
+    ؿ mchar_get_prop_mtext () ϡM-text $MT  $FROMʴޤˤ 
+    $TOʴޤޤʤˤޤǤʸˤĤơ $KEY 
+    Ǥʸץѥƥõͤ $VALUES ؤ˳Ǽ롣
+    ϾʤȤ ($TO - $FROM) ĤǤʤФʤʤ
+    ǤбʸФ mchar_get_prop () 
+    ֤ͤƱǤ뤬ΰΤ٤˽롣
+
+    @return
+     mchar_get_prop_mtext ()  0 ֤
+    Ǥʤ -1 ֤ѿ #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_RANGE, @c MERROR_DB
+
+    @seealso
+    mchar_get_prop (), mchartable_lookup_mtext ()  */
+
+int
+mchar_get_prop_mtext (MText *mt, int from, int to, MSymbol key,
+		      void **values)
+{
+  MCharPropRecord *record;
+
+  M_CHECK_RANGE_X (mt, from, to, -1);
+  record = char_prop_list ? mplist_get (char_prop_list, key) : NULL;
+  if (! record)
+    {
+      memset (values, 0, sizeof (void *) * (to - from));
+      return 0;
+    }
+  if (record->mdb)
+    {
+      record->table = mdatabase_load (record->mdb);
+      if (! record->table)
+	MERROR (MERROR_DB, -1);
+      mchartable_freeze (record->table);
+      record->mdb = NULL;
+    }
+  return mchartable_lookup_mtext (record->table, mt, from, to, values);
+}
+
+/*=*/
+
 /***en
     @brief Set the value of a character property.
 
@@ -643,6 +707,7 @@ mchar_get_prop_table (MSymbol key, MSymbol *type)
       record->table = mdatabase_load (record->mdb);
       if (! record->table)
 	MERROR (MERROR_DB, NULL);
+      mchartable_freeze (record->table);
       record->mdb = NULL;
     }
   if (type)
@@ -112,6 +112,98 @@ static struct MCharsetList charset_list;
 
 static MPlist *charset_definition_list;
 
+/** Plist of aliases (and canonicalized names) vs charset names of
+    charsets registered by mcharset__load_from_database () but not yet
+    defined.  It is used only when #m17n_lazy_init is nonzero.  */
+
+static MPlist *charset_alias_list;
+
+/** Nonzero if some charset in charset_definition_list is not yet
+    defined.  */
+
+static int charset_pending;
+
+/** Return the dimension of a charset defined by PLIST, and set
+    *MIN_RANGE and *MAX_RANGE to the minimum and maximum code ranges
+    of it.  */
+
+static int
+charset_dimension (MPlist *plist, unsigned *min_range, unsigned *max_range)
+{
+  int dimension;
+  MPlist *pl;
+
+  if (! (dimension = (int) mplist_get (plist, Mdimension)))
+    dimension = 1;
+
+  *min_range = (unsigned) mplist_get (plist, Mmin_range);
+  if ((pl = mplist_find_by_key (plist, Mmax_range)))
+    {
+      *max_range = (unsigned) MPLIST_VAL (pl);
+      if (*max_range >= 0x1000000)
+	dimension = 4;
+      else if (*max_range >= 0x10000 && dimension < 3)
+	dimension = 3;
+      else if (*max_range >= 0x100 && dimension < 2)
+	dimension = 2;
+    }
+  else if (dimension == 1)
+    *max_range = 0xFF;
+  else if (dimension == 2)
+    *max_range = 0xFFFF;
+  else if (dimension == 3)
+    *max_range = 0xFFFFFF;
+  else
+    *max_range = 0xFFFFFFFF;
+  return dimension;
+}
+
+/** Register the charset NAME defined by PLIST without defining it.
+    The charset is defined by mcharset__find () on demand.  */
+
+static void
+register_charset (MSymbol name, MPlist *plist)
+{
+  MPlist *pl;
+
+  mplist_put (charset_alias_list, msymbol__canonicalize (name), name);
+  for (pl = (MPlist *) mplist_get (plist, Maliases);
+       pl && MPLIST_KEY (pl) == Msymbol;
+       pl = MPLIST_NEXT (pl))
+    {
+      MSymbol alias = MPLIST_SYMBOL (pl);
+
+      mplist_put (charset_alias_list, alias, name);
+      mplist_put (charset_alias_list, msymbol__canonicalize (alias), name);
+    }
+
+  if (mplist_get (plist, Mdefine_coding))
+    {
+      unsigned min_range, max_range;
+
+      if (charset_dimension (plist, &min_range, &max_range) == 1
+	  && (min_range & 0xFF) == 0 && (max_range & 0xFF) == 0xFF)
+	mconv__register_charset_coding (name);
+    }
+  charset_pending = 1;
+}
+
+/** Define all charsets registered by register_charset () but not yet
+    defined.  */
+
+static void
+define_pending_charsets ()
+{
+  MPlist *plist;
+
+  if (! charset_pending)
+    return;
+  charset_pending = 0;
+  MPLIST_DO (plist, charset_definition_list)
+    if (! msymbol_get (MPLIST_KEY (plist), Mcharset))
+      mcharset__find (MPLIST_KEY (plist));
+}
+
 /** Make a charset object from the template of MCharset structure
     CHARSET, and return a pointer to the new charset object.
     CHARSET->code_range[4N + 2] and CHARSET->code_range[4N + 3] are
@@ -432,6 +524,8 @@ mcharset__init ()
   MLIST_INIT1 (&charset_list, charsets, 128);
   MLIST_INIT1 (&mcharset__iso_2022_table, charsets, 128);
   charset_definition_list = mplist ();
+  charset_alias_list = mplist ();
+  charset_pending = 0;
 
   memset (mcharset__iso_2022_table.classified, 0,
 	  sizeof (mcharset__iso_2022_table.classified));
@@ -514,6 +608,7 @@ mcharset__fini (void)
   MPLIST_DO (plist, charset_definition_list)
     M17N_OBJECT_UNREF (MPLIST_VAL (plist));
   M17N_OBJECT_UNREF (charset_definition_list);
+  M17N_OBJECT_UNREF (charset_alias_list);
 }
 
 
@@ -529,7 +624,16 @@ mcharset__find (MSymbol name)
 
       MPLIST_KEY (mcharset__cache) = Mt;
       if (! param)
-	return NULL;
+	{
+	  /* NAME may be an alias of a charset not yet defined.  */
+	  MSymbol charset_name = mplist_get (charset_alias_list, name);
+
+	  if (! charset_name
+	      || ! (param = mplist_get (charset_definition_list,
+					charset_name)))
+	    return NULL;
+	  name = charset_name;
+	}
       param = mplist__from_plist (param);
       mchar_define_charset (MSYMBOL_NAME (name), param);
       charset = msymbol_get (name, Mcharset);
@@ -541,6 +645,19 @@ mcharset__find (MSymbol name)
 }
 
 
+/** Load the data of CHARSET (and of its parents) if not yet loaded.
+    Return 0 on success, -1 on failure.  */
+
+int
+mcharset__load_fully (MCharset *charset)
+{
+  if (! charset->fully_loaded
+      && load_charset_fully (charset) < 0)
+    MERROR (MERROR_CHARSET, -1);
+  return 0;
+}
+
+
 /** Return the character corresponding to code-point CODE in CHARSET.
     If CODE is invalid for CHARSET, return -1.  */
 
@@ -694,7 +811,16 @@ mcharset__load_from_database ()
       definitions = mplist_add (definitions, name, pl);
       M17N_OBJECT_REF (pl);
       p = mplist__from_plist (pl);
-      mchar_define_charset (MSYMBOL_NAME (name), p);
+      /* A charset having a final byte or using the unify method
+	 updates the ISO-2022 table or unified_max, which depends on
+	 the order of definitions.  So, define it now even in the lazy
+	 mode.  */
+      if (m17n_lazy_init
+	  && ! mplist_get (p, Mfinal_byte)
+	  && (MSymbol) mplist_get (p, Mmethod) != Munify)
+	register_charset (name, p);
+      else
+	mchar_define_charset (MSYMBOL_NAME (name), p);
       M17N_OBJECT_UNREF (p);
     }
 
@@ -1259,28 +1385,7 @@ mchar_define_charset (const char *name, MPlist *plist)
 	MERROR (MERROR_CHARSET, Mnil);
       mdatabase_define (Mcharset, sym, Mnil, Mnil, NULL, mapfile->data);
     }
-  if (! (charset->dimension = (int) mplist_get (plist, Mdimension)))
-    charset->dimension = 1;
-
-  min_range = (unsigned) mplist_get (plist, Mmin_range);
-  if ((pl = mplist_find_by_key (plist, Mmax_range)))
-    {
-      max_range = (unsigned) MPLIST_VAL (pl);
-      if (max_range >= 0x1000000)
-	charset->dimension = 4;
-      else if (max_range >= 0x10000 && charset->dimension < 3)
-	charset->dimension = 3;
-      else if (max_range >= 0x100 && charset->dimension < 2)
-	charset->dimension = 2;
-    }
-  else if (charset->dimension == 1)
-    max_range = 0xFF;
-  else if (charset->dimension == 2)
-    max_range = 0xFFFF;
-  else if (charset->dimension == 3)
-    max_range = 0xFFFFFF;
-  else
-    max_range = 0xFFFFFFFF;
+  charset->dimension = charset_dimension (plist, &min_range, &max_range);
 
   memset (charset->code_range, 0, sizeof charset->code_range);
   for (i = 0; i < charset->dimension; i++, min_range >>= 8, max_range >>= 8)
@@ -1359,12 +1464,12 @@ mchar_define_charset (const char *name, MPlist *plist)
 MSymbol
 mchar_resolve_charset (MSymbol symbol)
 {
-  MCharset *charset = (MCharset *) msymbol_get (symbol, Mcharset);
+  MCharset *charset = MCHARSET (symbol);
 
   if (! charset)
     {
       symbol = msymbol__canonicalize (symbol);
-      charset = (MCharset *) msymbol_get (symbol, Mcharset);
+      charset = MCHARSET (symbol);
     }
 
   return (charset ? charset->name : Mnil);
@@ -1391,6 +1496,7 @@ mchar_list_charset (MSymbol **symbols)
 {
   int i;
 
+  define_pending_charsets ();
   MTABLE_MALLOC ((*symbols), charset_list.used, MERROR_CHARSET);
   for (i = 0; i < charset_list.used; i++)
     (*symbols)[i] = charset_list.charsets[i]->name;
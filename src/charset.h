@@ -246,6 +246,7 @@ extern MCharsetISO2022Table mcharset__iso_2022_table;
   mcharset__iso_2022_table.classified[(dim) - 1][(chars) == 96][(final)]
 
 extern MCharset *mcharset__find (MSymbol name);
+extern int mcharset__load_fully (MCharset *charset);
 extern int mcharset__decode_char (MCharset *charset, unsigned code);
 extern unsigned mcharset__encode_char (MCharset *charset, int c);
 extern int mcharset__load_from_database ();
@@ -74,6 +74,8 @@
 #include "m17n-misc.h"
 #include "internal.h"
 #include "symbol.h"
+#include "character.h"
+#include "mtext.h"
 
 static M17NObjectArray chartable_table;
 
@@ -193,8 +195,20 @@ struct MCharTable
   int min_char, max_char;
 
   MSubCharTable subtable;
+
+  /** Two-stage lookup table made by mchartable_freeze (), or NULL.
+      The value of character C (<min_char> <= C <= <max_char>) is
+      <frozen_values>[(<frozen_index>[C >> SUB_BITS_3] << SUB_BITS_3)
+      | (C & chartab_mask[3])].  */
+  unsigned short *frozen_index;
+  void **frozen_values;
 };
 
+#define FROZEN_LOOKUP(table, c)					\
+  ((table)->frozen_values[((table)->frozen_index[(c) >> SUB_BITS_3]	\
+			   << SUB_BITS_3)				\
+			  | ((c) & chartab_mask[3])])
+
 
 
 
@@ -399,6 +413,40 @@ lookup_chartable (MSubCharTable *table, int c, int *next_c, int default_p)
   return val;
 }
 
+/** Return the deepest sub char-table of TABLE that covers C, i.e. a
+    table of the bottom level or a table whose contents is NULL.  */
+
+static MSubCharTable *
+find_leaf_chartable (MSubCharTable *table, int c)
+{
+  int depth = TABLE_DEPTH (table);
+
+  while (table->contents.tables && depth < CHAR_TAB_MAX_DEPTH)
+    {
+      table = table->contents.tables + SUB_IDX (depth, c);
+      depth++;
+    }
+  return table;
+}
+
+/** Store the values of characters C through C + chartab_chars[3] - 1
+    in char-table TABLE into BLOCK.  C must be aligned to the
+    boundary of a bottom level sub char-table.  */
+
+static void
+get_chartable_block (MSubCharTable *table, int c, void **block)
+{
+  int i;
+
+  table = find_leaf_chartable (table, c);
+  if (table->contents.tables)
+    memcpy (block, table->contents.values,
+	    sizeof (void *) * chartab_chars[3]);
+  else
+    for (i = 0; i < chartab_chars[3]; i++)
+      block[i] = table->default_value;
+}
+
 /** Call FUNC for characters in sub char-table TABLE.  Ignore such
     characters that has a value IGNORE.  FUNC is called with four
     arguments; FROM, TO, VAL, and ARG (same as FUNC_ARG).  If
@@ -505,12 +553,28 @@ chartab_max_non_default_char (MSubCharTable *table, void *default_value)
   return -1;
 }
 
+/* Free the two-stage lookup table of TABLE made by
+   mchartable_freeze ().  */
+
+static void
+thaw_chartable (MCharTable *table)
+{
+  if (table->frozen_index)
+    {
+      free (table->frozen_index);
+      free (table->frozen_values);
+      table->frozen_index = NULL;
+      table->frozen_values = NULL;
+    }
+}
+
 static void
 free_chartable (void *object)
 {
   MCharTable *table = (MCharTable *) object;
   int managedp = table->key != Mnil && table->key->managing_key;
 
+  thaw_chartable (table);
   if (table->subtable.contents.tables)
     {
       int i;
@@ -749,11 +813,92 @@ mchartable_lookup (MCharTable *table, int c)
 
   if (c < table->min_char || c > table->max_char)
     return table->subtable.default_value;
+  if (table->frozen_index)
+    return FROZEN_LOOKUP (table, c);
   return lookup_chartable (&table->subtable, c, NULL, 0);
 }
 
 /*=*/
 
+/***en
+    @brief Look up a chartable for characters of an M-text.
+
+    The mchartable_lookup_mtext () function looks up chartable $TABLE
+    for the characters of M-text $MT between $FROM (inclusive) and $TO
+    (exclusive), and stores the values in order in the array pointed
+    to by $VALUES, which must have at least ($TO - $FROM) elements.
+    This is equivalent to calling mchartable_lookup () for each
+    character, but is much faster for a long run of characters
+    because it decodes $MT sequentially and reuses the sub-table of
+    the previous character.
+
+    @return
+    If the operation was successful, mchartable_lookup_mtext ()
+    returns 0.  Otherwise it returns -1 and assigns an error code to
+    the external variable #merror_code.  */
+
+/***ja
+    @brief M-text ʸˤĤʸơ֥򸡺.
+
+    ؿ mchartable_lookup_mtext () ϡM-text $MT  $FROMʴޤˤ 
+    $TOʴޤޤʤˤޤǤʸˤĤʸơ֥ $TABLE 򸡺
+    ͤ $VALUES ؤ˳Ǽ롣ϾʤȤ ($TO - $FROM) 
+    ĤǤʤФʤʤ
+    ϳʸˤĤ mchartable_lookup () Ƥ֤ΤƱǤ뤬
+    $MT ˥ǥɤľʸʬơ֥ѤΤǡ
+    ĹʸФƤϤϤ뤫®
+
+    @return
+     mchartable_lookup_mtext ()  0 ֤
+    Ǥʤ -1 ֤ѿ #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_RANGE
+
+    @seealso
+    mchartable_lookup (), mchar_get_prop_mtext ()  */
+
+int
+mchartable_lookup_mtext (MCharTable *table, MText *mt, int from, int to,
+			 void **values)
+{
+  MSubCharTable *leaf = NULL;
+  int leaf_min = 0, leaf_max = -1;
+  unsigned char *p = NULL;
+  int i;
+
+  M_CHECK_RANGE_X (mt, from, to, -1);
+  if (mt->format <= MTEXT_FORMAT_UTF_8)
+    p = mt->data + POS_CHAR_TO_BYTE (mt, from);
+  for (i = from; i < to; i++)
+    {
+      int c = p ? STRING_CHAR_ADVANCE_UTF8 (p) : mtext_ref_char (mt, i);
+
+      if (c < table->min_char || c > table->max_char)
+	*values++ = table->subtable.default_value;
+      else if (table->frozen_index)
+	*values++ = FROZEN_LOOKUP (table, c);
+      else
+	{
+	  if (c < leaf_min || c > leaf_max)
+	    {
+	      leaf = find_leaf_chartable (&table->subtable, c);
+	      leaf_min = TABLE_MIN_CHAR (leaf);
+	      leaf_max = leaf_min + (chartab_chars[TABLE_DEPTH (leaf)] - 1);
+	      if (leaf_max < 0 || leaf_max > MCHAR_MAX)
+		leaf_max = MCHAR_MAX;
+	    }
+	  *values++ = (leaf->contents.tables
+		       ? leaf->contents.values[SUB_IDX (CHAR_TAB_MAX_DEPTH, c)]
+		       : leaf->default_value);
+	}
+    }
+  return 0;
+}
+
+/*=*/
+
 /***en
     @brief Assign a value to a character in a chartable.
 
@@ -792,6 +937,7 @@ mchartable_set (MCharTable *table, int c, void *val)
 
   M_CHECK_CHAR (c, -1);
 
+  thaw_chartable (table);
   if (table->max_char < 0)
     table->min_char = table->max_char = c;
   else
@@ -868,6 +1014,7 @@ mchartable_set_range (MCharTable *table, int from, int to, void *val)
   if (from > to)
     return 0;
 
+  thaw_chartable (table);
   if (table->max_char < 0)
     table->min_char = from, table->max_char = to;
   else{
@@ -966,6 +1113,107 @@ mchartable_map (MCharTable *table, void *ignore,
 
 /*=*/
 
+/***en
+    @brief Compile a chartable for fast lookup.
+
+    The mchartable_freeze () function compiles chartable $TABLE into a
+    two-stage array: an index of blocks of consecutive characters and
+    the values of the blocks, where blocks of the same values are
+    shared.  After that, mchartable_lookup () on $TABLE takes constant
+    time, and it does not modify $TABLE, so a frozen chartable can be
+    looked up from multiple threads at the same time.
+
+    Setting a value in $TABLE by mchartable_set () or
+    mchartable_set_range () discards the compiled array.  Such a
+    modification must not be done while another thread is looking up
+    $TABLE.
+
+    @return
+    If the operation was successful, mchartable_freeze () returns 0.
+    Otherwise it returns -1 and assigns an error code to the external
+    variable #merror_code.  */
+
+/***ja
+    @brief ʸơ֥®Ѥ˥ѥ뤹.
+
+    ؿ mchartable_freeze () ʸơ֥ $TABLE 
+    Ϣ³ʸΥ֥åκȥ֥åͤ󤫤ʤ룲ʤ˥ѥ뤹롣
+    Ʊͤĥ֥å϶ͭ롣
+    ʸ塢$TABLE Ф mchartable_lookup () ϰ֤ǽꡢ
+    $TABLE ѹʤΤǡ뤵줿ʸơ֥ʣΥåɤƱ˸Ǥ롣
+
+    mchartable_set ()  mchartable_set_range ()  $TABLE 
+    ͤꤹȡѥ뤵줿˴롣
+    ¾Υåɤ $TABLE 򸡺Ƥ֤ˤΤ褦ѹԤʤäƤϤʤʤ
+
+    @return
+     mchartable_freeze ()  0 ֤Ǥʤ
+    -1 ֤ѿ #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @seealso
+    mchartable_lookup ()  */
+
+int
+mchartable_freeze (MCharTable *table)
+{
+  int nblocks, min_block, nvalues, size, hash_size;
+  int block_size = chartab_chars[3];
+  unsigned short *index;
+  void **values, **block;
+  int *heads, *chain;
+  int i, j;
+
+  if (table->frozen_index || table->max_char < 0)
+    return 0;
+  nblocks = (table->max_char >> SUB_BITS_3) + 1;
+  min_block = table->min_char >> SUB_BITS_3;
+  for (hash_size = 64; hash_size < nblocks; hash_size *= 2);
+  MTABLE_CALLOC (index, nblocks, MERROR_CHARTABLE);
+  size = 16;
+  MTABLE_MALLOC (values, size * block_size, MERROR_CHARTABLE);
+  MTABLE_MALLOC (heads, hash_size, MERROR_CHARTABLE);
+  MTABLE_MALLOC (chain, nblocks, MERROR_CHARTABLE);
+  MTABLE_ALLOCA (block, block_size, MERROR_CHARTABLE);
+  for (i = 0; i < hash_size; i++)
+    heads[i] = -1;
+
+  for (i = min_block, nvalues = 0; i < nblocks; i++)
+    {
+      unsigned hash = 2166136261U;
+
+      get_chartable_block (&table->subtable, i << SUB_BITS_3, block);
+      for (j = 0; j < block_size; j++)
+	hash = (hash ^ (unsigned) (size_t) block[j]) * 16777619U;
+      for (j = heads[hash & (hash_size - 1)]; j >= 0; j = chain[j])
+	if (! memcmp (values + j * block_size, block,
+		      sizeof (void *) * block_size))
+	  break;
+      if (j < 0)
+	{
+	  if (nvalues == size)
+	    {
+	      size *= 2;
+	      MTABLE_REALLOC (values, size * block_size, MERROR_CHARTABLE);
+	    }
+	  j = nvalues++;
+	  memcpy (values + j * block_size, block,
+		  sizeof (void *) * block_size);
+	  chain[j] = heads[hash & (hash_size - 1)];
+	  heads[hash & (hash_size - 1)] = j;
+	}
+      index[i] = j;
+    }
+  free (heads);
+  free (chain);
+  MTABLE_REALLOC (values, nvalues * block_size, MERROR_CHARTABLE);
+  table->frozen_index = index;
+  table->frozen_values = values;
+  return 0;
+}
+
+/*=*/
+
 /*** @} */
 
 /*** @addtogroup m17nDebug */
@@ -65,6 +65,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>
+#if defined (__AVX2__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "m17n.h"
 #include "m17n-misc.h"
@@ -120,6 +125,12 @@ typedef struct
   void *extra_spec;
 
   int ready;
+
+  /** For a coding system of type Mcharset whose charsets are all of
+      dimension 1, the table mapping a character in BMP to its byte
+      code.  The value 0 means that the character must be encoded by
+      looking up the charsets.  It is built on the first encoding.  */
+  unsigned char *encode_table;
 } MCodingSystem;
 
 struct MCodingList
@@ -132,6 +143,9 @@ static struct MCodingList coding_list;
 
 static MPlist *coding_definition_list;
 
+/* Lock for setting up coding systems lazily.  */
+M17N_MUTEX (coding_lock)
+
 typedef struct {
   /**en
      Pointer to a structure of a coding system.  */
@@ -457,6 +471,42 @@ finish_decoding (MText *mt, MConverter *converter, int nchars,
 
 
 
+/* Return the number of ASCII bytes at the head of the area between P
+   and PEND.  */
+
+static int
+ascii_run_length (const unsigned char *p, const unsigned char *pend)
+{
+  const unsigned char *p0 = p;
+
+#if defined (__AVX2__)
+  while (pend - p >= 32
+	 && ! _mm256_movemask_epi8 (_mm256_loadu_si256 ((const __m256i *) p)))
+    p += 32;
+#endif
+#if defined (__SSE2__)
+  while (pend - p >= 16
+	 && ! _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) p)))
+    p += 16;
+#else
+  {
+    unsigned long mask = ((unsigned long) -1 / 0xFF) * 0x80;
+    unsigned long word;
+
+    while (pend - p >= sizeof (unsigned long))
+      {
+	memcpy (&word, p, sizeof (unsigned long));
+	if (word & mask)
+	  break;
+	p += sizeof (unsigned long);
+      }
+  }
+#endif
+  while (p < pend && *p < 0x80)
+    p++;
+  return p - p0;
+}
+
 /* Staffs for coding-systems of type MCODING_TYPE_CHARSET.  */
 
 static int
@@ -500,17 +550,83 @@ setup_coding_charset (MCodingSystem *coding)
   return 0;
 }
 
+/* Return the table mapping BMP characters to byte codes for CODING
+   (see the member encode_table of MCodingSystem), or NULL if CODING
+   has a charset of dimension more than 1.  Build the table if not
+   yet done.  An entry is set only if the charsets are looked up in
+   the same order as encode_coding_charset () does and the first
+   charset that can encode the character gives that code.  */
+
+static unsigned char *
+get_charset_encode_table (MCodingSystem *coding)
+{
+  unsigned char *table = M17N_LOAD_ACQUIRE (coding->encode_table);
+  int i, j;
+
+  if (table)
+    return table;
+  for (i = 0; i < coding->ncharsets; i++)
+    if (coding->charsets[i]->dimension != 1)
+      return NULL;
+
+  M17N_LOCK (coding_lock);
+  if (! coding->encode_table)
+    {
+      MTABLE_CALLOC (table, 0x10000, MERROR_CODING);
+      for (i = 0; i < coding->ncharsets; i++)
+	{
+	  MCharset *charset = coding->charsets[i];
+	  unsigned code;
+
+	  for (code = charset->min_code; code <= charset->max_code; code++)
+	    {
+	      int c = DECODE_CHAR (charset, code);
+
+	      if (c < 0x80 || c >= 0x10000 || table[c]
+		  || ENCODE_CHAR (charset, c) != code)
+		continue;
+	      for (j = 0; j < i; j++)
+		if (ENCODE_CHAR (coding->charsets[j], c)
+		    != MCHAR_INVALID_CODE)
+		  break;
+	      if (j == i)
+		table[c] = code;
+	    }
+	}
+      M17N_STORE_RELEASE (coding->encode_table, table);
+    }
+  table = coding->encode_table;
+  M17N_UNLOCK (coding_lock);
+  return table;
+}
+
+/* Call SETUP for CODING unless it is already done.  Return -1 if
+   SETUP fails, 0 otherwise.  */
+
+static int
+setup_coding (MCodingSystem *coding, int (*setup) (MCodingSystem *))
+{
+  int result = 0;
+
+  if (M17N_LOAD_ACQUIRE (coding->ready))
+    return 0;
+  M17N_LOCK (coding_lock);
+  if (! coding->ready)
+    {
+      result = (*setup) (coding);
+      if (result >= 0)
+	M17N_STORE_RELEASE (coding->ready, 1);
+    }
+  M17N_UNLOCK (coding_lock);
+  return (result < 0 ? -1 : 0);
+}
+
 static int
 reset_coding_charset (MConverter *converter)
 {
   MConverterStatus *internal = (MConverterStatus *) converter->internal_info;
-  MCodingSystem *coding = internal->coding;
 
-  if (! coding->ready
-      && setup_coding_charset (coding) < 0)
-    return -1;
-  coding->ready = 1;
-  return 0;
+  return setup_coding (internal->coding, setup_coding_charset);
 }
 
 static int
@@ -609,12 +725,44 @@ encode_coding_charset (MText *mt, int from, int to,
   MCharset **charsets = coding->charsets;
   int ascii_compatible = coding->ascii_compatible;
   enum MTextFormat format = mt->format;
+  unsigned char *encode_table = get_charset_encode_table (coding);
 
   SET_SRC (mt, format, from, to);
   while (1)
     {
       int c, bytes;
 
+      if (format <= MTEXT_FORMAT_UTF_8 && (ascii_compatible || encode_table))
+	/* Encode a run of characters that need no charset lookup.
+	   Runs of ASCII characters are copied at once.  */
+	while (src < src_end && dst < dst_end)
+	  {
+	    c = *src;
+	    if (c < 0x80 && ascii_compatible)
+	      {
+		int n = ascii_run_length (src, src_end);
+
+		if (n > dst_end - dst)
+		  n = dst_end - dst;
+		memcpy (dst, src, n);
+		src += n, dst += n, nchars += n;
+		continue;
+	      }
+	    if (! encode_table)
+	      break;
+	    if (c >= 0xC2 && c < 0xE0 && src_end - src >= 2)
+	      c = ((c & 0x1F) << 6) | (src[1] & 0x3F), bytes = 2;
+	    else if (c >= 0xE0 && c < 0xF0 && src_end - src >= 3)
+	      c = (((c & 0x0F) << 12) | ((src[1] & 0x3F) << 6)
+		   | (src[2] & 0x3F)), bytes = 3;
+	    else
+	      break;
+	    if (! encode_table[c])
+	      break;
+	    *dst++ = encode_table[c];
+	    src += bytes, nchars++;
+	  }
+
       ONE_MORE_CHAR (c, bytes, format);
 
       if (c < 0x80 && ascii_compatible)
@@ -622,6 +770,11 @@ encode_coding_charset (MText *mt, int from, int to,
 	  CHECK_DST (1);
 	  *dst++ = c;
 	}
+      else if (encode_table && c < 0x10000 && encode_table[c])
+	{
+	  CHECK_DST (1);
+	  *dst++ = encode_table[c];
+	}
       else
 	{
 	  unsigned code;
@@ -714,6 +867,68 @@ encode_coding_charset (MText *mt, int from, int to,
    : (mcharset__binary))
 
 
+/* Return the number of bytes at the head of the area between SRC and
+   SRC_END that are the shortest form UTF-8 sequences of at most
+   MAX_CHARS Unicode characters (except for surrogates), and set
+   *NCHARS to the number of those characters.  Decoding those bytes
+   results in the same byte sequence.  */
+
+static int
+scan_utf_8 (const unsigned char *src, const unsigned char *src_end,
+	    int max_chars, int *nchars)
+{
+  const unsigned char *p = src;
+  int n = 0;
+
+  while (p < src_end && n < max_chars)
+    {
+      int c = *p;
+
+      if (c < 0x80)
+	{
+	  int len = (max_chars - n < src_end - p
+		     ? ascii_run_length (p, p + (max_chars - n))
+		     : ascii_run_length (p, src_end));
+
+	  p += len, n += len;
+	  continue;
+	}
+      if (c < 0xC2)
+	break;
+      if (c < 0xE0)
+	{
+	  if (src_end - p < 2
+	      || (p[1] & 0xC0) != 0x80)
+	    break;
+	  p += 2;
+	}
+      else if (c < 0xF0)
+	{
+	  if (src_end - p < 3
+	      || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80
+	      || (c == 0xE0 && p[1] < 0xA0)
+	      || (c == 0xED && p[1] >= 0xA0))
+	    break;
+	  p += 3;
+	}
+      else if (c < 0xF5)
+	{
+	  if (src_end - p < 4
+	      || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80
+	      || (p[3] & 0xC0) != 0x80
+	      || (c == 0xF0 && p[1] < 0x90)
+	      || (c == 0xF4 && p[1] >= 0x90))
+	    break;
+	  p += 4;
+	}
+      else
+	break;
+      n++;
+    }
+  *nchars = n;
+  return p - src;
+}
+
 static int
 decode_coding_utf_8 (const unsigned char *source, int src_bytes, MText *mt,
 		     MConverter *converter)
@@ -738,6 +953,33 @@ decode_coding_utf_8 (const unsigned char *source, int src_bytes, MText *mt,
       int c, c1, bytes;
       MCharset *this_charset = NULL;
 
+      /* Copy valid UTF-8 sequences in SOURCE as is.  The remaining
+	 (invalid, incomplete, or non-shortest) sequence is decoded
+	 byte by byte below.  */
+      if (charset == NULL && src_stop == src_end)
+	{
+	  int n;
+
+	  bytes = scan_utf_8 (src, src_end,
+			      at_most < 0 ? src_end - src : at_most - nchars,
+			      &n);
+	  if (bytes > 0)
+	    {
+	      if (dst + bytes + 1 > dst_end)
+		{
+		  int len = dst - mt->data;
+
+		  mtext__enlarge (mt, len + (src_end - src));
+		  dst = mt->data + len;
+		  dst_end = mt->data + mt->allocated;
+		}
+	      memcpy (dst, src, bytes);
+	      dst += bytes;
+	      src += bytes;
+	      nchars += n;
+	    }
+	}
+
       ONE_MORE_BASE_BYTE (c);
 
       if (!(c & 0x80))
@@ -912,10 +1154,8 @@ reset_coding_utf (MConverter *converter)
   MCodingSystem *coding = internal->coding;
   struct utf_status *status = (struct utf_status *) &(converter->status);
 
-  if (! coding->ready
-      && setup_coding_utf (coding) < 0)
+  if (setup_coding (coding, setup_coding_utf) < 0)
     return -1;
-  coding->ready = 1;
 
   status->surrogate = 0;
   status->bom = ((MCodingInfoUTF *) (coding->extra_spec))->bom;
@@ -1454,10 +1694,8 @@ reset_coding_iso_2022 (MConverter *converter)
   struct iso_2022_spec *spec;
   int i;
 
-  if (! coding->ready
-      && setup_coding_iso_2022 (coding) < 0)
+  if (setup_coding (coding, setup_coding_iso_2022) < 0)
     return -1;
-  coding->ready = 1;
 
   spec = (struct iso_2022_spec *) coding->extra_spec;
   status->invocation[0] = spec->initial_invocation[0];
@@ -1577,6 +1815,108 @@ decode_coding_iso_2022 (const unsigned char *source, int src_bytes, MText *mt,
       MCharset *this_charset = NULL;
       int c1, c2, c3;
 
+      /* Fast path: decode a run of graphic characters of the charsets
+	 currently invoked to GL and GR in a tight loop.  The run stops
+	 at a byte that needs the state machine below (an escape
+	 sequence, a shift function, a code not in the charset, etc.)
+	 or at a character not complete in SOURCE, and the remaining
+	 bytes are handled as before.  */
+      if (src_stop == src_end && src < src_end
+	  && ! status->utf8_shifting && status->non_standard_encoding <= 0)
+	{
+	  int max_chars = (at_most < 0 || at_most - nchars > src_end - src
+			   ? src_end - src : at_most - nchars);
+
+	  c1 = *src;
+	  if (c1 < 0x80 && charset0 == mcharset__ascii)
+	    {
+	      /* Graphic and control characters (except for those
+		 starting escape sequences and shift functions) are
+		 decoded to the same bytes.  */
+	      const unsigned char *p = src, *pend = src + max_chars;
+
+	      while (p < pend
+		     && (iso_2022_code_class[*p] == ISO_graphic_plane_0
+			 || iso_2022_code_class[*p] == ISO_control_0
+			 || iso_2022_code_class[*p] == ISO_0x20_or_0x7F))
+		p++;
+	      if (p > src)
+		{
+		  int n = p - src;
+
+		  if (dst + n + 1 > dst_end)
+		    {
+		      int len = dst - mt->data;
+
+		      mtext__enlarge (mt, mt->allocated + n + (src_end - p));
+		      dst = mt->data + len;
+		      dst_end = mt->data + mt->allocated;
+		    }
+		  memcpy (dst, src, n);
+		  dst += n;
+		  nchars += n;
+		  src = p;
+		}
+	    }
+	  else if ((this_charset = (c1 >= 0x21 && c1 <= 0x7E ? charset0
+				    : c1 >= 0xA1 && c1 <= 0xFE ? charset1
+				    : NULL))
+		   && this_charset != mcharset__ascii
+		   && this_charset->dimension <= 2)
+	    {
+	      int dim = this_charset->dimension;
+	      int lo = (c1 & 0x80) | 0x21, hi = (c1 & 0x80) | 0x7E;
+	      int mask = (dim == 1 && this_charset->code_range[1] <= 128
+			  ? 0x7F : 0xFF);
+	      /* A loaded charset of the map method (e.g. JIS X 0208) is
+		 not simple, and DECODE_CHAR calls mcharset__decode_char
+		 () for each character.  Look up its decoder directly.  */
+	      int *decoder = (! this_charset->simple
+			      && this_charset->method == Mmap
+			      && this_charset->fully_loaded
+			      && ! this_charset->ascii_compatible
+			      ? this_charset->decoder : NULL);
+
+	      for (; max_chars > 0 && src_end - src >= dim; max_chars--)
+		{
+		  unsigned code = src[0];
+
+		  if (code < lo || code > hi)
+		    break;
+		  if (dim == 1)
+		    code &= mask;
+		  else
+		    {
+		      if (src[1] < lo || src[1] > hi)
+			break;
+		      code = ((code & 0x7F) << 8) | (src[1] & 0x7F);
+		    }
+		  if (decoder)
+		    {
+		      int idx = (code < this_charset->min_code
+				 || code > this_charset->max_code
+				 ? -1 : CODE_POINT_TO_INDEX (this_charset, code));
+
+		      c1 = idx < 0 ? -1 : decoder[idx];
+		    }
+		  else
+		    c1 = DECODE_CHAR (this_charset, code);
+		  if (c1 < 0)
+		    break;
+		  if (this_charset != charset)
+		    {
+		      TAKEIN_CHARS (mt, nchars - last_nchars,
+				    dst - (mt->data + mt->nbytes), charset);
+		      charset = this_charset;
+		      last_nchars = nchars;
+		    }
+		  src += dim;
+		  EMIT_CHAR (c1);
+		}
+	    }
+	  this_charset = NULL;
+	}
+
       ONE_MORE_BASE_BYTE (c1);
 
       if (status->utf8_shifting)
@@ -2628,27 +2968,28 @@ encode_coding_iso_2022 (MText *mt, int from, int to,
       | (c2 + 0x7E)))
 
 
+static int
+setup_coding_sjis (MCodingSystem *coding)
+{
+  MSymbol kanji_sym = msymbol ("jisx0208.1983");
+  MCharset *kanji = MCHARSET (kanji_sym);
+  MSymbol kana_sym = msymbol ("jisx0201-kana");
+  MCharset *kana = MCHARSET (kana_sym);
+
+  if (! kanji || ! kana)
+    return -1;
+  coding->ncharsets = 3;
+  coding->charsets[1] = kanji;
+  coding->charsets[2] = kana;
+  return 0;
+}
+
 static int
 reset_coding_sjis (MConverter *converter)
 {
   MConverterStatus *internal = (MConverterStatus *) converter->internal_info;
-  MCodingSystem *coding = internal->coding;
 
-  if (! coding->ready)
-    {
-      MSymbol kanji_sym = msymbol ("jisx0208.1983");
-      MCharset *kanji = MCHARSET (kanji_sym);
-      MSymbol kana_sym = msymbol ("jisx0201-kana");
-      MCharset *kana = MCHARSET (kana_sym);
-
-      if (! kanji || ! kana)
-	return -1;
-      coding->ncharsets = 3;
-      coding->charsets[1] = kanji;
-      coding->charsets[2] = kana;
-    }
-  coding->ready = 1;
-  return 0;
+  return setup_coding (internal->coding, setup_coding_sjis);
 }
 
 static int
@@ -2848,6 +3189,110 @@ find_coding (MSymbol name)
 
 #define CONVERT_WORKSIZE 0x10000
 
+#ifdef M17N_THREAD_SAFE
+
+/* Minimum number of bytes decoded by one thread of
+   mconv_decode_parallel ().  */
+#define PARALLEL_DECODE_MIN_BYTES 0x40000
+
+/* Maximum number of threads used by mconv_decode_parallel ().  */
+#define PARALLEL_DECODE_MAX_THREADS 64
+
+/* Range of a source buffer decoded by one thread.  */
+
+typedef struct
+{
+  MConverter *converter;
+  MText *mt;
+  int from, to;
+  int threaded;
+  pthread_t thread;
+} MDecodeChunk;
+
+static void *
+decode_chunk (void *arg)
+{
+  MDecodeChunk *chunk = arg;
+
+  mconv_decode (chunk->converter, chunk->mt);
+  return NULL;
+}
+
+/* Return 1 if the source of CONVERTER can be split into pieces that
+   are decoded independently, 0 otherwise.  */
+
+static int
+decode_splittable_p (MConverter *converter)
+{
+  MConverterStatus *internal = (MConverterStatus *) converter->internal_info;
+  MCodingSystem *coding = internal->coding;
+
+  if (coding->type == Mcharset)
+    {
+      int i;
+
+      /* Each byte is decoded into one character.  */
+      for (i = 0; i < coding->ncharsets; i++)
+	if (coding->charsets[i]->dimension != 1)
+	  return 0;
+      /* mcharset__decode_char () loads a charset lazily, which must
+	 not happen in several threads at once.  */
+      for (i = 0; i < coding->ncharsets; i++)
+	if (mcharset__load_fully (coding->charsets[i]) < 0)
+	  return 0;
+      return 1;
+    }
+  if (coding->type == Mutf)
+    {
+      MCodingInfoUTF *spec = (MCodingInfoUTF *) coding->extra_spec;
+      struct utf_status *status = (struct utf_status *) &(converter->status);
+
+      if (spec->code_unit_bits == 8)
+	return 1;
+      /* In lenient mode, an invalid code unit shifts the boundaries
+	 of the following units by one byte.  The endian is not known
+	 until a BOM is checked.  */
+      return (! converter->lenient && status->bom == UTF_BOM_NO);
+    }
+  return 0;
+}
+
+/* Return the smallest position not less than POS in BUF (N bytes) at
+   which decoding by CONVERTER can be split, or N if there's no such
+   position.  */
+
+static int
+decode_split_position (MConverter *converter, const unsigned char *buf,
+		       int n, int pos)
+{
+  MConverterStatus *internal = (MConverterStatus *) converter->internal_info;
+  MCodingSystem *coding = internal->coding;
+
+  if (coding->type == Mutf)
+    {
+      MCodingInfoUTF *spec = (MCodingInfoUTF *) coding->extra_spec;
+      struct utf_status *status = (struct utf_status *) &(converter->status);
+
+      if (spec->code_unit_bits == 8)
+	/* Don't split before a continuation byte.  */
+	while (pos < n && (buf[pos] & 0xC0) == 0x80)
+	  pos++;
+      else if (spec->code_unit_bits == 16)
+	{
+	  int hi = status->endian == UTF_BIG_ENDIAN ? 0 : 1;
+
+	  /* Don't split after a high surrogate.  */
+	  for (pos = (pos + 1) & ~1;
+	       pos < n && (buf[pos - 2 + hi] & 0xFC) == 0xD8; pos += 2);
+	}
+      else
+	pos = (pos + 3) & ~3;
+    }
+  return (pos < n ? pos : n);
+}
+
+#endif /* M17N_THREAD_SAFE */
+
 
 /* Internal API */
 
@@ -3010,6 +3455,8 @@ mcoding__fini (void)
 	    free (((struct iso_2022_spec *) coding->extra_spec)->designations);
 	  free (coding->extra_spec);
 	}
+      if (coding->encode_table)
+	free (coding->encode_table);
       free (coding);
     }
   MLIST_FREE1 (&coding_list, codings);
@@ -3827,6 +4274,7 @@ mconv_define_coding (const char *name, MPlist *plist,
   coding->extra_info = extra_info;
   coding->extra_spec = NULL;
   coding->ready = 0;
+  coding->encode_table = NULL;
 
   if (coding->type == Mcharset)
     {
@@ -4515,6 +4963,176 @@ mconv_decode (MConverter *converter, MText *mt)
 
 /*=*/
 
+/***en
+    @brief Decode a byte sequence using multiple threads.
+
+    The mconv_decode_parallel () function is like mconv_decode () but
+    may split the byte sequence into pieces and decode them
+    concurrently by at most $NTHREADS threads.  If $NTHREADS is zero
+    or negative, the number of online processors is used.  The
+    resulting M-text, the members of $CONVERTER, and the return value
+    are the same as those of mconv_decode ().
+
+    The byte sequence is split only if it is large enough, $CONVERTER
+    is bound to a buffer area, the @c at_most member of $CONVERTER
+    is zero, and the coding system is one of these:
+
+    - UTF-8
+    - UTF-16 and UTF-32 without a BOM, if the @c lenient member of
+      $CONVERTER is zero
+    - Coding systems of type #MCODING_TYPE_CHARSET whose charsets
+      are all of dimension 1
+
+    Otherwise, and if the m17n library is not compiled with the macro
+    @c M17N_THREAD_SAFE defined, this function just calls
+    mconv_decode ().
+
+    @return
+    If the operation was successful, mconv_decode_parallel () returns
+    updated $MT.  Otherwise it returns @c NULL and assigns an error
+    code to the external variable #merror_code.  */
+
+/***ja
+    @brief ʣΥåɤѤƥХǥɤ.
+
+    ؿ mconv_decode_parallel ()  mconv_decode () ƱͤǤ뤬
+    Хʬ䤷 $NTHREADS ĤΥåɤ¹Ԥƥǥɤ뤳Ȥ롣
+    $NTHREADS  0 ʲʤСƯΥץåѤ롣
+     M-text$CONVERTER ΥСͤ mconv_decode () 
+    ΤΤƱǤ롣
+
+    Хʬ䤵Τϡ줬ʬ礭$CONVERTER 
+    Хåեΰ˷դƤꡢ$CONVERTER Υ @c at_most 
+     0 ǤꡢĥɷϤʲΤ줫ξ˸¤롣
+
+    - UTF-8
+    - BOM ʤ UTF-16  UTF-32 $CONVERTER Υ @c lenient 
+       0 ξ
+    - ٤ƤʸåȤμ 1 Ǥ #MCODING_TYPE_CHARSET 
+      פΥɷ
+
+    ʳξ硢 m17n 饤֥꤬ޥ @c M17N_THREAD_SAFE 
+    ƥѥ뤵Ƥʤˤϡδؿñ mconv_decode () 
+    Ƥ֡
+
+    @return
+    Сmconv_decode_parallel () Ϲ줿 $MT ֤
+    Ǥʤ @c NULL ֤ѿ #merror_code 
+    ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_IO, @c MERROR_CODING
+
+    @seealso
+    mconv_decode (), mconv_decode_buffer ()  */
+
+MText *
+mconv_decode_parallel (MConverter *converter, MText *mt, int nthreads)
+{
+#ifdef M17N_THREAD_SAFE
+  MConverterStatus *internal = (MConverterStatus *) converter->internal_info;
+  MDecodeChunk chunks[PARALLEL_DECODE_MAX_THREADS];
+  const unsigned char *buf;
+  int n, nchunks, i;
+  int nchars = 0, nbytes = 0;
+  MText *result = mt;
+
+  if (internal->binding != BINDING_BUFFER
+      || converter->at_most > 0
+      || internal->carryover_bytes > 0
+      || mtext_nchars (internal->unread) > 0
+      || ! decode_splittable_p (converter))
+    return mconv_decode (converter, mt);
+
+  M_CHECK_READONLY (mt, NULL);
+  if (nthreads <= 0)
+    nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+  if (nthreads > PARALLEL_DECODE_MAX_THREADS)
+    nthreads = PARALLEL_DECODE_MAX_THREADS;
+  buf = internal->buf.in + internal->used;
+  n = internal->bufsize - internal->used;
+  if (nthreads > n / PARALLEL_DECODE_MIN_BYTES)
+    nthreads = n / PARALLEL_DECODE_MIN_BYTES;
+  if (nthreads < 2)
+    return mconv_decode (converter, mt);
+
+  if (mt->format != MTEXT_FORMAT_UTF_8)
+    mtext__adjust_format (mt, MTEXT_FORMAT_UTF_8);
+
+  /* Decode the last chunk by CONVERTER itself in this thread, and the
+     others by temporary converters in new threads.  */
+  for (nchunks = 0, i = 0; i < n; nchunks++)
+    {
+      MDecodeChunk *chunk = chunks + nchunks;
+
+      chunk->from = i;
+      if (nchunks + 1 < nthreads)
+	i = decode_split_position (converter, buf, n,
+				   (long long) n * (nchunks + 1) / nthreads);
+      else
+	i = n;
+      chunk->to = i;
+      chunk->mt = mtext ();
+      if (i < n)
+	{
+	  chunk->converter = mconv_buffer_converter (internal->coding->name,
+						     buf + chunk->from,
+						     chunk->to - chunk->from);
+	  chunk->converter->lenient = converter->lenient;
+	  chunk->converter->last_block = 1;
+	  chunk->converter->status = converter->status;
+	  chunk->threaded = (pthread_create (&chunk->thread, NULL,
+					     decode_chunk, chunk) == 0);
+	  if (! chunk->threaded)
+	    decode_chunk (chunk);
+	}
+      else
+	{
+	  chunk->converter = converter;
+	  chunk->threaded = 0;
+	  internal->used += chunk->from;
+	  decode_chunk (chunk);
+	}
+    }
+
+  for (i = 0; i < nchunks; i++)
+    {
+      MDecodeChunk *chunk = chunks + i;
+
+      if (chunk->threaded)
+	pthread_join (chunk->thread, NULL);
+      if (result)
+	{
+	  mtext_cat (mt, chunk->mt);
+	  nchars += chunk->converter->nchars;
+	  nbytes += chunk->converter->nbytes;
+	  if (chunk->converter->result == MCONVERSION_RESULT_INVALID_BYTE)
+	    {
+	      /* Make CONVERTER look as if it has stopped here.  The
+		 last chunk may have been decoded by CONVERTER itself,
+		 so its result and status are those of this chunk.  */
+	      converter->result = chunk->converter->result;
+	      converter->status = chunk->converter->status;
+	      internal->used = (buf - internal->buf.in) + nbytes;
+	      internal->carryover_bytes = 0;
+	      result = NULL;
+	    }
+	}
+      if (chunk->converter != converter)
+	mconv_free_converter (chunk->converter);
+      M17N_OBJECT_UNREF (chunk->mt);
+    }
+  converter->nchars = nchars;
+  converter->nbytes = nbytes;
+  return result;
+#else  /* not M17N_THREAD_SAFE */
+  return mconv_decode (converter, mt);
+#endif	/* not M17N_THREAD_SAFE */
+}
+
+/*=*/
+
 /***en
     @brief Decode a buffer area based on a coding system.
 
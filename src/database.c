@@ -135,12 +135,16 @@
 #include <glob.h>
 #include <time.h>
 #include <libgen.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "m17n-core.h"
 #include "m17n-misc.h"
 #include "internal.h"
 #include "mtext.h"
 #include "character.h"
+#include "symbol.h"
 #include "database.h"
 #include "plist.h"
 
@@ -344,6 +348,556 @@ load_chartable (FILE *fp, MSymbol type)
   MERROR (MERROR_DB, NULL);
 }
 
+/* Compiled cache of a database.
+
+   A database of type chartable or plist can be compiled into a cache
+   file named ".FILE.mdbc" in the same directory as the source file
+   FILE.  The cache consists of an MDBCacheHeader followed by an array
+   of ints, and is used instead of FILE only while the version of the
+   library and the modification time and size of FILE are the same as
+   those recorded in the header, and the checksum of the ints
+   matches.
+
+   An element (a value of a chartable or an element of a plist) is
+   encoded as one of these:
+	MDB_CACHE_SYMBOL NBYTES BYTES...
+	MDB_CACHE_INTEGER VALUE
+	MDB_CACHE_MTEXT NBYTES BYTES...
+	MDB_CACHE_STRING NBYTES BYTES...
+	MDB_CACHE_PLIST ELEMENT ... MDB_CACHE_END
+	MDB_CACHE_NULL
+   where BYTES are padded to a multiple of sizeof (int).  The body of
+   a plist database is the elements of the plist followed by
+   MDB_CACHE_END.  The body of a chartable database is a sequence of
+   FROM TO ELEMENT terminated by -1.
+
+   Other modules can keep their own compiled data of a database in a
+   cache file of another suffix by mdatabase__save_cache () and
+   mdatabase__load_cache ().  The header of such a file is the same,
+   and the ints following it are up to the module.  As the module may
+   read only a part of the ints, their checksum is not verified on
+   loading, and the module must check the bounds by itself.  */
+
+#define MDB_CACHE_MAGIC "M17NDBC"
+#define MDB_CACHE_FORMAT 1
+#define MDB_CACHE_SUFFIX ".mdbc"
+
+enum MDBCacheTag
+  {
+    MDB_CACHE_END,
+    MDB_CACHE_SYMBOL,
+    MDB_CACHE_INTEGER,
+    MDB_CACHE_MTEXT,
+    MDB_CACHE_STRING,
+    MDB_CACHE_PLIST,
+    MDB_CACHE_NULL
+  };
+
+typedef struct
+{
+  char magic[8];
+  /* MDB_CACHE_FORMAT + sizeof (void *) * 0x100.  It also detects a
+     file created on a machine of different byte order.  */
+  int format;
+  char version[16];
+  /* Tags of the database; the names of tag[0] and tag[1].  */
+  char tag0[32], tag1[32];
+  /* Modification time and size of the source file.  */
+  long long mtime, size;
+  int mtime_nsec;
+  /* Number of ints following the header, and their checksum.  */
+  int length;
+  unsigned checksum;
+} MDBCacheHeader;
+
+/* Store the name of the cache file of FILENAME with SUFFIX in
+   CACHE_FILE (at least PATH_MAX + 1 bytes), and return CACHE_FILE.
+   If the name is too long, return NULL.  */
+
+static char *
+cache_file_name (char *filename, char *suffix, char *cache_file)
+{
+  char *base = strrchr (filename, PATH_SEPARATOR);
+  int dir_len = base ? base + 1 - filename : 0;
+
+  if (strlen (filename) + 1 + strlen (suffix) > PATH_MAX)
+    return NULL;
+  memcpy (cache_file, filename, dir_len);
+  sprintf (cache_file + dir_len, ".%s%s", filename + dir_len, suffix);
+  return cache_file;
+}
+
+/* Append NBYTES bytes at DATA to BUF padding them to a multiple of
+   sizeof (int).  */
+
+int
+mdatabase__cache_put_words (MDBCacheBuffer *buf, const void *data,
+			    int nbytes)
+{
+  int nwords = (nbytes + sizeof (int) - 1) / sizeof (int);
+
+  if (nwords == 0)
+    return 0;
+  if (buf->used + nwords > buf->size)
+    {
+      buf->size = (buf->used + nwords) * 2;
+      MTABLE_REALLOC (buf->words, buf->size, MERROR_DB);
+    }
+  buf->words[buf->used + nwords - 1] = 0;
+  memcpy (buf->words + buf->used, data, nbytes);
+  buf->used += nwords;
+  return 0;
+}
+
+#define CACHE_PUT(buf, n)				\
+  do {							\
+    int word = (n);					\
+    mdatabase__cache_put_words ((buf), &word, sizeof (int));	\
+  } while (0)
+
+#define CACHE_PUT_BYTES(buf, tag, data, nbytes)	\
+  do {						\
+    CACHE_PUT ((buf), (tag));			\
+    CACHE_PUT ((buf), (nbytes));		\
+    mdatabase__cache_put_words ((buf), (data), (nbytes));	\
+  } while (0)
+
+/* Encode an element whose key is KEY and value is VAL into BUF.
+   Return 0 on success, -1 if the element can't be encoded.  */
+
+int
+mdatabase__cache_put_element (MDBCacheBuffer *buf, MSymbol key, void *val)
+{
+  if (key == Msymbol)
+    {
+      MSymbol sym = (MSymbol) val;
+
+      if (sym == Mnil)
+	CACHE_PUT_BYTES (buf, MDB_CACHE_SYMBOL, "nil", 4);
+      else
+	CACHE_PUT_BYTES (buf, MDB_CACHE_SYMBOL, MSYMBOL_NAME (sym),
+			 MSYMBOL_NAMELEN (sym) + 1);
+    }
+  else if (key == Minteger)
+    {
+      CACHE_PUT (buf, MDB_CACHE_INTEGER);
+      CACHE_PUT (buf, (int) (long) val);
+    }
+  else if (key == Mtext)
+    {
+      MText *mt = (MText *) val;
+
+      if (! mt || mt->format > MTEXT_FORMAT_UTF_8 || mt->plist)
+	return -1;
+      CACHE_PUT_BYTES (buf, MDB_CACHE_MTEXT, mt->data, mt->nbytes);
+    }
+  else if (key == Mstring && val)
+    CACHE_PUT_BYTES (buf, MDB_CACHE_STRING, val, strlen (val) + 1);
+  else if (key == Mplist)
+    {
+      MPlist *plist;
+
+      if (! val)
+	return -1;
+      CACHE_PUT (buf, MDB_CACHE_PLIST);
+      MPLIST_DO (plist, (MPlist *) val)
+	if (mdatabase__cache_put_element (buf, MPLIST_KEY (plist),
+					  MPLIST_VAL (plist)) < 0)
+	  return -1;
+      CACHE_PUT (buf, MDB_CACHE_END);
+    }
+  else if (key == Mnil && ! val)
+    CACHE_PUT (buf, MDB_CACHE_NULL);
+  else
+    return -1;
+  return 0;
+}
+
+typedef struct
+{
+  MDBCacheBuffer *buf;
+  MSymbol type;
+  int error;
+} MDBCacheMapArg;
+
+static void
+cache_put_range (int from, int to, void *val, void *arg)
+{
+  MDBCacheMapArg *map_arg = arg;
+
+  CACHE_PUT (map_arg->buf, from);
+  CACHE_PUT (map_arg->buf, to);
+  if (mdatabase__cache_put_element (map_arg->buf,
+				    val ? map_arg->type : Mnil, val) < 0)
+    map_arg->error = 1;
+}
+
+/* Append an element of KEY and VAL to PLIST, and set PLIST to the
+   appended element.  The reference of VAL is passed to PLIST.  */
+
+#define CACHE_ADD_ELEMENT(plist, key, val)		\
+  do {							\
+    (plist) = mplist_add ((plist), (key), (val));	\
+    if ((key)->managing_key)				\
+      M17N_OBJECT_UNREF (val);				\
+  } while (0)
+
+/* Decode an element from the ints at *P (before END), and store its
+   key and value in *KEY and *VAL.  Update *P to point the next
+   element.  Return 0 on success, -1 if the ints are broken.  */
+
+int
+mdatabase__cache_get_element (const int **p, const int *end, MSymbol *key,
+			      void **val)
+{
+  const int *q = *p;
+  int nbytes = 0, nwords = 0;
+
+  if (q >= end)
+    return -1;
+  if (*q == MDB_CACHE_SYMBOL || *q == MDB_CACHE_MTEXT
+      || *q == MDB_CACHE_STRING)
+    {
+      if (end - q < 2 || (nbytes = q[1]) < 0)
+	return -1;
+      nwords = nbytes / sizeof (int) + (nbytes % sizeof (int) != 0);
+      if (nwords > end - q - 2)
+	return -1;
+    }
+  switch (*q)
+    {
+    case MDB_CACHE_SYMBOL:
+      *key = Msymbol;
+      *val = msymbol__with_len ((char *) (q + 2), nbytes);
+      q += 2 + nwords;
+      break;
+
+    case MDB_CACHE_INTEGER:
+      if (end - q < 2)
+	return -1;
+      *key = Minteger;
+      *val = (void *) (long) q[1];
+      q += 2;
+      break;
+
+    case MDB_CACHE_MTEXT:
+      *key = Mtext;
+      *val = mtext__from_data (q + 2, nbytes, MTEXT_FORMAT_UTF_8, 1);
+      if (! *val)
+	return -1;
+      q += 2 + nwords;
+      break;
+
+    case MDB_CACHE_STRING:
+      if (nbytes == 0 || ((char *) (q + 2))[nbytes - 1])
+	return -1;
+      *key = Mstring;
+      *val = strdup ((char *) (q + 2));
+      if (! *val)
+	MEMORY_FULL (MERROR_DB);
+      q += 2 + nwords;
+      break;
+
+    case MDB_CACHE_PLIST:
+      {
+	MPlist *plist, *pl;
+	MSymbol elt_key;
+	void *elt;
+
+	plist = pl = mplist ();
+	for (q++; q < end && *q != MDB_CACHE_END;)
+	  {
+	    if (mdatabase__cache_get_element (&q, end, &elt_key, &elt) < 0
+		|| elt_key == Mnil)
+	      {
+		M17N_OBJECT_UNREF (plist);
+		return -1;
+	      }
+	    CACHE_ADD_ELEMENT (pl, elt_key, elt);
+	  }
+	if (q == end)
+	  {
+	    M17N_OBJECT_UNREF (plist);
+	    return -1;
+	  }
+	*key = Mplist;
+	*val = plist;
+	q++;
+      }
+      break;
+
+    case MDB_CACHE_NULL:
+      *key = Mnil;
+      *val = NULL;
+      q++;
+      break;
+
+    default:
+      return -1;
+    }
+  *p = q;
+  return 0;
+}
+
+static void
+cache_fill_header (MDBCacheHeader *header, MSymbol *tags, struct stat *st)
+{
+  memset (header, 0, sizeof (MDBCacheHeader));
+  strcpy (header->magic, MDB_CACHE_MAGIC);
+  header->format = MDB_CACHE_FORMAT + sizeof (void *) * 0x100;
+  strncpy (header->version, M17NLIB_VERSION_NAME,
+	   sizeof header->version - 1);
+  strncpy (header->tag0, msymbol_name (tags[0]), sizeof header->tag0 - 1);
+  strncpy (header->tag1, msymbol_name (tags[1]), sizeof header->tag1 - 1);
+  header->mtime = st->st_mtime;
+#ifdef st_mtime
+  /* st_mtime is a macro if struct stat has nanoseconds in st_mtim.  */
+  header->mtime_nsec = st->st_mtim.tv_nsec;
+#endif
+  header->size = st->st_size;
+}
+
+static unsigned
+cache_checksum (const int *words, int length)
+{
+  unsigned sum = 2166136261u;
+  int i;
+
+  for (i = 0; i < length; i++)
+    sum = (sum ^ (unsigned) words[i]) * 16777619u;
+  return sum;
+}
+
+/* Map the cache file CACHE_FILE of the database of TAGS whose source
+   file status is ST into memory, and return a pointer to the ints
+   following the header.  Store the number of the ints in *LENGTH.
+   If VERIFY is nonzero, verify also the checksum of the ints.  Return
+   NULL if CACHE_FILE is not a valid cache.  */
+
+static const int *
+map_cache_file (char *cache_file, MSymbol *tags, struct stat *st,
+		int *length, int verify)
+{
+  MDBCacheHeader header, *cache_header;
+  struct stat cache_st;
+  char *data;
+  const int *p;
+  FILE *fp;
+
+  if (stat (cache_file, &cache_st) < 0
+      || cache_st.st_size < sizeof (MDBCacheHeader)
+      || ! (fp = fopen (cache_file, "r")))
+    return NULL;
+#ifdef HAVE_MMAP
+  data = mmap (NULL, cache_st.st_size, PROT_READ, MAP_PRIVATE,
+	       fileno (fp), 0);
+  if (data == MAP_FAILED)
+    data = NULL;
+#else  /* not HAVE_MMAP */
+  data = malloc (cache_st.st_size);
+  if (data && fread (data, 1, cache_st.st_size, fp) != cache_st.st_size)
+    {
+      free (data);
+      data = NULL;
+    }
+#endif	/* not HAVE_MMAP */
+  fclose (fp);
+  if (! data)
+    return NULL;
+
+  cache_fill_header (&header, tags, st);
+  cache_header = (MDBCacheHeader *) data;
+  header.length = cache_header->length;
+  header.checksum = cache_header->checksum;
+  p = (const int *) (cache_header + 1);
+  if (memcmp (&header, cache_header, sizeof (MDBCacheHeader)) == 0
+      && (cache_st.st_size - sizeof (MDBCacheHeader)) / sizeof (int)
+	  == header.length
+      && (! verify || cache_checksum (p, header.length) == header.checksum))
+    {
+      *length = header.length;
+      return p;
+    }
+#ifdef HAVE_MMAP
+  munmap (data, cache_st.st_size);
+#else
+  free (data);
+#endif
+  return NULL;
+}
+
+/* Release WORDS of LENGTH returned by map_cache_file ().  */
+
+static void
+unmap_cache_file (const int *words, int length)
+{
+  char *data = (char *) words - sizeof (MDBCacheHeader);
+
+#ifdef HAVE_MMAP
+  munmap (data, sizeof (MDBCacheHeader) + sizeof (int) * length);
+#else
+  free (data);
+#endif
+}
+
+/* Write the ints in BUF into the cache file CACHE_FILE of the
+   database of TAGS whose source file status is ST.  Return 0 on
+   success, -1 on failure.  */
+
+static int
+write_cache_file (char *cache_file, MSymbol *tags, struct stat *st,
+		  MDBCacheBuffer *buf)
+{
+  char tmp_file[PATH_MAX + 32];
+  MDBCacheHeader header;
+  FILE *fp;
+  int result = -1;
+
+  if (strlen (cache_file) + 20 > PATH_MAX)
+    return -1;
+  cache_fill_header (&header, tags, st);
+  header.length = buf->used;
+  header.checksum = cache_checksum (buf->words, buf->used);
+  sprintf (tmp_file, "%s.%X", cache_file, (unsigned) getpid ());
+  fp = fopen (tmp_file, "w");
+  if (! fp)
+    return -1;
+  if (fwrite (&header, sizeof header, 1, fp) == 1
+      && fwrite (buf->words, sizeof (int), buf->used, fp) == buf->used)
+    result = 0;
+  if (fclose (fp) != 0)
+    result = -1;
+  if (result == 0)
+    result = rename (tmp_file, cache_file);
+  if (result < 0)
+    unlink (tmp_file);
+  return result;
+}
+
+/* Load the database of TAGS from the cache file of FILENAME whose
+   status is ST.  Return NULL if there's no valid cache.  */
+
+static void *
+load_database_cache (MSymbol *tags, char *filename, struct stat *st)
+{
+  char cache_file[PATH_MAX + 1];
+  void *value = NULL;
+  const int *words, *p, *end;
+  int length;
+  MSymbol key;
+
+  if (! cache_file_name (filename, MDB_CACHE_SUFFIX, cache_file)
+      || ! (words = map_cache_file (cache_file, tags, st, &length, 1)))
+    return NULL;
+  p = words;
+  end = p + length;
+  if (tags[0] == Mchar_table)
+    {
+      MSymbol type = tags[1];
+      MCharTable *table
+	= mchartable (type, (type == Msymbol ? (void *) Mnil
+			     : type == Minteger ? (void *) -1
+			     : NULL));
+
+      while (p + 2 < end && *p >= 0)
+	{
+	  int from = p[0], to = p[1];
+	  void *val;
+
+	  p += 2;
+	  if (mdatabase__cache_get_element (&p, end, &key, &val) < 0)
+	    {
+	      p = end;
+	      break;
+	    }
+	  if (from == to)
+	    mchartable_set (table, from, val);
+	  else
+	    mchartable_set_range (table, from, to, val);
+	  if (key == Mtext || key == Mplist)
+	    M17N_OBJECT_UNREF (val);
+	}
+      if (p < end && *p < 0)
+	value = table;
+      else
+	M17N_OBJECT_UNREF (table);
+    }
+  else
+    {
+      MPlist *plist, *pl;
+
+      plist = pl = mplist ();
+      while (p < end && *p != MDB_CACHE_END)
+	{
+	  void *val;
+
+	  if (mdatabase__cache_get_element (&p, end, &key, &val) < 0
+	      || key == Mnil)
+	    {
+	      p = end;
+	      break;
+	    }
+	  CACHE_ADD_ELEMENT (pl, key, val);
+	}
+      if (p < end)
+	value = plist;
+      else
+	M17N_OBJECT_UNREF (plist);
+    }
+  unmap_cache_file (words, length);
+  return value;
+}
+
+/* Compile the database of TAGS in FILENAME whose status is ST, and
+   write it in the cache file of FILENAME.  VALUE is the data of the
+   database.  Return 0 on success, -1 on failure.  */
+
+static int
+save_database_cache (MSymbol *tags, char *filename, struct stat *st,
+		     void *value)
+{
+  char cache_file[PATH_MAX + 1];
+  MDBCacheBuffer buf;
+  int result = -1;
+
+  if (! cache_file_name (filename, MDB_CACHE_SUFFIX, cache_file))
+    return -1;
+  buf.words = NULL;
+  buf.used = buf.size = 0;
+  if (tags[0] == Mchar_table)
+    {
+      MSymbol type = tags[1];
+      MDBCacheMapArg arg;
+
+      arg.buf = &buf;
+      arg.type = type;
+      arg.error = 0;
+      mchartable_map ((MCharTable *) value,
+		      (type == Msymbol ? (void *) Mnil
+		       : type == Minteger ? (void *) -1
+		       : NULL),
+		      cache_put_range, &arg);
+      if (arg.error)
+	goto finish;
+      CACHE_PUT (&buf, -1);
+    }
+  else
+    {
+      MPlist *plist;
+
+      MPLIST_DO (plist, (MPlist *) value)
+	if (mdatabase__cache_put_element (&buf, MPLIST_KEY (plist),
+					  MPLIST_VAL (plist)) < 0)
+	  goto finish;
+      CACHE_PUT (&buf, MDB_CACHE_END);
+    }
+  result = write_cache_file (cache_file, tags, st, &buf);
+
+ finish:
+  free (buf.words);
+  return result;
+}
+
 
 static char *
 gen_database_name (char *buf, MSymbol *tags)
@@ -405,12 +959,21 @@ load_database (MSymbol *tags, void *extra_info)
 {
   MDatabaseInfo *db_info = extra_info;
   void *value;
-  char *filename = get_database_file (db_info, NULL, NULL);
+  struct stat st;
+  int result;
+  char *filename = get_database_file (db_info, &st, &result);
   FILE *fp;
   int mdebug_flag = MDEBUG_DATABASE;
   char buf[256];
 
   MDEBUG_PRINT1 (" [DB] <%s>", gen_database_name (buf, tags));
+  if (filename && result == 0 && tags[0] != Mcharset
+      && (value = load_database_cache (tags, filename, &st)))
+    {
+      MDEBUG_PRINT1 (" from cache of %s\n", filename);
+      db_info->time = time (NULL);
+      return value;
+    }
   if (! filename || ! (fp = fopen (filename, "r")))
     {
       if (filename)
@@ -1049,6 +1612,67 @@ mdatabase__check (MDatabase *mdb)
   return 1;
 }
 
+/* Write the ints in BUF into the cache file of MDB whose name ends
+   with SUFFIX.  Return 0 on success, -1 on failure.  */
+
+int
+mdatabase__save_cache (MDatabase *mdb, char *suffix, MDBCacheBuffer *buf)
+{
+  MDatabaseInfo *db_info;
+  char cache_file[PATH_MAX + 1];
+  struct stat st;
+  int result;
+  char *filename;
+
+  if (mdb->loader != load_database)
+    return -1;
+  db_info = mdb->extra_info;
+  filename = get_database_file (db_info, &st, &result);
+  if (! filename || result < 0
+      || ! cache_file_name (filename, suffix, cache_file))
+    return -1;
+  return write_cache_file (cache_file, mdb->tag, &st, buf);
+}
+
+/* Map the cache file of MDB whose name ends with SUFFIX into memory,
+   and return a pointer to the ints saved by mdatabase__save_cache ().
+   Store the number of the ints in *LENGTH.  Return NULL if there's no
+   cache file valid for the current file of MDB.  The returned ints
+   must be released by mdatabase__free_cache ().
+
+   As the ints are the data of MDB, MDB is regarded as loaded now,
+   i.e. mdatabase__check () returns 1 until the file of MDB is
+   modified.  */
+
+const int *
+mdatabase__load_cache (MDatabase *mdb, char *suffix, int *length)
+{
+  MDatabaseInfo *db_info;
+  char cache_file[PATH_MAX + 1];
+  struct stat st;
+  int result;
+  char *filename;
+  const int *words;
+
+  if (mdb->loader != load_database)
+    return NULL;
+  db_info = mdb->extra_info;
+  filename = get_database_file (db_info, &st, &result);
+  if (! filename || result < 0
+      || ! cache_file_name (filename, suffix, cache_file))
+    return NULL;
+  words = map_cache_file (cache_file, mdb->tag, &st, length, 0);
+  if (words)
+    db_info->time = time (NULL);
+  return words;
+}
+
+void
+mdatabase__free_cache (const int *words, int length)
+{
+  unmap_cache_file (words, length);
+}
+
 /* Search directories in mdatabase__dir_list for file FILENAME.  If
    the file exist, return the absolute pathname.  If FILENAME is
    already absolute, return a copy of it.  */
@@ -1508,6 +2132,81 @@ mdatabase_load (MDatabase *mdb)
   return (*mdb->loader) (mdb->tag, mdb->extra_info);
 }
 
+/*=*/
+/***en
+    @brief Compile a data into a cache file.
+
+    The mdatabase_compile () function loads the data pointed to by
+    $MDB and writes it in a binary cache file named ".FILE.mdbc" in
+    the directory of the file FILE that contains the data.  After
+    that, mdatabase_load () reads the cache file instead of FILE as
+    long as FILE is not modified and the version of the m17n library
+    is not changed.
+
+    Only the data of the @e plist @e type and the @e chartable @e type
+    defined in "mdb.dir" files can be compiled.  If the cache file is
+    already up to date, this function does nothing.
+
+    @return
+    If the operation was successful, mdatabase_compile () returns 0.
+    Otherwise it returns -1 and assigns an error code to the external
+    variable #merror_code.  */
+
+/***ja
+    @brief ǡ򥭥åե˥ѥ뤹.
+
+    ؿ mdatabase_compile ()  $MDB ؤǡɤ
+    Υǡޤե FILE Ʊǥ쥯ȥˤ 
+    ".FILE.mdbc" Ȥ̾ΥХʥΥåե˽񤭽Ф
+    ʸ塢FILE ѹ줺 m17n 饤֥ΥСѤʤ¤ꡢ
+    mdatabase_load ()  FILE ˤΥåեɤࡣ
+
+    ѥǤΤ "mdb.dir" ե줿 @e plist 
+     @e chartable ΥǡǤ롣
+    åե뤬Ǥ˺ǿʤСδؿϲ⤷ʤ
+
+    @return
+     mdatabase_compile ()  0 ֤
+    Ǥʤ -1 ֤ѿ #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_DB
+
+    @seealso
+    mdatabase_load ()  */
+
+int
+mdatabase_compile (MDatabase *mdb)
+{
+  MDatabaseInfo *db_info;
+  struct stat st;
+  int result;
+  char *filename;
+  void *value;
+
+  if (mdb->loader != load_database || mdb->tag[0] == Mcharset)
+    MERROR (MERROR_DB, -1);
+  db_info = mdb->extra_info;
+  filename = get_database_file (db_info, &st, &result);
+  if (! filename || result < 0)
+    MERROR (MERROR_DB, -1);
+  value = load_database_cache (mdb->tag, filename, &st);
+  if (value)
+    {
+      M17N_OBJECT_UNREF (value);
+      return 0;
+    }
+  value = load_database (mdb->tag, db_info);
+  if (! value)
+    return -1;
+  result = save_database_cache (mdb->tag, filename, &st, value);
+  M17N_OBJECT_UNREF (value);
+  if (result < 0)
+    MERROR (MERROR_DB, -1);
+  return 0;
+}
+
 /*=*/
 /***en
     @brief Get tags of a data.
@@ -70,6 +70,14 @@ typedef struct
   MPlist *properties;
 } MDatabaseInfo;
 
+/* Buffer to encode data into a cache file.  */
+
+typedef struct
+{
+  int *words;
+  int used, size;
+} MDBCacheBuffer;
+
 extern MPlist *mdatabase__dir_list;
 
 extern void mdatabase__update (void);
@@ -90,6 +98,23 @@ extern int mdatabase__unlock (MDatabase *mdb);
 
 extern MPlist *mdatabase__props (MDatabase *mdb);
 
+extern int mdatabase__cache_put_words (MDBCacheBuffer *buf, const void *data,
+				       int nbytes);
+
+extern int mdatabase__cache_put_element (MDBCacheBuffer *buf, MSymbol key,
+					 void *val);
+
+extern int mdatabase__cache_get_element (const int **p, const int *end,
+					 MSymbol *key, void **val);
+
+extern int mdatabase__save_cache (MDatabase *mdb, char *suffix,
+				  MDBCacheBuffer *buf);
+
+extern const int *mdatabase__load_cache (MDatabase *mdb, char *suffix,
+					 int *length);
+
+extern void mdatabase__free_cache (const int *words, int length);
+
 extern void *(*mdatabase__load_charset_func) (FILE *fp, MSymbol charset_name);
 
 #endif /* not _M17N_DATABASE_H_ */
@@ -0,0 +1,425 @@
+/* device.c -- routines shared by image devices.
+   Copyright (C) 2026
+     National Institute of Advanced Industrial Science and Technology (AIST)
+     Registration Number H15PRO112
+
+   This file is part of the m17n library.
+
+   The m17n library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   The m17n library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the m17n library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301 USA.  */
+
+#if !defined (FOR_DOXYGEN) || defined (DOXYGEN_INTERNAL_MODULE)
+/*** @addtogroup m17nInternal
+     @{ */
+
+/* The devices that draw into an image by themselves (GD and raw)
+   share the routines in this file: color names, the colors of a
+   realized face, and regions represented by a plist of rectangles.
+   The only state here is the table of color names, which is built by
+   the first mdevice__init () and only read afterwards.  */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+#include "m17n-gui.h"
+#include "m17n-misc.h"
+#include "internal.h"
+#include "internal-gui.h"
+#include "symbol.h"
+#include "plist.h"
+#include "face.h"
+#include "device.h"
+
+/* Number of devices that have called mdevice__init () but not yet
+   mdevice__fini ().  */
+static int device_initialized;
+
+/* Property key of a color name symbol.  The value is 0xRRGGBB.  */
+static MSymbol M_rgb;
+
+static void
+read_rgb_txt ()
+{
+  FILE *fp;
+  int r, g, b, i;
+
+  /* At first, support HTML 4.0 color names. */
+  msymbol_put (msymbol ("black"), M_rgb, (void *) 0x000000);
+  msymbol_put (msymbol ("silver"), M_rgb, (void *) 0xC0C0C0);
+  msymbol_put (msymbol ("gray"), M_rgb, (void *) 0x808080);
+  msymbol_put (msymbol ("white"), M_rgb, (void *) 0xFFFFFF);
+  msymbol_put (msymbol ("maroon"), M_rgb, (void *) 0x800000);
+  msymbol_put (msymbol ("red"), M_rgb, (void *) 0xFF0000);
+  msymbol_put (msymbol ("purple"), M_rgb, (void *) 0x800080);
+  msymbol_put (msymbol ("fuchsia"), M_rgb, (void *) 0xFF00FF);
+  msymbol_put (msymbol ("green"), M_rgb, (void *) 0x008000);
+  msymbol_put (msymbol ("lime"), M_rgb, (void *) 0x00FF00);
+  msymbol_put (msymbol ("olive"), M_rgb, (void *) 0x808000);
+  msymbol_put (msymbol ("yellow"), M_rgb, (void *) 0xFFFF00);
+  msymbol_put (msymbol ("navy"), M_rgb, (void *) 0x000080);
+  msymbol_put (msymbol ("blue"), M_rgb, (void *) 0x0000FF);
+  msymbol_put (msymbol ("teal"), M_rgb, (void *) 0x008080);
+  msymbol_put (msymbol ("aqua"), M_rgb, (void *) 0x00FFFF);
+
+  {
+    char *rgb_path[]
+      =  {"/usr/lib/X11/rgb.txt", "/usr/X11R6/lib/X11/rgb.txt",
+	  "/etc/X11/rgb.txt", "/usr/share/X11/rgb.txt" };
+
+    fp = NULL;
+    for (i = 0; i < (sizeof rgb_path) / (sizeof rgb_path[0]); i++)
+      if ((fp = fopen (rgb_path[i], "r")))
+	break;
+    if (! fp)
+      return;
+  }
+  while (1)
+    {
+      char buf[256];
+      int c, len;
+
+      if ((c = getc (fp)) == EOF)
+	break;
+      if (c == '!')
+	{
+	  while ((c = getc (fp)) != EOF && c != '\n');
+	  continue;
+	}
+      ungetc (c, fp);
+      if (fscanf (fp, "%d %d %d", &r, &g, &b) != 3)
+	break;
+      while ((c = getc (fp)) != EOF && isspace (c));
+      if (c == EOF)
+	break;
+      buf[0] = c;
+      if (! fgets (buf + 1, 255, fp))
+	break;
+      len = strlen (buf);
+      for (i = 0; i < len; i++)
+	buf[i] = tolower (buf[i]);
+      if (buf[len - 1] == '\n')
+	buf[len - 1] = '\0';
+      b |= (r << 16) | (g << 8);
+      msymbol_put (msymbol (buf), M_rgb, (void *) b);
+    }
+  fclose (fp);
+}
+
+/* Parse one component of an "rgb:R/G/B" color spec at *NAME, store
+   the value scaled to 8 bits in *VALUE, and advance *NAME over it.
+   Return -1 if *NAME doesn't start with a hexadecimal digit.  */
+
+static int
+parse_rgb_component (char **name, unsigned *value)
+{
+  char *p = *name;
+  int i;
+
+  if (sscanf (p, "%x", value) < 1)
+    return -1;
+  for (i = 0; isxdigit ((unsigned char) *p); i++, p++);
+  if (i == 1)
+    *value = (*value << 4) | *value;
+  else if (i > 2)
+    *value >>= (i - 2) * 4;
+  *name = *p == '/' ? p + 1 : p;
+  return 0;
+}
+
+static int
+parse_color (MSymbol sym)
+{
+  char *name = MSYMBOL_NAME (sym);
+  unsigned r = 0x80, g = 0x80, b = 0x80;
+  int i;
+
+  do {
+    if (strncmp (name , "rgb:", 4) == 0)
+      {
+	name += 4;
+	if (parse_rgb_component (&name, &r) < 0
+	    || parse_rgb_component (&name, &g) < 0
+	    || parse_rgb_component (&name, &b) < 0)
+	  break;
+      }
+    else if (*name == '#')
+      {
+	name++;
+	i = strlen (name);
+	if (i == 3)
+	  {
+	    if (sscanf (name, "%1x%1x%1x", &r, &g, &b) < 3)
+	      break;
+	    r <<= 4, g <<= 4, b <<= 4;
+	  }
+	else if (i == 6)
+	  {
+	    if (sscanf (name, "%2x%2x%2x", &r, &g, &b) < 3)
+	      break;
+	  }
+	else if (i == 9)
+	  {
+	    if (sscanf (name, "%3x%3x%3x", &r, &g, &b) < 3)
+	      break;
+	    r >>= 4, g >>= 4, b >>= 4;
+	  }
+	else if (i == 12)
+	  {
+	    if (sscanf (name, "%4x%4x%4x", &r, &g, &b) < 3)
+	      break;
+	    r >>= 8, g >>= 8, b >>= 8;
+	  }
+      }
+    else
+      return (int) msymbol_get (sym, M_rgb);
+  } while (0);
+
+  return ((r << 16) | (g << 8) | b);
+}
+
+
+/* Internal API */
+
+int
+mdevice__init ()
+{
+  if (device_initialized++)
+    return 0;
+  M_rgb = msymbol ("  rgb");
+  read_rgb_txt ();
+  return 0;
+}
+
+void
+mdevice__fini ()
+{
+  if (device_initialized > 0)
+    device_initialized--;
+}
+
+/* Store the colors of RFACE in a newly allocated array indexed by
+   enum ColorIndex, and set RFACE->info to it.  A realized face for
+   non-ASCII characters shares the array of its ASCII face.  */
+
+void
+mdevice__realize_face (MRealizedFace *rface)
+{
+  int *colors;
+  MFaceHLineProp *hline;
+  MFaceBoxProp *box;
+  MSymbol *props = (MSymbol *) rface->face.property;
+
+  if (rface != rface->ascii_rface)
+    {
+      rface->info = rface->ascii_rface->info;
+      return;
+    }
+  MTABLE_MALLOC (colors, COLOR_MAX, MERROR_WIN);
+  colors[COLOR_NORMAL] = parse_color (props[MFACE_FOREGROUND]);
+  colors[COLOR_INVERSE] = parse_color (props[MFACE_BACKGROUND]);
+  if (rface->face.property[MFACE_VIDEOMODE] == Mreverse)
+    {
+      colors[COLOR_HLINE] = colors[COLOR_NORMAL];
+      colors[COLOR_NORMAL] = colors[COLOR_INVERSE];
+      colors[COLOR_INVERSE] = colors[COLOR_HLINE];
+    }
+  colors[COLOR_HLINE] = 0;
+
+  hline = rface->hline;
+  if (hline)
+    {
+      if (hline->color)
+	colors[COLOR_HLINE] = parse_color (hline->color);
+      else
+	colors[COLOR_HLINE] = colors[COLOR_NORMAL];
+    }
+
+  box = rface->box;
+  if (box)
+    {
+      if (box->color_top)
+	colors[COLOR_BOX_TOP] = parse_color (box->color_top);
+      else
+	colors[COLOR_BOX_TOP] = colors[COLOR_NORMAL];
+
+      if (box->color_left && box->color_left != box->color_top)
+	colors[COLOR_BOX_LEFT] = parse_color (box->color_left);
+      else
+	colors[COLOR_BOX_LEFT] = colors[COLOR_BOX_TOP];
+
+      if (box->color_bottom && box->color_bottom != box->color_top)
+	colors[COLOR_BOX_BOTTOM] = parse_color (box->color_bottom);
+      else
+	colors[COLOR_BOX_BOTTOM] = colors[COLOR_BOX_TOP];
+
+      if (box->color_right && box->color_right != box->color_bottom)
+	colors[COLOR_BOX_RIGHT] = parse_color (box->color_right);
+      else
+	colors[COLOR_BOX_RIGHT] = colors[COLOR_BOX_BOTTOM];
+    }
+
+  rface->info = colors;
+}
+
+void
+mdevice__free_realized_face (MRealizedFace *rface)
+{
+  if (rface == rface->ascii_rface)
+    free (rface->info);
+}
+
+/* Set RECT to the intersection of R1 and R2.  Return zero if they
+   don't intersect.  RECT may be the same as R1 or R2.  The edges are
+   compared as signed integers because glyphs may be drawn partially
+   outside of the image.  */
+
+int
+mdevice__intersect_rectangle (MDrawMetric *r1, MDrawMetric *r2,
+			      MDrawMetric *rect)
+{
+  int x0 = r1->x > r2->x ? r1->x : r2->x;
+  int y0 = r1->y > r2->y ? r1->y : r2->y;
+  int x1 = r1->x + (int) r1->width, y1 = r1->y + (int) r1->height;
+
+  if (x1 > r2->x + (int) r2->width)
+    x1 = r2->x + (int) r2->width;
+  if (y1 > r2->y + (int) r2->height)
+    y1 = r2->y + (int) r2->height;
+  if (x0 >= x1 || y0 >= y1)
+    return 0;
+  rect->x = x0, rect->y = y0;
+  rect->width = x1 - x0, rect->height = y1 - y0;
+  return 1;
+}
+
+MDrawRegion
+mdevice__region_from_rect (MDrawMetric *rect)
+{
+  MDrawMetric *new;
+  MPlist *plist = mplist ();
+
+  MSTRUCT_MALLOC (new, MERROR_WIN);
+  *new = *rect;
+  mplist_add (plist, Mt, new);
+  return (MDrawRegion) plist;
+}
+
+void
+mdevice__union_rect_with_region (MDrawRegion region, MDrawMetric *rect)
+{
+  MPlist *plist = (MPlist *) region;
+  MDrawMetric *r;
+
+  MSTRUCT_MALLOC (r, MERROR_WIN);
+  *r = *rect;
+  mplist_push (plist, Mt, r);
+}
+
+void
+mdevice__intersect_region (MDrawRegion region1, MDrawRegion region2)
+{
+  MPlist *plist1 = (MPlist *) region1, *p1 = plist1;
+  MPlist *plist2 = (MPlist *) region2;
+  MPlist *p2;
+  MDrawMetric rect, *rect1, *rect2, *r;
+
+  while (! MPLIST_TAIL_P (p1))
+    {
+      rect1 = mplist_pop (p1);
+      MPLIST_DO (p2, plist2)
+	{
+	  rect2 = MPLIST_VAL (p2);
+	  if (mdevice__intersect_rectangle (rect1, rect2, &rect))
+	    {
+	      MSTRUCT_MALLOC (r, MERROR_WIN);
+	      *r = rect;
+	      mplist_push (p1, Mt, r);
+	      p1 = MPLIST_NEXT (p1);
+	    }
+	}
+      free (rect1);
+    }
+}
+
+void
+mdevice__region_add_rect (MDrawRegion region, MDrawMetric *rect)
+{
+  MPlist *plist = (MPlist *) region;
+  MDrawMetric *new;
+
+  MSTRUCT_MALLOC (new, MERROR_WIN);
+  *new = *rect;
+  mplist_push (plist, Mt, new);
+}
+
+void
+mdevice__region_to_rect (MDrawRegion region, MDrawMetric *rect)
+{
+  MPlist *plist = (MPlist *) region;
+  MDrawMetric *r;
+  int min_x, max_x, min_y, max_y;
+
+  if (MPLIST_TAIL_P (plist))
+    {
+      rect->x = rect->y = rect->width = rect->height = 0;
+      return;
+    }
+  r = MPLIST_VAL (plist);
+  min_x = r->x, max_x = min_x + r->width;
+  min_y = r->y, max_y = min_y + r->height;
+  MPLIST_DO (plist, MPLIST_NEXT (plist))
+    {
+      r = MPLIST_VAL (plist);
+      if (r->x < min_x)
+	min_x = r->x;
+      if (r->x + r->width > max_x)
+	max_x = r->x + r->width;
+      if (r->y < min_y)
+	min_y = r->y;
+      if (r->y + r->height > max_y)
+	max_y = r->y + r->height;
+    }
+  rect->x = min_x;
+  rect->y = min_y;
+  rect->width = max_x - min_x;
+  rect->height = max_y - min_y;
+}
+
+void
+mdevice__free_region (MDrawRegion region)
+{
+  MPlist *plist = (MPlist *) region;
+
+  MPLIST_DO (plist, plist)
+    free (MPLIST_VAL (plist));
+  M17N_OBJECT_UNREF (region);
+}
+
+void
+mdevice__dump_region (MDrawRegion region)
+{
+  MDrawMetric rect;
+
+  mdevice__region_to_rect (region, &rect);
+  fprintf (mdebug__output, "(%d %d %d %d)\n",
+	   rect.x, rect.y, rect.width, rect.height);
+}
+
+/*** @} */
+#endif /* !FOR_DOXYGEN || DOXYGEN_INTERNAL_MODULE */
@@ -0,0 +1,61 @@
+/* device.h -- header file for the routines shared by image devices.
+   Copyright (C) 2026
+     National Institute of Advanced Industrial Science and Technology (AIST)
+     Registration Number H15PRO112
+
+
+   This file is part of the m17n library.
+
+   The m17n library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   The m17n library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the m17n library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301 USA.  */
+
+#ifndef _M17N_DEVICE_H_
+#define _M17N_DEVICE_H_
+
+/* Indices to the array of colors that mdevice__realize_face () stores
+   in the member <info> of a realized face.  Each color is 0xRRGGBB.  */
+
+enum ColorIndex
+  {
+    COLOR_NORMAL,
+    COLOR_INVERSE,
+    COLOR_HLINE,
+    COLOR_BOX_TOP,
+    COLOR_BOX_BOTTOM,
+    COLOR_BOX_LEFT,
+    COLOR_BOX_RIGHT,
+    COLOR_MAX
+  };
+
+extern int mdevice__init ();
+extern void mdevice__fini ();
+
+extern void mdevice__realize_face (MRealizedFace *rface);
+extern void mdevice__free_realized_face (MRealizedFace *rface);
+
+extern int mdevice__intersect_rectangle (MDrawMetric *r1, MDrawMetric *r2,
+					 MDrawMetric *rect);
+
+extern MDrawRegion mdevice__region_from_rect (MDrawMetric *rect);
+extern void mdevice__union_rect_with_region (MDrawRegion region,
+					     MDrawMetric *rect);
+extern void mdevice__intersect_region (MDrawRegion region1,
+				       MDrawRegion region2);
+extern void mdevice__region_add_rect (MDrawRegion region, MDrawMetric *rect);
+extern void mdevice__region_to_rect (MDrawRegion region, MDrawMetric *rect);
+extern void mdevice__free_region (MDrawRegion region);
+extern void mdevice__dump_region (MDrawRegion region);
+
+#endif /* _M17N_DEVICE_H_ */
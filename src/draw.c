@@ -101,13 +101,15 @@ static MSymbol MbidiS;
 static MSymbol MbidiNSM;
 
 static int
-analyse_bidi_level (MGlyphString *gstring)
+analyse_bidi_level (MText *mt, MGlyphString *gstring)
 {
   int len = gstring->used - 2;
   int bidi_sensitive = gstring->control.orientation_reversed;
   int max_level;
   MGlyph *g;
   int i;
+  int to = gstring->to < mtext_nchars (mt) ? gstring->to : mtext_nchars (mt);
+  MSymbol *categories = alloca (sizeof (MSymbol) * (to - gstring->from + 1));
 #ifdef HAVE_FRIBIDI
   FriBidiParType base = bidi_sensitive ? FRIBIDI_TYPE_RTL : FRIBIDI_TYPE_LTR;
   FriBidiChar *logical = alloca (sizeof (FriBidiChar) * len);
@@ -120,6 +122,14 @@ analyse_bidi_level (MGlyphString *gstring)
   memset (levels, 0, sizeof (int) * len);
 #endif /* not HAVE_FRIBIDI */
 
+  if (! bidi_sensitive
+#ifndef HAVE_FRIBIDI
+      || 1
+#endif	/* not HAVE_FRIBIDI */
+      )
+    mchar_get_prop_mtext (mt, gstring->from, to, Mbidi_category,
+			  (void **) categories);
+
   for (g = MGLYPH (1), i = 0; g->type != GLYPH_ANCHOR; g++, i++)
     {
       if (! bidi_sensitive
@@ -128,7 +138,10 @@ analyse_bidi_level (MGlyphString *gstring)
 #endif	/* not HAVE_FRIBIDI */
 	  )
 	{
-	  MSymbol bidi = (MSymbol) mchar_get_prop (g->g.c, Mbidi_category);
+	  /* A non-ASCII glyph is for the character at g->g.from.  No
+	     ASCII character has a bidi category checked below.  */
+	  MSymbol bidi = (g->g.c < 0x80 ? Mnil
+			  : categories[g->g.from - gstring->from]);
 
 	  if (bidi == MbidiR || bidi == MbidiAL
 	      || bidi == MbidiRLE || bidi == MbidiRLO)
@@ -439,7 +452,7 @@ compose_glyph_string (MFrame *frame, MText *mt, int from, int to,
   gstring->to = pos;
 
   if (gstring->control.enable_bidi)
-    max_bidi_level = analyse_bidi_level (gstring);
+    max_bidi_level = analyse_bidi_level (mt, gstring);
 
   /* The next loop is to change each <rface> member for non-ASCII
      characters if necessary.  */
@@ -1487,6 +1500,433 @@ truncate_gstring (MFrame *frame, MText *mt, MGlyphString *gstring)
 }
 
 
+/* Shift the positions in GSTRING and the following glyph strings so
+   that GSTRING starts at BEG.  */
+
+static void
+rebase_gstring (MGlyphString *gstring, int beg)
+{
+  int offset = beg - gstring->from;
+
+  if (offset)
+    for (; gstring; gstring = gstring->next)
+      {
+	int i;
+
+	gstring->from += offset;
+	gstring->to += offset;
+	for (i = 0; i < gstring->used; i++)
+	  {
+	    gstring->glyphs[i].g.from += offset;
+	    gstring->glyphs[i].g.to += offset;
+	  }
+      }
+}
+
+
+/* Return a copy of GSTRING and the following glyph strings whose
+   positions are shifted so that the copy starts at BEG.  */
+
+static MGlyphString *
+copy_gstring (MGlyphString *gstring, int beg)
+{
+  int offset = beg - gstring->from;
+  MGlyphString *copy = NULL, **tail = &copy;
+
+  for (; gstring; gstring = gstring->next)
+    {
+      MGlyphString *gst;
+      M17NObject head;
+      int i;
+
+      M17N_OBJECT (gst, free_gstring, MERROR_DRAW);
+      gstring_num++;
+      head = gst->head;
+      *gst = *gstring;
+      gst->head = head;
+      if (gstring->used > 0)
+	{
+	  MTABLE_MALLOC (gst->glyphs, gstring->used, MERROR_DRAW);
+	  memcpy (gst->glyphs, gstring->glyphs,
+		  sizeof (MGlyph) * gstring->used);
+	}
+      gst->size = gst->used = gstring->used;
+      gst->from += offset;
+      gst->to += offset;
+      for (i = 0; i < gst->used; i++)
+	{
+	  gst->glyphs[i].g.from += offset;
+	  gst->glyphs[i].g.to += offset;
+	}
+      gst->top = copy ? copy : gst;
+      gst->next = NULL;
+      *tail = gst;
+      tail = &gst->next;
+    }
+  return copy;
+}
+
+
+/* Layout cache.  Glyph strings of a frame are cached by the contents
+   of a line (characters and text properties that affect the layout)
+   and the drawing control, so that a line of a fresh M-text with the
+   same contents reuses the layout of a previous one.  The cache is
+   enabled by a nonzero value of the frame parameter
+   Mlayout_cache_size, which is the budget of the cache in bytes.
+
+   A cached glyph string is private to the cache and its positions are
+   relative to the start of the line.  It is never modified nor given
+   to a caller; get_gstring () returns a copy of it shifted to the
+   line.  */
+
+typedef struct
+{
+  int size, inc, used;
+  size_t *words;
+} MLayoutKey;
+
+typedef struct MLayoutCacheEntry MLayoutCacheEntry;
+
+struct MLayoutCacheEntry
+{
+  unsigned hash;
+  MLayoutKey key;
+
+  /* Bytes used by this entry.  */
+  int bytes;
+
+  /* Glyph strings of the line starting at 0.  */
+  MGlyphString *gstring;
+
+  /* Chain in the same bucket.  */
+  MLayoutCacheEntry *chain;
+
+  /* Doubly linked list in the order of use, most recent first.  */
+  MLayoutCacheEntry *prev, *next;
+};
+
+struct MLayoutCache
+{
+  /* Buckets chained by <chain> of MLayoutCacheEntry.  The size is a
+     power of 2.  */
+  MLayoutCacheEntry **buckets;
+  int size, used;
+
+  /* The most and least recently used entries.  */
+  MLayoutCacheEntry *head, *tail;
+
+  /* Frame tick when the entries were made.  */
+  unsigned tick;
+
+  /* Bytes used by all entries.  */
+  int bytes;
+
+  /* Statistics for debugging.  */
+  int hits, misses, evicted;
+};
+
+#define LAYOUT_CACHE_SIZE 64
+
+#define LAYOUT_KEY_APPEND(key, val)	\
+  MLIST_APPEND1 ((key), words, (size_t) (val), MERROR_DRAW)
+
+static void
+append_layout_key_bytes (MLayoutKey *key, void *p, int nbytes)
+{
+  int nwords = (nbytes + sizeof (size_t) - 1) / sizeof (size_t);
+  int i;
+
+  for (i = 0; i < nwords; i++)
+    LAYOUT_KEY_APPEND (key, 0);
+  memcpy (key->words + key->used - nwords, p, nbytes);
+}
+
+/* Append to KEY the values of the text property KEY of MT for each
+   run of the same values between BEG and END.  */
+
+static void
+append_layout_key_prop (MLayoutKey *key, MText *mt, MSymbol prop,
+			int beg, int end)
+{
+  int pos, next;
+
+  for (pos = beg; pos < end; pos = next)
+    {
+      mtext_prop_range (mt, prop, pos, NULL, &next, prop == Mface);
+      if (next > end)
+	next = end;
+      LAYOUT_KEY_APPEND (key, next - beg);
+      if (prop == Mface)
+	{
+	  MFace *faces[64];
+	  int num = mtext_get_prop_values (mt, pos, Mface,
+					   (void **) faces, 64);
+	  int i;
+
+	  LAYOUT_KEY_APPEND (key, num);
+	  for (i = 0; i < num; i++)
+	    {
+	      append_layout_key_bytes (key, faces[i]->property,
+				       sizeof faces[i]->property);
+	      LAYOUT_KEY_APPEND (key, faces[i]->hook);
+	    }
+	}
+      else if (prop == Mfont)
+	{
+	  MFont *font = mtext_get_prop (mt, pos, Mfont);
+
+	  LAYOUT_KEY_APPEND (key, font != NULL);
+	  if (font)
+	    append_layout_key_bytes (key, font, sizeof (MFont));
+	}
+      else
+	LAYOUT_KEY_APPEND (key, mtext_get_prop (mt, pos, prop));
+    }
+}
+
+/* Make in KEY the key of the layout cache for the line of MT starting
+   at BEG drawn with CONTROL.  Return 0 on success, or -1 if the line
+   can't be cached.  */
+
+static int
+make_layout_key (MLayoutKey *key, MText *mt, int beg, MDrawControl *control)
+{
+  int nchars = mtext_nchars (mt);
+  int end = nchars, i;
+
+  if (control->line_break
+      && control->line_break != mdraw_default_line_break)
+    /* The function may depend on anything of MT.  */
+    return -1;
+  if (control->two_dimensional)
+    {
+      end = mtext_character (mt, beg, nchars, '\n');
+      end = end < 0 ? nchars : end + 1;
+    }
+  MLIST_INIT1 (key, words, 256);
+  /* The layout doesn't depend on <cursor_pos>, which get_gstring ()
+     sets in the returned gstring.  */
+  append_layout_key_bytes (key, control,
+			   (char *) (&control->with_cursor) - (char *) control);
+  LAYOUT_KEY_APPEND (key, control->cursor_width);
+  LAYOUT_KEY_APPEND (key, control->cursor_bidi);
+  LAYOUT_KEY_APPEND (key, mdraw_line_break_option);
+  LAYOUT_KEY_APPEND (key, end - beg);
+  LAYOUT_KEY_APPEND (key, end == nchars);
+  for (i = beg; i < end; i++)
+    LAYOUT_KEY_APPEND (key, mtext_ref_char (mt, i));
+  append_layout_key_prop (key, mt, Mface, beg, end);
+  append_layout_key_prop (key, mt, Mfont, beg, end);
+  append_layout_key_prop (key, mt, Mlanguage, beg, end);
+  append_layout_key_prop (key, mt, Mcharset, beg, end);
+  return 0;
+}
+
+static unsigned
+layout_key_hash (MLayoutKey *key)
+{
+  unsigned hash = 2166136261U;
+  int i;
+
+  for (i = 0; i < key->used; i++)
+    hash = (hash ^ (unsigned) key->words[i]) * 16777619U;
+  return hash;
+}
+
+static void
+free_layout_cache_entry (struct MLayoutCache *cache, MLayoutCacheEntry *entry)
+{
+  MLayoutCacheEntry **p;
+
+  for (p = cache->buckets + (entry->hash & (cache->size - 1));
+       *p != entry; p = &(*p)->chain);
+  *p = entry->chain;
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->head = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->tail = entry->prev;
+  cache->used--;
+  cache->bytes -= entry->bytes;
+  M17N_OBJECT_UNREF (entry->gstring);
+  MLIST_FREE1 (&entry->key, words);
+  free (entry);
+}
+
+/* Return the glyph string cached in FRAME for KEY, or NULL.  The
+   caller must not modify it.  */
+
+static MGlyphString *
+find_layout (MFrame *frame, MLayoutKey *key, unsigned hash)
+{
+  struct MLayoutCache *cache = frame->layout_cache;
+  MLayoutCacheEntry *entry;
+
+  if (! cache)
+    return NULL;
+  if (cache->tick != frame->tick)
+    {
+      /* Glyph strings of an old tick refer to realized faces and
+	 fonts that may be already freed.  */
+      while (cache->head)
+	free_layout_cache_entry (cache, cache->head);
+      cache->tick = frame->tick;
+    }
+  for (entry = cache->buckets[hash & (cache->size - 1)]; entry;
+       entry = entry->chain)
+    if (entry->hash == hash
+	&& entry->key.used == key->used
+	&& ! memcmp (entry->key.words, key->words,
+		     sizeof (size_t) * key->used))
+      {
+	if (entry->prev)
+	  {
+	    entry->prev->next = entry->next;
+	    if (entry->next)
+	      entry->next->prev = entry->prev;
+	    else
+	      cache->tail = entry->prev;
+	    entry->prev = NULL;
+	    entry->next = cache->head;
+	    cache->head->prev = entry;
+	    cache->head = entry;
+	  }
+	cache->hits++;
+	return entry->gstring;
+      }
+  cache->misses++;
+  return NULL;
+}
+
+/* Register a copy of GSTRING in the layout cache of FRAME by KEY.
+   KEY is taken by the cache.  */
+
+static void
+register_layout (MFrame *frame, MLayoutKey *key, unsigned hash,
+		 MGlyphString *gstring)
+{
+  struct MLayoutCache *cache = frame->layout_cache;
+  MLayoutCacheEntry *entry;
+  MGlyphString *gst;
+  int i;
+
+  if (! cache)
+    {
+      MSTRUCT_CALLOC (cache, MERROR_DRAW);
+      MTABLE_CALLOC (cache->buckets, LAYOUT_CACHE_SIZE, MERROR_DRAW);
+      cache->size = LAYOUT_CACHE_SIZE;
+      cache->tick = frame->tick;
+      frame->layout_cache = cache;
+    }
+  else if (cache->used >= cache->size)
+    {
+      MLayoutCacheEntry **buckets;
+      int size = cache->size * 2;
+
+      MTABLE_CALLOC (buckets, size, MERROR_DRAW);
+      for (i = 0; i < cache->size; i++)
+	while (cache->buckets[i])
+	  {
+	    entry = cache->buckets[i];
+	    cache->buckets[i] = entry->chain;
+	    entry->chain = buckets[entry->hash & (size - 1)];
+	    buckets[entry->hash & (size - 1)] = entry;
+	  }
+      free (cache->buckets);
+      cache->buckets = buckets;
+      cache->size = size;
+    }
+
+  MSTRUCT_CALLOC (entry, MERROR_DRAW);
+  entry->hash = hash;
+  entry->key = *key;
+  entry->bytes = sizeof (MLayoutCacheEntry) + sizeof (size_t) * key->size;
+  entry->gstring = copy_gstring (gstring, 0);
+  for (gst = entry->gstring; gst; gst = gst->next)
+    entry->bytes += sizeof (MGlyphString) + sizeof (MGlyph) * gst->size;
+  i = hash & (cache->size - 1);
+  entry->chain = cache->buckets[i];
+  cache->buckets[i] = entry;
+  entry->next = cache->head;
+  if (cache->head)
+    cache->head->prev = entry;
+  else
+    cache->tail = entry;
+  cache->head = entry;
+  cache->used++;
+  cache->bytes += entry->bytes;
+
+  while (cache->bytes > frame->layout_cache_size && cache->tail != entry)
+    {
+      free_layout_cache_entry (cache, cache->tail);
+      cache->evicted++;
+    }
+}
+
+void
+mdraw__free_layout_cache (MFrame *frame)
+{
+  struct MLayoutCache *cache = frame->layout_cache;
+  int mdebug_flag = MDEBUG_DRAW;
+
+  if (! cache)
+    return;
+  if (cache->hits + cache->misses > 0)
+    MDEBUG_PRINT5 (" [DRAW] layout cache: %d hits, %d misses (%d%%),"
+		   " %d entries, %d evicted\n", cache->hits, cache->misses,
+		   cache->hits * 100 / (cache->hits + cache->misses),
+		   cache->used, cache->evicted);
+  while (cache->head)
+    free_layout_cache_entry (cache, cache->head);
+  free (cache->buckets);
+  free (cache);
+  frame->layout_cache = NULL;
+}
+
+
+/* Make a gstring for the line of MT starting at BEG.  If the line is
+   wider than the limit, it is broken into the chain of gstrings.  */
+
+static MGlyphString *
+layout_gstring (MFrame *frame, MText *mt, int beg, MDrawControl *control)
+{
+  MGlyphString *gstring;
+  int end;
+  int line = 0, y = 0;
+
+  end = mtext_nchars (mt) + (control->cursor_width != 0);
+  gstring = alloc_gstring (frame, mt, beg, control, line, y);
+  if (beg < mtext_nchars (mt))
+    compose_glyph_string (frame, mt, beg, end, gstring);
+  layout_glyph_string (frame, gstring);
+  end = gstring->to;
+  if (gstring->width_limit
+      && gstring->width > gstring->width_limit)
+    {
+      MGlyphString *gst = gstring;
+
+      truncate_gstring (frame, mt, gst);
+      while (gst->to < end)
+	{
+	  line++, y += gst->height;
+	  gst->next = alloc_gstring (frame, mt, gst->from, control,
+				     line, y);
+	  gst->next->top = gstring;
+	  compose_glyph_string (frame, mt, gst->to, end, gst->next);
+	  gst = gst->next;
+	  layout_glyph_string (frame, gst);
+	  if (gst->width <= gst->width_limit)
+	    break;
+	  truncate_gstring (frame, mt, gst);
+	}
+    }
+  return gstring;
+}
+
+
 /* Return a gstring that covers a character at POS.  */
 
 static MGlyphString *
@@ -1499,10 +1939,10 @@ get_gstring (MFrame *frame, MText *mt, int pos, int to, MDrawControl *control)
       MTextProperty *prop = mtext_get_property (mt, pos, M_glyph_string);
 
       if (prop
-	  && ((prop->start != 0
-	       && mtext_ref_char (mt, prop->start - 1) != '\n')
-	      || (prop->end < mtext_nchars (mt)
-		  && mtext_ref_char (mt, prop->end - 1) != '\n')))
+	  && ((MTEXTPROP_START (prop) != 0
+	       && mtext_ref_char (mt, MTEXTPROP_START (prop) - 1) != '\n')
+	      || (MTEXTPROP_END (prop) < mtext_nchars (mt)
+		  && mtext_ref_char (mt, MTEXTPROP_END (prop) - 1) != '\n')))
 	{
 	  mtext_detach_property (prop);
 	  prop = NULL;
@@ -1529,34 +1969,22 @@ get_gstring (MFrame *frame, MText *mt, int pos, int to, MDrawControl *control)
 
   if (gstring)
     {
-      MGlyphString *gst;
-      int offset;
+      int beg;
 
-      offset = mtext_character (mt, pos, 0, '\n');
-      if (offset < 0)
-	offset = 0;
+      beg = mtext_character (mt, pos, 0, '\n');
+      if (beg < 0)
+	beg = 0;
       else
-	offset++;
-      offset -= gstring->from;
-      if (offset)
-	for (gst = gstring; gst; gst = gst->next)
-	  {
-	    int i;
-
-	    gst->from += offset;
-	    gst->to += offset;
-	    for (i = 0; i < gst->used; i++)
-	      {
-		gst->glyphs[i].g.from += offset;
-		gst->glyphs[i].g.to += offset;
-	      }
-	  }
+	beg++;
+      rebase_gstring (gstring, beg);
       M17N_OBJECT_REF (gstring);
     }
   else
     {
       int beg, end;
-      int line = 0, y = 0;
+      MGlyphString *gst;
+      MLayoutKey key;
+      unsigned hash = 0;
 
       if (pos < mtext_nchars (mt))
 	{
@@ -1568,32 +1996,27 @@ get_gstring (MFrame *frame, MText *mt, int pos, int to, MDrawControl *control)
 	}
       else
 	beg = pos;
-      end = mtext_nchars (mt) + (control->cursor_width != 0);
-      gstring = alloc_gstring (frame, mt, beg, control, line, y);
-      if (beg < mtext_nchars (mt))
-	compose_glyph_string (frame, mt, beg, end, gstring);
-      layout_glyph_string (frame, gstring);
-      end = gstring->to;
-      if (gstring->width_limit
-	  && gstring->width > gstring->width_limit)
+      key.used = 0;
+      if (frame->layout_cache_size > 0
+	  && ! control->disable_caching && pos < mtext_nchars (mt)
+	  && make_layout_key (&key, mt, beg, control) == 0)
 	{
-	  MGlyphString *gst = gstring;
-
-	  truncate_gstring (frame, mt, gst);
-	  while (gst->to < end)
-	    {
-	      line++, y += gst->height;
-	      gst->next = alloc_gstring (frame, mt, gst->from, control,
-					 line, y);
-	      gst->next->top = gstring;
-	      compose_glyph_string (frame, mt, gst->to, end, gst->next);
-	      gst = gst->next;
-	      layout_glyph_string (frame, gst);
-	      if (gst->width <= gst->width_limit)
-		break;
-	      truncate_gstring (frame, mt, gst);
-	    }
+	  hash = layout_key_hash (&key);
+	  gstring = find_layout (frame, &key, hash);
+	}
+      if (gstring)
+	{
+	  MLIST_FREE1 (&key, words);
+	  gstring = copy_gstring (gstring, beg);
+	}
+      else
+	{
+	  gstring = layout_gstring (frame, mt, beg, control);
+	  if (key.used)
+	    register_layout (frame, &key, hash, gstring);
 	}
+      for (gst = gstring; gst->next; gst = gst->next);
+      end = gst->to;
 
       if (! control->disable_caching && pos < mtext_nchars (mt))
 	{
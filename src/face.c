@@ -160,28 +160,152 @@ get_box_create (MFaceBoxProp *prop)
   return box;
 }
 
-/** From FRAME->realized_face_list, find a realized face based on
-    FACE.  */
+/** Hash table of realized faces created on a frame.  The table owns
+    the faces, and they are freed with the table when the frame is
+    freed.  */
 
-static MRealizedFace *
-find_realized_face (MFrame *frame, MFace *face, MFont *font)
+struct MRealizedFaceTable
 {
-  MPlist *plist;
+  /** Buckets chained by <chain> of MRealizedFace.  The size is a
+      power of 2.  */
+  MRealizedFace **buckets;
+  int size;
+
+  /** Number of realized faces in the table.  */
+  int used;
+
+  /** When <used> reaches this, unused realized faces are
+      discarded.  */
+  int limit;
+
+  /** Statistics for debugging.  */
+  int hits, misses, discarded;
+};
+
+#define REALIZED_FACE_TABLE_SIZE 64
+
+static unsigned
+realized_face_hash (MFace *face, MFont *font)
+{
+  unsigned hash = 2166136261U;
+  int i;
 
-  MPLIST_DO (plist, frame->realized_face_list)
+  for (i = 0; i < MFACE_PROPERTY_MAX; i++)
+    hash = (hash ^ (unsigned) (size_t) face->property[i]) * 16777619U;
+  if (font)
     {
-      MRealizedFace *rface = MPLIST_VAL (plist);
+      unsigned char *p = (unsigned char *) font;
 
-      if (memcmp (rface->face.property, face->property,
-		  sizeof face->property) == 0
-	  && (rface->font
-	      ? (font && ! memcmp (rface->font, font, sizeof (MFont)))
-	      : ! font))
-	return rface;
+      for (i = 0; i < sizeof (MFont); i++)
+	hash = (hash ^ p[i]) * 16777619U;
     }
+  return hash;
+}
+
+/** From FRAME->realized_face_table, find a realized face based on
+    FACE and FONT.  HASH is the value of realized_face_hash () for
+    them.  */
+
+static MRealizedFace *
+find_realized_face (MFrame *frame, MFace *face, MFont *font, unsigned hash)
+{
+  struct MRealizedFaceTable *table = frame->realized_face_table;
+  MRealizedFace *rface;
+
+  if (! table)
+    return NULL;
+  for (rface = table->buckets[hash & (table->size - 1)]; rface;
+       rface = rface->chain)
+    if (rface->hash == hash
+	&& memcmp (rface->face.property, face->property,
+		   sizeof face->property) == 0
+	&& (rface->font
+	    ? (font && ! memcmp (rface->font, font, sizeof (MFont)))
+	    : ! font))
+      {
+	table->hits++;
+	return rface;
+      }
+  table->misses++;
   return NULL;
 }
 
+/** Free realized faces of FRAME that are not used since the last
+    modification of a face on FRAME.  Glyph strings referring to them
+    are already out of date.  */
+
+static void
+discard_realized_faces (MFrame *frame)
+{
+  struct MRealizedFaceTable *table = frame->realized_face_table;
+  int i;
+
+  for (i = 0; i < table->size; i++)
+    {
+      MRealizedFace **p = table->buckets + i;
+
+      while (*p)
+	{
+	  MRealizedFace *rface = *p;
+
+	  if (rface->tick == frame->tick || rface == frame->rface)
+	    {
+	      p = &rface->chain;
+	      continue;
+	    }
+	  *p = rface->chain;
+	  table->used--;
+	  table->discarded++;
+	  (*frame->driver->free_realized_face) (rface);
+	  mface__free_realized (rface);
+	}
+    }
+  table->limit = table->used * 2;
+  if (table->limit < REALIZED_FACE_TABLE_SIZE)
+    table->limit = REALIZED_FACE_TABLE_SIZE;
+}
+
+/** Register RFACE in FRAME->realized_face_table.  */
+
+static int
+register_realized_face (MFrame *frame, MRealizedFace *rface)
+{
+  struct MRealizedFaceTable *table = frame->realized_face_table;
+  int i;
+
+  if (! table)
+    {
+      MSTRUCT_CALLOC (table, MERROR_FACE);
+      MTABLE_CALLOC (table->buckets, REALIZED_FACE_TABLE_SIZE, MERROR_FACE);
+      table->size = table->limit = REALIZED_FACE_TABLE_SIZE;
+      frame->realized_face_table = table;
+    }
+  else if (table->used >= table->size)
+    {
+      MRealizedFace **buckets;
+      int size = table->size * 2;
+
+      MTABLE_CALLOC (buckets, size, MERROR_FACE);
+      for (i = 0; i < table->size; i++)
+	while (table->buckets[i])
+	  {
+	    MRealizedFace *rf = table->buckets[i];
+
+	    table->buckets[i] = rf->chain;
+	    rf->chain = buckets[rf->hash & (size - 1)];
+	    buckets[rf->hash & (size - 1)] = rf;
+	  }
+      free (table->buckets);
+      table->buckets = buckets;
+      table->size = size;
+    }
+  i = rface->hash & (table->size - 1);
+  rface->chain = table->buckets[i];
+  table->buckets[i] = rface;
+  table->used++;
+  return 0;
+}
+
 static void
 free_face (void *object)
 {
@@ -605,6 +729,7 @@ mface__realize (MFrame *frame, MFace **faces, int num, int size, MFont *font)
   int i, j;
   MFaceHookFunc func;
   MFont spec;
+  unsigned hash;
 
   if (num == 0 && frame->rface && ! font)
     return frame->rface;
@@ -661,19 +786,26 @@ mface__realize (MFrame *frame, MFace **faces, int num, int size, MFont *font)
     }
 
   merged_face.property[MFACE_FOUNDRY] = Mnil;
-  rface = find_realized_face (frame, &merged_face, font);
+  hash = realized_face_hash (&merged_face, font);
+  rface = find_realized_face (frame, &merged_face, font, hash);
   if (rface)
     {
       if (font && font->type != MFONT_TYPE_REALIZED)
 	free (font);
+      rface->tick = frame->tick;
       return rface;
     }
+  if (frame->realized_face_table
+      && frame->realized_face_table->used >= frame->realized_face_table->limit)
+    discard_realized_faces (frame);
 
   MSTRUCT_CALLOC (rface, MERROR_FACE);
-  mplist_push (frame->realized_face_list, Mt, rface);
   rface->frame = frame;
   rface->face = merged_face;
   rface->font = font;
+  rface->hash = hash;
+  rface->tick = frame->tick;
+  register_realized_face (frame, rface);
 
   if (font)
     {
@@ -952,6 +1084,36 @@ mface__free_realized (MRealizedFace *rface)
   free (rface);
 }
 
+/** Free FRAME->realized_face_table and the realized faces in it.  */
+
+void
+mface__free_realized_face_table (MFrame *frame)
+{
+  struct MRealizedFaceTable *table = frame->realized_face_table;
+  int mdebug_flag = MDEBUG_FONT;
+  int i;
+
+  if (! table)
+    return;
+  if (table->hits + table->misses > 0)
+    MDEBUG_PRINT5 (" [FACE] realized face cache: %d hits, %d misses (%d%%),"
+		   " %d faces, %d discarded\n", table->hits, table->misses,
+		   table->hits * 100 / (table->hits + table->misses),
+		   table->used, table->discarded);
+  for (i = 0; i < table->size; i++)
+    while (table->buckets[i])
+      {
+	MRealizedFace *rface = table->buckets[i];
+
+	table->buckets[i] = rface->chain;
+	(*frame->driver->free_realized_face) (rface);
+	mface__free_realized (rface);
+      }
+  free (table->buckets);
+  free (table);
+  frame->realized_face_table = NULL;
+}
+
 void
 mface__update_frame_face (MFrame *frame)
 {
@@ -1764,7 +1926,7 @@ mface_merge (MFace *dst, MFace *src)
     {
       MFrame *frame = MPLIST_VAL (plist);
 
-      frame->tick++;
+      MFRAME_NEW_TICK (frame);
       if (dst == frame->face)
 	mface__update_frame_face (frame);
     }
@@ -1965,7 +2127,7 @@ mface_put_prop (MFace *face, MSymbol key, void *val)
     {
       MFrame *frame = MPLIST_VAL (plist);
 
-      frame->tick++;
+      MFRAME_NEW_TICK (frame);
       if (face == frame->face)
 	mface__update_frame_face (frame);
     }
@@ -1999,7 +2161,7 @@ mface_put_hook (MFace *face, MFaceHookFunc func)
 	{
 	  MFrame *frame = MPLIST_VAL (plist);
 
-	  frame->tick++;
+	  MFRAME_NEW_TICK (frame);
 	  if (face == frame->face)
 	    mface__update_frame_face (frame);
 	}
@@ -2025,18 +2187,17 @@ void
 mface_update (MFrame *frame, MFace *face)
 {
   MFaceHookFunc func = face->hook;
-  MPlist *rface_list;
+  struct MRealizedFaceTable *table = frame->realized_face_table;
   MRealizedFace *rface;
+  int i;
 
-  if (func && func != noop_hook)
+  if (func && func != noop_hook && table)
     {
-      MPLIST_DO (rface_list, frame->realized_face_list)
-	{
-	  rface = MPLIST_VAL (rface_list);
+      for (i = 0; i < table->size; i++)
+	for (rface = table->buckets[i]; rface; rface = rface->chain)
 	  if (rface->face.hook == func)
 	    (func) (&(rface->face), rface->face.property[MFACE_HOOK_ARG],
 		    rface->info);
-	}
     }
 }
 /*=*/
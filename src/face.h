@@ -112,6 +112,14 @@ struct MRealizedFace
 
   /** Pointer to a window system dependent object.  */
   void *info;
+
+  /** Hash value of <face> and <font>, and the next realized face in
+      the same bucket of <frame>->realized_face_table.  */
+  unsigned hash;
+  MRealizedFace *chain;
+
+  /** Value of <frame>->tick when this face was last used.  */
+  unsigned tick;
 };
 
 
@@ -126,6 +134,8 @@ extern MGlyph *mface__for_chars (MSymbol script, MSymbol language,
 
 extern void mface__free_realized (MRealizedFace *rface);
 
+extern void mface__free_realized_face_table (MFrame *frame);
+
 extern void mface__update_frame_face (MFrame *frame);
 
 #endif /* _M17N_FACE_H_ */
@@ -82,14 +82,94 @@ typedef struct
 #endif	/* HAVE_FONTCONFIG */
 } MFontFT;
 
+/* Metric of a glyph cached in MFTMetricCache.  */
+
+typedef struct
+{
+  /* Glyph code, or MCHAR_INVALID_CODE if this slot is empty.  */
+  unsigned code;
+  int lbearing, rbearing, xadv, ascent, descent;
+} MFTMetric;
+
+/* Glyphs whose codes are less than this are cached in an array
+   indexed by code, the others in a hash table.  */
+#define FT_METRIC_DIRECT_SIZE 512
+
+typedef struct
+{
+  /* Array of FT_METRIC_DIRECT_SIZE elements, or NULL.  */
+  MFTMetric *direct;
+
+  /* Hash table (open addressing) of SIZE elements, USED of which are
+     not empty.  SIZE is zero or a power of 2.  */
+  MFTMetric *table;
+  int size, used;
+
+  /* Statistics for debugging.  */
+  int hits, misses;
+} MFTMetricCache;
+
 typedef struct
 {
   M17NObject control;
   FT_Face ft_face;		/* This must be the 2nd member. */
   MPlist *charmap_list;
   int face_encapsulated;
+  /* Glyph metrics measured so far.  Not used if FT_FACE is
+     encapsulated because the owner may change its size.  */
+  MFTMetricCache metric_cache;
 } MRealizedFontFT;
 
+/* Glyph image cached in ft_bitmap_table.  */
+
+typedef struct MFTBitmap MFTBitmap;
+
+struct MFTBitmap
+{
+  MGlyphBitmap bitmap;
+
+  /* Key of the entry.  */
+  MRealizedFontFT *ft_rfont;
+  unsigned code;
+  int anti_alias;
+
+  /* Number of bytes occupied by this entry including the buffer of
+     BITMAP.  */
+  int bytes;
+
+  /* Next entry in the same bucket of ft_bitmap_table.  */
+  MFTBitmap *chain;
+
+  /* Adjacent entries in the LRU list.  PREV is used more recently.  */
+  MFTBitmap *prev, *next;
+};
+
+/* Hash table of cached glyph images.  The size is zero or a power of
+   2.  */
+static MFTBitmap **ft_bitmap_table;
+static int ft_bitmap_table_size;
+
+/* LRU list of the entries of ft_bitmap_table.  */
+static MFTBitmap *ft_bitmap_head, *ft_bitmap_tail;
+
+/* Number of entries in ft_bitmap_table, and the total bytes of
+   them.  */
+static int ft_bitmap_count, ft_bitmap_bytes;
+
+/* Statistics for debugging.  */
+static int ft_bitmap_hits, ft_bitmap_misses;
+
+/* Glyph image returned for an uncached glyph.  */
+static MGlyphBitmap ft_bitmap_work;
+
+/* Lock of the above variables and of the glyph slots of FreeType
+   faces, held while a glyph image is rendered and used.  */
+M17N_MUTEX (ft_render_lock)
+
+#define FT_BITMAP_HASH(ft_rfont, code, anti_alias)			\
+  ((((unsigned) (size_t) (ft_rfont) >> 4) ^ ((code) * 2654435761U)	\
+    ^ (anti_alias)) & (ft_bitmap_table_size - 1))
+
 typedef struct
 {
   char *ft_style;
@@ -145,11 +225,62 @@ static int all_fonts_scaned;
 
 static MPlist *ft_list_family (MSymbol, int, int);
 
+static void
+ft_bitmap_remove (MFTBitmap *bm)
+{
+  MFTBitmap **p = ft_bitmap_table + FT_BITMAP_HASH (bm->ft_rfont, bm->code,
+						    bm->anti_alias);
+
+  while (*p != bm)
+    p = &(*p)->chain;
+  *p = bm->chain;
+  if (bm->prev)
+    bm->prev->next = bm->next;
+  else
+    ft_bitmap_head = bm->next;
+  if (bm->next)
+    bm->next->prev = bm->prev;
+  else
+    ft_bitmap_tail = bm->prev;
+  ft_bitmap_count--;
+  ft_bitmap_bytes -= bm->bytes;
+  free (bm);
+}
+
+/* Discard the cached glyph images of FT_RFONT.  If FT_RFONT is NULL,
+   discard all of them.  */
+
+static void
+ft_bitmap_flush (MRealizedFontFT *ft_rfont)
+{
+  MFTBitmap *bm, *next;
+
+  M17N_LOCK (ft_render_lock);
+  for (bm = ft_bitmap_head; bm; bm = next)
+    {
+      next = bm->next;
+      if (! ft_rfont || bm->ft_rfont == ft_rfont)
+	ft_bitmap_remove (bm);
+    }
+  M17N_UNLOCK (ft_render_lock);
+}
+
 static void
 free_ft_rfont (void *object)
 {
   MRealizedFontFT *ft_rfont = object;
-
+  MFTMetricCache *cache = &ft_rfont->metric_cache;
+
+  if (cache->hits + cache->misses > 0)
+    MDEBUG_PRINT4 (" [FONT-FT] metric cache of %s: %d hits, %d misses"
+		   " (%d%%)\n", ft_rfont->ft_face->family_name,
+		   cache->hits, cache->misses,
+		   cache->hits * 100 / (cache->hits + cache->misses));
+  if (cache->direct)
+    free (cache->direct);
+  if (cache->table)
+    free (cache->table);
+  ft_bitmap_flush (ft_rfont);
   if (! ft_rfont->face_encapsulated)
     {
       M17N_OBJECT_UNREF (ft_rfont->charmap_list);
@@ -158,6 +289,72 @@ free_ft_rfont (void *object)
   free (ft_rfont);
 }
 
+/* Return a slot of CACHE for the metric of glyph CODE.  If the
+   metric is already cached, set *FOUND to 1.  Otherwise, set *FOUND
+   to 0 and reserve the returned slot for CODE; the caller must fill
+   it.  */
+
+static MFTMetric *
+ft_metric_slot (MFTMetricCache *cache, unsigned code, int *found)
+{
+  MFTMetric *m;
+  int i;
+
+  if (code < FT_METRIC_DIRECT_SIZE)
+    {
+      if (! cache->direct)
+	{
+	  MTABLE_MALLOC (cache->direct, FT_METRIC_DIRECT_SIZE, MERROR_FONT_FT);
+	  for (i = 0; i < FT_METRIC_DIRECT_SIZE; i++)
+	    cache->direct[i].code = MCHAR_INVALID_CODE;
+	}
+      m = cache->direct + code;
+    }
+  else
+    {
+      if (cache->used * 2 >= cache->size)
+	{
+	  MFTMetric *table = cache->table;
+	  int size = cache->size;
+
+	  cache->size = size ? size * 2 : 64;
+	  MTABLE_MALLOC (cache->table, cache->size, MERROR_FONT_FT);
+	  for (i = 0; i < cache->size; i++)
+	    cache->table[i].code = MCHAR_INVALID_CODE;
+	  for (i = 0; i < size; i++)
+	    if (table[i].code != MCHAR_INVALID_CODE)
+	      {
+		int j = table[i].code & (cache->size - 1);
+
+		while (cache->table[j].code != MCHAR_INVALID_CODE)
+		  j = (j + 1) & (cache->size - 1);
+		cache->table[j] = table[i];
+	      }
+	  if (table)
+	    free (table);
+	}
+      for (i = code & (cache->size - 1);
+	   cache->table[i].code != code
+	     && cache->table[i].code != MCHAR_INVALID_CODE;
+	   i = (i + 1) & (cache->size - 1));
+      m = cache->table + i;
+      if (m->code == MCHAR_INVALID_CODE)
+	cache->used++;
+    }
+  if (m->code == code)
+    {
+      cache->hits++;
+      *found = 1;
+    }
+  else
+    {
+      cache->misses++;
+      m->code = code;
+      *found = 0;
+    }
+  return m;
+}
+
 static void
 free_ft_info (MFontFT *ft_info)
 {
@@ -1583,6 +1780,7 @@ ft_find_metric (MRealizedFont *rfont, MGlyphString *gstring,
 		int from, int to)
 {
   FT_Face ft_face = rfont->fontp;
+  MRealizedFontFT *ft_rfont = rfont->info;
   MGlyph *g = MGLYPH (from), *gend = MGLYPH (to);
 
   for (; g != gend; g++)
@@ -1630,15 +1828,39 @@ ft_find_metric (MRealizedFont *rfont, MGlyphString *gstring,
 	}
       else
 	{
-	  FT_Glyph_Metrics *metrics;
-
-	  FT_Load_Glyph (ft_face, (FT_UInt) g->g.code, FT_LOAD_DEFAULT);
-	  metrics = &ft_face->glyph->metrics;
-	  g->g.lbearing = metrics->horiBearingX;
-	  g->g.rbearing = metrics->horiBearingX + metrics->width;
-	  g->g.xadv = metrics->horiAdvance;
-	  g->g.ascent = metrics->horiBearingY;
-	  g->g.descent = metrics->height - metrics->horiBearingY;
+	  MFTMetric *m = NULL;
+	  int found = 0;
+
+	  if (! ft_rfont->face_encapsulated)
+	    m = ft_metric_slot (&ft_rfont->metric_cache, g->g.code, &found);
+	  if (! found)
+	    {
+	      FT_Glyph_Metrics *metrics;
+
+	      FT_Load_Glyph (ft_face, (FT_UInt) g->g.code, FT_LOAD_DEFAULT);
+	      metrics = &ft_face->glyph->metrics;
+	      g->g.lbearing = metrics->horiBearingX;
+	      g->g.rbearing = metrics->horiBearingX + metrics->width;
+	      g->g.xadv = metrics->horiAdvance;
+	      g->g.ascent = metrics->horiBearingY;
+	      g->g.descent = metrics->height - metrics->horiBearingY;
+	      if (m)
+		{
+		  m->lbearing = g->g.lbearing;
+		  m->rbearing = g->g.rbearing;
+		  m->xadv = g->g.xadv;
+		  m->ascent = g->g.ascent;
+		  m->descent = g->g.descent;
+		}
+	    }
+	  else
+	    {
+	      g->g.lbearing = m->lbearing;
+	      g->g.rbearing = m->rbearing;
+	      g->g.xadv = m->xadv;
+	      g->g.ascent = m->ascent;
+	      g->g.descent = m->descent;
+	    }
 	}
       g->g.yadv = 0;
       g->g.ascent += rfont->baseline_offset;
@@ -1747,57 +1969,46 @@ ft_render (MDrawWindow win, int x, int y,
 	   MGlyphString *gstring, MGlyph *from, MGlyph *to,
 	   int reverse, MDrawRegion region)
 {
-  FT_Face ft_face;
   MRealizedFace *rface = from->rface;
   MFrame *frame = rface->frame;
-  FT_Int32 load_flags = FT_LOAD_RENDER;
   MGlyph *g;
   int i, j;
   MPointTable point_table[8];
   int baseline_offset;
-  int pixel_mode = -1;
+  int mono = -1;
 
   if (from == to)
     return;
 
   /* It is assured that the all glyphs in the current range use the
      same realized face.  */
-  ft_face = rface->rfont->fontp;
   baseline_offset = rface->rfont->baseline_offset >> 6;
 
-  if (! gstring->anti_alias)
-    {
-#ifdef FT_LOAD_TARGET_MONO
-      load_flags |= FT_LOAD_TARGET_MONO;
-#else
-      load_flags |= FT_LOAD_MONOCHROME;
-#endif
-    }
-
   for (i = 0; i < 8; i++)
     point_table[i].p = point_table[i].points;
 
   for (g = from; g < to; x += g++->g.xadv)
     {
+      MGlyphBitmap *bitmap;
       unsigned char *bmp;
       int intensity;
       MPointTable *ptable;
       int xoff, yoff;
-      int width, pitch;
-
-      FT_Load_Glyph (ft_face, (FT_UInt) g->g.code, load_flags);
-      if (pixel_mode < 0)
-	pixel_mode = ft_face->glyph->bitmap.pixel_mode;
-      yoff = y - ft_face->glyph->bitmap_top + g->g.yoff;
-      bmp = ft_face->glyph->bitmap.buffer;
-      width = ft_face->glyph->bitmap.width;
-      pitch = ft_face->glyph->bitmap.pitch;
-
-      if (pixel_mode != FT_PIXEL_MODE_MONO)
-	for (i = 0; i < ft_face->glyph->bitmap.rows;
-	     i++, bmp += ft_face->glyph->bitmap.pitch, yoff++)
+      int width;
+
+      mfont__ft_lock_render ();
+      bitmap = mfont__ft_render_glyph (rface->rfont, g->g.code,
+				       gstring->anti_alias);
+      if (mono < 0)
+	mono = bitmap->mono;
+      yoff = y - bitmap->top + g->g.yoff;
+      bmp = bitmap->buffer;
+      width = bitmap->width;
+
+      if (! mono)
+	for (i = 0; i < bitmap->rows; i++, bmp += bitmap->pitch, yoff++)
 	  {
-	    xoff = x + ft_face->glyph->bitmap_left + g->g.xoff;
+	    xoff = x + bitmap->left + g->g.xoff;
 	    for (j = 0; j < width; j++, xoff++)
 	      {
 		intensity = bmp[j] >> 5;
@@ -1819,10 +2030,9 @@ ft_render (MDrawWindow win, int x, int y,
 	      }
 	  }
       else
-	for (i = 0; i < ft_face->glyph->bitmap.rows;
-	     i++, bmp += ft_face->glyph->bitmap.pitch, yoff++)
+	for (i = 0; i < bitmap->rows; i++, bmp += bitmap->pitch, yoff++)
 	  {
-	    xoff = x + ft_face->glyph->bitmap_left + g->g.xoff;
+	    xoff = x + bitmap->left + g->g.xoff;
 	    for (j = 0; j < width; j++, xoff++)
 	      {
 		intensity = bmp[j / 8] & (1 << (7 - (j % 8)));
@@ -1842,9 +2052,10 @@ ft_render (MDrawWindow win, int x, int y,
 		  }
 	      }
 	}
+      mfont__ft_unlock_render ();
     }
 
-  if (pixel_mode != FT_PIXEL_MODE_MONO)
+  if (! mono)
     {
       for (i = 1; i < 8; i++)
 	if (point_table[i].p != point_table[i].points)
@@ -2898,6 +3109,19 @@ mfont__ft_fini ()
 	  ft_file_list = NULL;
 	}
     }
+  if (ft_bitmap_hits + ft_bitmap_misses > 0)
+    MDEBUG_PRINT4 (" [FONT-FT] glyph image cache: %d hits, %d misses"
+		   " (%d%%), %d bytes\n", ft_bitmap_hits, ft_bitmap_misses,
+		   ft_bitmap_hits * 100 / (ft_bitmap_hits + ft_bitmap_misses),
+		   ft_bitmap_bytes);
+  ft_bitmap_flush (NULL);
+  if (ft_bitmap_table)
+    {
+      free (ft_bitmap_table);
+      ft_bitmap_table = NULL;
+      ft_bitmap_table_size = 0;
+    }
+  ft_bitmap_hits = ft_bitmap_misses = 0;
   FT_Done_FreeType (ft_library);
 #ifdef HAVE_FONTCONFIG
   FcConfigDestroy (fc_config);
@@ -2906,6 +3130,133 @@ mfont__ft_fini ()
   all_fonts_scaned = 0;
 }
 
+/* Lock and unlock the glyph image cache.  mfont__ft_render_glyph ()
+   must be called, and the returned image used, between these calls
+   so that frames can draw text in several threads.  They do nothing
+   unless the library is compiled with M17N_THREAD_SAFE.  */
+
+void
+mfont__ft_lock_render (void)
+{
+  M17N_LOCK (ft_render_lock);
+}
+
+void
+mfont__ft_unlock_render (void)
+{
+  M17N_UNLOCK (ft_render_lock);
+}
+
+/* Render the glyph CODE of RFONT, and return the resulting image.
+   If ANTI_ALIAS is zero, the glyph is rendered in monochrome.  The
+   returned image is valid until the next call of this function or of
+   mfont__ft_unlock_render ().  */
+
+MGlyphBitmap *
+mfont__ft_render_glyph (MRealizedFont *rfont, unsigned code, int anti_alias)
+{
+  MRealizedFontFT *ft_rfont = rfont->info;
+  FT_Face ft_face = rfont->fontp;
+  FT_Int32 load_flags = FT_LOAD_RENDER;
+  FT_Bitmap *ft_bitmap;
+  MFTBitmap *bm;
+  int i, size, bytes;
+
+  anti_alias = anti_alias != 0;
+  if (ft_bitmap_table)
+    {
+      for (bm = ft_bitmap_table[FT_BITMAP_HASH (ft_rfont, code, anti_alias)];
+	   bm; bm = bm->chain)
+	if (bm->ft_rfont == ft_rfont && bm->code == code
+	    && bm->anti_alias == anti_alias)
+	  {
+	    ft_bitmap_hits++;
+	    if (bm->prev)
+	      {
+		bm->prev->next = bm->next;
+		if (bm->next)
+		  bm->next->prev = bm->prev;
+		else
+		  ft_bitmap_tail = bm->prev;
+		bm->prev = NULL;
+		bm->next = ft_bitmap_head;
+		ft_bitmap_head->prev = bm;
+		ft_bitmap_head = bm;
+	      }
+	    return &bm->bitmap;
+	  }
+    }
+
+  if (! anti_alias)
+    {
+#ifdef FT_LOAD_TARGET_MONO
+      load_flags |= FT_LOAD_TARGET_MONO;
+#else
+      load_flags |= FT_LOAD_MONOCHROME;
+#endif
+    }
+  FT_Load_Glyph (ft_face, (FT_UInt) code, load_flags);
+  ft_bitmap = &ft_face->glyph->bitmap;
+  ft_bitmap_work.left = ft_face->glyph->bitmap_left;
+  ft_bitmap_work.top = ft_face->glyph->bitmap_top;
+  ft_bitmap_work.width = ft_bitmap->width;
+  ft_bitmap_work.rows = ft_bitmap->rows;
+  ft_bitmap_work.pitch = ft_bitmap->pitch;
+  ft_bitmap_work.mono = ft_bitmap->pixel_mode == FT_PIXEL_MODE_MONO;
+  ft_bitmap_work.buffer = ft_bitmap->buffer;
+
+  /* The owner of an encapsulated face may change its size.  */
+  if (ft_rfont->face_encapsulated || ft_bitmap->pitch < 0)
+    return &ft_bitmap_work;
+  ft_bitmap_misses++;
+  size = ft_bitmap->rows * ft_bitmap->pitch;
+  bytes = sizeof (MFTBitmap) + size;
+  if (bytes > mfont_glyph_cache_size)
+    return &ft_bitmap_work;
+  while (ft_bitmap_bytes + bytes > mfont_glyph_cache_size)
+    ft_bitmap_remove (ft_bitmap_tail);
+
+  if (ft_bitmap_count >= ft_bitmap_table_size)
+    {
+      ft_bitmap_table_size = (ft_bitmap_table_size
+			      ? ft_bitmap_table_size * 2 : 256);
+      if (ft_bitmap_table)
+	free (ft_bitmap_table);
+      MTABLE_CALLOC (ft_bitmap_table, ft_bitmap_table_size, MERROR_FONT_FT);
+      for (bm = ft_bitmap_head; bm; bm = bm->next)
+	{
+	  i = FT_BITMAP_HASH (bm->ft_rfont, bm->code, bm->anti_alias);
+	  bm->chain = ft_bitmap_table[i];
+	  ft_bitmap_table[i] = bm;
+	}
+    }
+
+  bm = malloc (bytes);
+  if (! bm)
+    MEMORY_FULL (MERROR_FONT_FT);
+  bm->bitmap = ft_bitmap_work;
+  bm->bitmap.buffer = (unsigned char *) (bm + 1);
+  if (size > 0)
+    memcpy (bm->bitmap.buffer, ft_bitmap->buffer, size);
+  bm->ft_rfont = ft_rfont;
+  bm->code = code;
+  bm->anti_alias = anti_alias;
+  bm->bytes = bytes;
+  i = FT_BITMAP_HASH (ft_rfont, code, anti_alias);
+  bm->chain = ft_bitmap_table[i];
+  ft_bitmap_table[i] = bm;
+  bm->prev = NULL;
+  bm->next = ft_bitmap_head;
+  if (ft_bitmap_head)
+    ft_bitmap_head->prev = bm;
+  else
+    ft_bitmap_tail = bm;
+  ft_bitmap_head = bm;
+  ft_bitmap_count++;
+  ft_bitmap_bytes += bytes;
+  return &bm->bitmap;
+}
+
 #ifdef HAVE_FONTCONFIG
 
 int
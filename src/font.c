@@ -2243,6 +2243,34 @@ MPlist *mfont_freetype_path;
 
 /*=*/
 
+/***en
+    @brief Size of the cache of rendered glyph images.
+
+    The variable @c mfont_glyph_cache_size is the maximum number of
+    bytes that the m17n library uses for keeping glyph images
+    rendered by the FreeType library, so that it does not have to
+    render the same glyph again.  When the cache is full, the least
+    recently used images are discarded.  The default value is
+    2097152 (2M bytes).  If the value is zero or negative, glyph
+    images are not cached.
+
+    If the m17n library is not configured to use the FreeType library,
+    this variable is not used.  */
+/***ja
+    @brief Ѥߥե᡼Υå礭.
+
+    ѿ @c mfont_glyph_cache_size ϡFreeType 饤֥褷ե᡼
+    ƱդƤ褷ʤƤ褦ݻƤ m17n 
+    饤֥꤬ѤХȿǤ롣å夬դˤʤȡ
+    ǤĹֻȤƤʤ᡼ΤƤ롣ǥեͤ 
+    2097152 (2M Х) Ǥ롣ͤ 0 ʲʤСե᡼ϥå夵ʤ
+
+    m17n 饤֥꤬ FreeType 饤֥Ȥ褦ꤵƤʤˤϡѿѤʤ */
+
+int mfont_glyph_cache_size = 2 * 1024 * 1024;
+
+/*=*/
+
 /***en
     @brief Create a new font.
 
@@ -311,6 +311,30 @@ extern int mfont__ft_parse_name (const char *name, MFont *font);
 
 extern char *mfont__ft_unparse_name (MFont *font);
 
+/* Bitmap of a glyph rendered by FreeType.  */
+
+typedef struct
+{
+  /* Offset from the origin of the glyph to the left edge and the top
+     edge of the bitmap.  */
+  int left, top;
+
+  int width, rows, pitch;
+
+  /* Nonzero if BUFFER has 1 bit per pixel, zero if it has 1 byte
+     (256 levels of gray) per pixel.  */
+  int mono;
+
+  unsigned char *buffer;
+} MGlyphBitmap;
+
+extern void mfont__ft_lock_render (void);
+
+extern void mfont__ft_unlock_render (void);
+
+extern MGlyphBitmap *mfont__ft_render_glyph (MRealizedFont *rfont,
+					     unsigned code, int anti_alias);
+
 #ifdef HAVE_OTF
 
 extern int mfont__ft_drive_otf (MGlyphString *gstring, int from, int to,
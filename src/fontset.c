@@ -555,6 +555,17 @@ mfont__free_realized_fontset (MRealizedFontset *realized)
   free (realized);
 }
 
+/* Make REALIZED refer to frame NEW_FRAME if it refers to FRAME.  This
+   is for a device whose frames share realized fontsets.  */
+
+void
+mfont__move_realized_fontset (MRealizedFontset *realized, MFrame *frame,
+			      MFrame *new_frame)
+{
+  if (realized->frame == frame)
+    realized->frame = new_frame;
+}
+
 
 static MRealizedFont *
 try_font_list (MFrame *frame, MFontList *font_list, MFont *request,
@@ -29,6 +29,9 @@ extern MRealizedFontset *mfont__realize_fontset (MFrame *frame,
 
 void mfont__free_realized_fontset (MRealizedFontset *realized);
 
+void mfont__move_realized_fontset (MRealizedFontset *realized,
+				   MFrame *frame, MFrame *new_frame);
+
 extern MRealizedFont *mfont__lookup_fontset (MRealizedFontset *realized,
 					     MGlyph *g, int *num,
 					     MSymbol script, MSymbol language,
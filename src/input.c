@@ -201,6 +201,18 @@ static MSymbol Mdescription, Mcommand, Mvariable, Mglobal, Mconfig;
 
 static MSymbol M_gettext;
 
+/** Structure to hold a deeper map and the key to reach it.  */
+
+typedef struct
+{
+  MSymbol key;
+  MIMMap *map;
+} MIMSubmap;
+
+/** Maps that have more deeper maps than this are indexed by a hash
+    table.  */
+#define MIM_SUBMAP_LINEAR 8
+
 /** Structure to hold a map.  */
 
 struct MIMMap
@@ -209,15 +221,33 @@ struct MIMMap
       the actions are executed only when there is no more key.  */
   MPlist *map_actions;
 
-  /** List of deeper maps.  If NULL, this is a terminal map.  */
-  MPlist *submaps;
+  /** Number of deeper maps, and the allocated length of SUBMAPS (zero
+      or a power of 2).  If NSUBMAPS is zero, this is a terminal
+      map.  */
+  int nsubmaps, submaps_size;
+
+  /** Vector of deeper maps in the order of definition.  */
+  MIMSubmap *submaps;
+
+  /** Hash table of the indices (plus one) into SUBMAPS.  The length
+      is twice SUBMAPS_SIZE.  NULL while NSUBMAPS is not greater than
+      MIM_SUBMAP_LINEAR.  */
+  int *submap_index;
 
   /** List of actions to take when we leave the map successfully.  In
       a root map, the actions are executed only when none of submaps
       handle the current key.  */
   MPlist *branch_actions;
+
+  /** If not NULL, the map is not yet built, and the above members are
+      to be set from the node at NODE of COMPILED by expand_map ().  */
+  MIMCompiled *compiled;
+  int node;
 };
 
+#define MIM_SUBMAP_HASH(key, size)					\
+  (((((unsigned) (size_t) (key) >> 3) * 2654435761U) >> 16) & ((size) - 1))
+
 typedef MPlist *(*MIMExternalFunc) (MPlist *plist);
 
 typedef struct
@@ -240,6 +270,9 @@ struct MIMState
   /** Key translation map of the state.  Built by merging all maps of
       branches.  */
   MIMMap *map;
+
+  /** Compiled maps from which MAP is built, or NULL.  */
+  MIMCompiled *compiled;
 };
 
 #define CUSTOM_FILE "config.mic"
@@ -276,6 +309,7 @@ static MPlist *fallback_input_methods;
 static int update_global_info (void);
 static int update_custom_info (void);
 static MInputMethodInfo *get_im_info (MSymbol, MSymbol, MSymbol, MSymbol);
+static MPlist *im_info_maps (MInputMethodInfo *);
 
 
 /* Initialize fallback_input_methods.  Called by fully_initialize ()
@@ -1037,6 +1071,279 @@ parse_action_list (MPlist *plist, MPlist *macros)
   return 0;
 }
 
+/* Compiled input methods.
+
+   An input method can be compiled into a cache file named
+   ".FILE.mimc" in the same directory as the MIM file FILE (see
+   mdatabase__save_cache ()), so that the input method is opened
+   without parsing FILE and building the maps.  The cache file is
+   mapped into memory, and only the small part of it is decoded on
+   opening.  A map is built only when it is reached by a key, and the
+   source of the maps is decoded only when another input method
+   includes it.  The ints in the cache file are these:
+	MIM_CACHE_FORMAT SYMBOLS NSYMBOLS STATES NSTATES DATA MAPS
+	NODE or ACTIONS ...
+	SYMBOL ...			;; NSYMBOLS elements at SYMBOLS
+	NAME TITLE ROOT ...		;; NSTATES records at STATES
+   DATA and MAPS are the offsets of encoded plists; DATA is the plist
+   of FILE except for the map and state sections, and MAPS is the
+   plist of the map sections.  NODE is for a map and has this form:
+	MAP-ACTIONS BRANCH-ACTIONS NSUBMAPS (KEY SUBMAP) ...
+   MAP-ACTIONS and BRANCH-ACTIONS are the offsets of encoded action
+   lists (0 if none), KEY is an index of the symbols, and SUBMAP and
+   ROOT are the offsets of nodes.  SYMBOL, NAME, TITLE, and ACTIONS
+   are encoded by mdatabase__cache_put_element ().  */
+
+#define MIM_CACHE_SUFFIX ".mimc"
+#define MIM_CACHE_FORMAT 2
+#define MIM_CACHE_HEADER_LENGTH 7
+
+struct MIMCompiled
+{
+  M17NObject control;
+
+  /** Ints of the cache file, and their number.  */
+  const int *words;
+  int length;
+
+  /** Symbols referred by nodes.  */
+  MSymbol *symbols;
+  int nsymbols;
+
+  /** Hash table of decoded action lists.  ACTIONS[I] is the list
+      encoded at OFFSETS[I], or OFFSETS[I] is 0 if the slot is empty.
+      SIZE is zero or a power of 2.  */
+  int *offsets;
+  MPlist **actions;
+  int size, used;
+
+  /** Macros of the input method.  Decoded action lists are validated
+      with them.  */
+  MPlist *macros;
+};
+
+#define MIM_COMPILED_HASH(offset, size)				\
+  ((((unsigned) (offset) * 2654435761U) >> 8) & ((size) - 1))
+
+static void
+free_compiled_maps (void *object)
+{
+  MIMCompiled *compiled = object;
+  int i;
+
+  for (i = 0; i < compiled->size; i++)
+    if (compiled->offsets[i])
+      M17N_OBJECT_UNREF (compiled->actions[i]);
+  free (compiled->offsets);
+  free (compiled->actions);
+  free (compiled->symbols);
+  M17N_OBJECT_UNREF (compiled->macros);
+  mdatabase__free_cache (compiled->words, compiled->length);
+  free (compiled);
+}
+
+/* Return the action list encoded at OFFSET of COMPILED, or NULL if
+   it is broken.  The list is decoded and validated only once, and
+   kept in COMPILED.  */
+
+static MPlist *
+compiled_actions (MIMCompiled *compiled, int offset)
+{
+  const int *p = compiled->words + offset;
+  MSymbol key;
+  void *val;
+  int i;
+
+  if (offset <= 0 || offset >= compiled->length)
+    return NULL;
+  if (compiled->used * 2 >= compiled->size)
+    {
+      int *offsets = compiled->offsets;
+      MPlist **actions = compiled->actions;
+      int size = compiled->size;
+
+      compiled->size = size ? size * 2 : 64;
+      MTABLE_CALLOC (compiled->offsets, compiled->size, MERROR_IM);
+      MTABLE_MALLOC (compiled->actions, compiled->size, MERROR_IM);
+      for (i = 0; i < size; i++)
+	if (offsets[i])
+	  {
+	    int j = MIM_COMPILED_HASH (offsets[i], compiled->size);
+
+	    while (compiled->offsets[j])
+	      j = (j + 1) & (compiled->size - 1);
+	    compiled->offsets[j] = offsets[i];
+	    compiled->actions[j] = actions[i];
+	  }
+      free (offsets);
+      free (actions);
+    }
+  for (i = MIM_COMPILED_HASH (offset, compiled->size); compiled->offsets[i];
+       i = (i + 1) & (compiled->size - 1))
+    if (compiled->offsets[i] == offset)
+      return compiled->actions[i];
+  if (mdatabase__cache_get_element (&p, compiled->words + compiled->length,
+				    &key, &val) < 0)
+    return NULL;
+  if (key != Mplist)
+    {
+      if (key == Mtext)
+	M17N_OBJECT_UNREF (val);
+      else if (key == Mstring)
+	free (val);
+      return NULL;
+    }
+  if (parse_action_list (val, compiled->macros) < 0)
+    {
+      M17N_OBJECT_UNREF (val);
+      return NULL;
+    }
+  compiled->offsets[i] = offset;
+  compiled->actions[i] = val;
+  compiled->used++;
+  return val;
+}
+
+static void expand_map (MIMMap *map);
+
+/* Return the deeper map of MAP for KEY, or NULL if there's none.  */
+
+static MIMMap *
+lookup_submap (MIMMap *map, MSymbol key)
+{
+  MIMMap *submap = NULL;
+  int i;
+
+  if (! map->submap_index)
+    {
+      for (i = 0; i < map->nsubmaps; i++)
+	if (map->submaps[i].key == key)
+	  {
+	    submap = map->submaps[i].map;
+	    break;
+	  }
+    }
+  else
+    {
+      int mask = map->submaps_size * 2 - 1;
+
+      for (i = MIM_SUBMAP_HASH (key, map->submaps_size * 2);
+	   map->submap_index[i]; i = (i + 1) & mask)
+	if (map->submaps[map->submap_index[i] - 1].key == key)
+	  {
+	    submap = map->submaps[map->submap_index[i] - 1].map;
+	    break;
+	  }
+    }
+  if (submap && submap->compiled)
+    expand_map (submap);
+  return submap;
+}
+
+/* Return the deeper map of MAP for KEY, or if KEY is not handled by
+   MAP, the deeper map for an alias of KEY.  If ALIAS is not NULL,
+   store the key or the alias in it.  Return NULL if there's no such
+   map.  */
+
+static MIMMap *
+lookup_submap_with_alias (MIMMap *map, MSymbol key, MSymbol *alias)
+{
+  MIMMap *submap = NULL;
+  MSymbol sym = Mnil;
+
+  if (map->nsubmaps > 0)
+    {
+      submap = lookup_submap (map, key);
+      sym = key;
+      while (! submap
+	     && (sym = msymbol_get (sym, M_key_alias))
+	     && sym != key)
+	submap = lookup_submap (map, sym);
+    }
+  if (alias)
+    *alias = sym;
+  return submap;
+}
+
+/* Add a new deeper map of MAP for KEY, and return it.  KEY must not
+   be handled by MAP yet.  */
+
+static MIMMap *
+add_submap (MIMMap *map, MSymbol key)
+{
+  MIMMap *submap;
+  int i;
+
+  MSTRUCT_CALLOC (submap, MERROR_IM);
+  if (map->nsubmaps == map->submaps_size)
+    {
+      map->submaps_size = map->submaps_size ? map->submaps_size * 2 : 1;
+      MTABLE_REALLOC (map->submaps, map->submaps_size, MERROR_IM);
+      if (map->submap_index)
+	{
+	  free (map->submap_index);
+	  map->submap_index = NULL;
+	}
+    }
+  map->submaps[map->nsubmaps].key = key;
+  map->submaps[map->nsubmaps].map = submap;
+  map->nsubmaps++;
+  if (map->nsubmaps > MIM_SUBMAP_LINEAR)
+    {
+      int size = map->submaps_size * 2;
+
+      if (! map->submap_index)
+	{
+	  MTABLE_CALLOC (map->submap_index, size, MERROR_IM);
+	  i = 0;
+	}
+      else
+	i = map->nsubmaps - 1;
+      for (; i < map->nsubmaps; i++)
+	{
+	  int j = MIM_SUBMAP_HASH (map->submaps[i].key, size);
+
+	  while (map->submap_index[j])
+	    j = (j + 1) & (size - 1);
+	  map->submap_index[j] = i + 1;
+	}
+    }
+  return submap;
+}
+
+/* Build MAP from its node in the compiled maps.  The deeper maps are
+   only allocated, and built when they are looked up.  */
+
+static void
+expand_map (MIMMap *map)
+{
+  MIMCompiled *compiled = map->compiled;
+  const int *node = compiled->words + map->node;
+  int nsubmaps, i;
+
+  map->compiled = NULL;
+  if (map->node <= 0 || map->node > compiled->length - 3
+      || (nsubmaps = node[2]) < 0
+      || nsubmaps > (compiled->length - map->node - 3) / 2)
+    return;
+  if (node[0])
+    map->map_actions = compiled_actions (compiled, node[0]);
+  if (node[1])
+    {
+      map->branch_actions = compiled_actions (compiled, node[1]);
+      if (map->branch_actions)
+	M17N_OBJECT_REF (map->branch_actions);
+    }
+  for (i = 0, node += 3; i < nsubmaps; i++, node += 2)
+    if (node[0] >= 0 && node[0] < compiled->nsymbols)
+      {
+	MIMMap *submap = add_submap (map, compiled->symbols[node[0]]);
+
+	submap->compiled = compiled;
+	submap->node = node[1];
+      }
+}
+
 static MPlist *
 resolve_command (MPlist *cmds, MSymbol command)
 {
@@ -1105,18 +1412,10 @@ load_translation (MIMMap *map, MPlist *keylist, MPlist *map_actions,
 
   for (i = 0; i < len; i++)
     {
-      MIMMap *deeper = NULL;
+      MIMMap *deeper = lookup_submap (map, keyseq[i]);
 
-      if (map->submaps)
-	deeper = mplist_get (map->submaps, keyseq[i]);
-      else
-	map->submaps = mplist ();
       if (! deeper)
-	{
-	  /* Fixme: It is better to make all deeper maps at once.  */
-	  MSTRUCT_CALLOC (deeper, MERROR_IM);
-	  mplist_put (map->submaps, keyseq[i], deeper);
-	}
+	deeper = add_submap (map, keyseq[i]);
       map = deeper;
     }
 
@@ -1172,7 +1471,7 @@ load_branch (MInputMethodInfo *im_info, MPlist *plist, MIMMap *map)
       if (branch_actions)
 	M17N_OBJECT_REF (branch_actions);
     }
-  else if (im_info->maps) 
+  else if (im_info_maps (im_info))
     {
       plist = (MPlist *) mplist_get (im_info->maps, map_name);
       if (! plist && im_info->configured_vars)
@@ -1310,16 +1609,16 @@ unload_external_module (MIMExternalModule *external)
 static void
 free_map (MIMMap *map, int top)
 {
-  MPlist *plist;
+  int i;
 
   if (top)
     M17N_OBJECT_UNREF (map->map_actions);
+  for (i = 0; i < map->nsubmaps; i++)
+    free_map (map->submaps[i].map, 0);
   if (map->submaps)
-    {
-      MPLIST_DO (plist, map->submaps)
-	free_map ((MIMMap *) MPLIST_VAL (plist), 0);
-      M17N_OBJECT_UNREF (map->submaps);
-    }
+    free (map->submaps);
+  if (map->submap_index)
+    free (map->submap_index);
   M17N_OBJECT_UNREF (map->branch_actions);
   free (map);
 }
@@ -1332,6 +1631,7 @@ free_state (void *object)
   M17N_OBJECT_UNREF (state->title);
   if (state->map)
     free_map (state->map, 1);
+  M17N_OBJECT_UNREF (state->compiled);
   free (state);
 }
 
@@ -1369,6 +1669,458 @@ load_state (MInputMethodInfo *im_info, MPlist *plist)
   return state;
 }
 
+/* Check if the maps of the states in PLIST (the data of an input
+   method) depend only on PLIST itself, i.e. PLIST includes nothing,
+   no map has command keys, and every map of a branch is defined
+   before the state.  Return 1 if so, otherwise return 0.  */
+
+static int
+maps_compilable (MPlist *plist)
+{
+  MPlist *map_names = mplist ();
+  int result = 1;
+
+  MPLIST_DO (plist, plist)
+    if (MPLIST_PLIST_P (plist) && MPLIST_SYMBOL_P (MPLIST_PLIST (plist)))
+      {
+	MPlist *elt = MPLIST_PLIST (plist), *pl, *p;
+	MSymbol key = MPLIST_SYMBOL (elt);
+
+	if (key == Minclude)
+	  result = 0;
+	else if (key == Mmap)
+	  MPLIST_DO (pl, MPLIST_NEXT (elt))
+	    {
+	      if (! MPLIST_PLIST_P (pl)
+		  || ! MPLIST_SYMBOL_P (MPLIST_PLIST (pl)))
+		continue;
+	      mplist_push (map_names, MPLIST_SYMBOL (MPLIST_PLIST (pl)), Mt);
+	      MPLIST_DO (p, MPLIST_NEXT (MPLIST_PLIST (pl)))
+		if (MPLIST_PLIST_P (p)
+		    && MPLIST_SYMBOL_P (MPLIST_PLIST (p)))
+		  result = 0;
+	    }
+	else if (key == Mstate)
+	  MPLIST_DO (pl, MPLIST_NEXT (elt))
+	    {
+	      if (! MPLIST_PLIST_P (pl))
+		continue;
+	      MPLIST_DO (p, MPLIST_NEXT (MPLIST_PLIST (pl)))
+		if (MPLIST_PLIST_P (p)
+		    && MPLIST_SYMBOL_P (MPLIST_PLIST (p)))
+		  {
+		    MSymbol map_name = MPLIST_SYMBOL (MPLIST_PLIST (p));
+
+		    if (map_name != Mnil && map_name != Mt
+			&& ! mplist_get (map_names, map_name))
+		      result = 0;
+		  }
+	    }
+	if (! result)
+	  break;
+      }
+  M17N_OBJECT_UNREF (map_names);
+  return result;
+}
+
+typedef struct
+{
+  MDBCacheBuffer buf;
+
+  /* Symbols referred by nodes.  */
+  MPlist *symbols;
+  int nsymbols;
+
+  /* Hash table of symbols and action lists already encoded.  VALS[I]
+     is the index of the symbol KEYS[I] in SYMBOLS, or the offset of
+     the action list KEYS[I].  SIZE is zero or a power of 2.  */
+  void **keys;
+  int *vals;
+  int size, used;
+} MIMCompileArg;
+
+/* Return the slot for KEY in the hash table of ARG.  If KEY is not
+   yet in the table, the slot is empty.  */
+
+static int
+compile_slot (MIMCompileArg *arg, void *key)
+{
+  int i;
+
+  if (arg->used * 2 >= arg->size)
+    {
+      void **keys = arg->keys;
+      int *vals = arg->vals;
+      int size = arg->size;
+
+      arg->size = size ? size * 2 : 256;
+      MTABLE_CALLOC (arg->keys, arg->size, MERROR_IM);
+      MTABLE_MALLOC (arg->vals, arg->size, MERROR_IM);
+      for (i = 0; i < size; i++)
+	if (keys[i])
+	  {
+	    int j = MIM_SUBMAP_HASH (keys[i], arg->size);
+
+	    while (arg->keys[j])
+	      j = (j + 1) & (arg->size - 1);
+	    arg->keys[j] = keys[i];
+	    arg->vals[j] = vals[i];
+	  }
+      free (keys);
+      free (vals);
+    }
+  i = MIM_SUBMAP_HASH (key, arg->size);
+  while (arg->keys[i] && arg->keys[i] != key)
+    i = (i + 1) & (arg->size - 1);
+  return i;
+}
+
+/* Encode the action list ACTIONS into ARG unless it's already done,
+   and return its offset.  Return -1 if ACTIONS can't be encoded.  */
+
+static int
+compile_actions (MIMCompileArg *arg, MPlist *actions)
+{
+  int i = compile_slot (arg, actions);
+
+  if (! arg->keys[i])
+    {
+      int offset = arg->buf.used;
+
+      if (mdatabase__cache_put_element (&arg->buf, Mplist, actions) < 0)
+	return -1;
+      arg->keys[i] = actions;
+      arg->vals[i] = offset;
+      arg->used++;
+    }
+  return arg->vals[i];
+}
+
+/* Encode MAP and its deeper maps into ARG, and return the offset of
+   the node of MAP.  Return -1 if MAP can't be encoded.  */
+
+static int
+compile_map (MIMCompileArg *arg, MIMMap *map)
+{
+  int *node;
+  int i;
+
+  if (map->compiled)
+    expand_map (map);
+  node = alloca (sizeof (int) * (3 + map->nsubmaps * 2));
+  node[0] = node[1] = 0;
+  if (map->map_actions
+      && (node[0] = compile_actions (arg, map->map_actions)) < 0)
+    return -1;
+  if (map->branch_actions
+      && (node[1] = compile_actions (arg, map->branch_actions)) < 0)
+    return -1;
+  node[2] = map->nsubmaps;
+  for (i = 0; i < map->nsubmaps; i++)
+    {
+      MSymbol key = map->submaps[i].key;
+      int j = compile_slot (arg, key);
+
+      if (! arg->keys[j])
+	{
+	  arg->keys[j] = key;
+	  arg->vals[j] = arg->nsymbols++;
+	  arg->used++;
+	  mplist_add (arg->symbols, Msymbol, key);
+	}
+      node[3 + i * 2] = arg->vals[j];
+      if ((node[4 + i * 2] = compile_map (arg, map->submaps[i].map)) < 0)
+	return -1;
+    }
+  i = arg->buf.used;
+  mdatabase__cache_put_words (&arg->buf, node,
+			      sizeof (int) * (3 + map->nsubmaps * 2));
+  return i;
+}
+
+/* Encode PLIST, the data of an input method, into ARG except for the
+   states, which are encoded by save_compiled_im () after PLIST is
+   loaded.  Return 0 on success, -1 on failure.  */
+
+static int
+compile_im_data (MIMCompileArg *arg, MPlist *plist)
+{
+  MPlist *data = mplist (), *maps = mplist ();
+  int zero = 0, i, result;
+
+  for (i = 0; i < MIM_CACHE_HEADER_LENGTH; i++)
+    mdatabase__cache_put_words (&arg->buf, &zero, sizeof (int));
+  MPLIST_DO (plist, plist)
+    {
+      MPlist *elt = MPLIST_PLIST_P (plist) ? MPLIST_PLIST (plist) : NULL;
+
+      if (elt && MPLIST_SYMBOL_P (elt) && MPLIST_SYMBOL (elt) == Mmap)
+	mplist_add (maps, Mplist, elt);
+      else if (! elt || ! MPLIST_SYMBOL_P (elt)
+	       || MPLIST_SYMBOL (elt) != Mstate)
+	mplist_add (data, MPLIST_KEY (plist), MPLIST_VAL (plist));
+    }
+  arg->buf.words[5] = arg->buf.used;
+  result = mdatabase__cache_put_element (&arg->buf, Mplist, data);
+  arg->buf.words[6] = arg->buf.used;
+  if (result == 0)
+    result = mdatabase__cache_put_element (&arg->buf, Mplist, maps);
+  M17N_OBJECT_UNREF (data);
+  M17N_OBJECT_UNREF (maps);
+  return result;
+}
+
+/* Compile the maps of the states of IM_INFO into ARG, and write ARG
+   into the cache file of IM_INFO->mdb.  Return 0 on success, -1 on
+   failure.  */
+
+static int
+save_compiled_im (MInputMethodInfo *im_info, MIMCompileArg *arg)
+{
+  MPlist *plist;
+  int nstates = MPLIST_LENGTH (im_info->states);
+  int *roots = alloca (sizeof (int) * (nstates + 1));
+  int i;
+
+  i = 0;
+  MPLIST_DO (plist, im_info->states)
+    {
+      MIMState *state = MPLIST_VAL (plist);
+
+      if ((roots[i++] = compile_map (arg, state->map)) < 0)
+	return -1;
+    }
+  arg->buf.words[0] = MIM_CACHE_FORMAT;
+  arg->buf.words[1] = arg->buf.used;
+  arg->buf.words[2] = arg->nsymbols;
+  MPLIST_DO (plist, arg->symbols)
+    mdatabase__cache_put_element (&arg->buf, Msymbol, MPLIST_SYMBOL (plist));
+  arg->buf.words[3] = arg->buf.used;
+  arg->buf.words[4] = nstates;
+  i = 0;
+  MPLIST_DO (plist, im_info->states)
+    {
+      MIMState *state = MPLIST_VAL (plist);
+      MText *title = NULL;
+      int err;
+
+      /* The title has the property Mlanguage, which is not encoded.  */
+      if (state->title)
+	title = mtext__from_data (MTEXT_DATA (state->title),
+				  mtext_nbytes (state->title),
+				  state->title->format, 1);
+      mdatabase__cache_put_element (&arg->buf, Msymbol, state->name);
+      err = mdatabase__cache_put_element (&arg->buf, title ? Mtext : Mnil,
+					  title);
+      M17N_OBJECT_UNREF (title);
+      if (err < 0)
+	return -1;
+      mdatabase__cache_put_words (&arg->buf, roots + i++, sizeof (int));
+    }
+  return mdatabase__save_cache (im_info->mdb, MIM_CACHE_SUFFIX, &arg->buf);
+}
+
+/* Decode the plist encoded at OFFSET of COMPILED.  Return NULL if it
+   is broken.  */
+
+static MPlist *
+compiled_plist (MIMCompiled *compiled, int offset)
+{
+  const int *p = compiled->words + offset;
+  MSymbol key;
+  void *val;
+
+  if (offset < MIM_CACHE_HEADER_LENGTH || offset >= compiled->length
+      || mdatabase__cache_get_element (&p, compiled->words + compiled->length,
+				       &key, &val) < 0)
+    return NULL;
+  if (key == Mplist)
+    return val;
+  if (key == Mtext)
+    M17N_OBJECT_UNREF (val);
+  else if (key == Mstring)
+    free (val);
+  return NULL;
+}
+
+/* Load the data of IM_INFO from the cache file of IM_INFO->mdb, keep
+   it in IM_INFO->compiled, and return the plist of the data except
+   for the map and state sections.  If KEY is not Mnil, the plist
+   contains only the sections of KEY.  If STATES is not NULL, store
+   the list of the states in *STATES; their maps are built by
+   expand_compiled_states () after the plist is loaded.  Return NULL
+   if there's no valid cache file.  */
+
+static MPlist *
+load_compiled_im (MInputMethodInfo *im_info, MSymbol key, MPlist **states)
+{
+  MIMCompiled *compiled;
+  MPlist *plist = NULL, *pl;
+  const int *words, *p, *end;
+  int length, i;
+  MSymbol elt_key;
+  void *val;
+
+  if (states)
+    *states = NULL;
+  M17N_OBJECT_UNREF (im_info->compiled);
+  im_info->compiled = NULL;
+  if (! im_info->mdb
+      || ! (words = mdatabase__load_cache (im_info->mdb, MIM_CACHE_SUFFIX,
+					   &length)))
+    return NULL;
+  M17N_OBJECT (compiled, free_compiled_maps, MERROR_IM);
+  compiled->words = words;
+  compiled->length = length;
+  end = words + length;
+  if (length < MIM_CACHE_HEADER_LENGTH || words[0] != MIM_CACHE_FORMAT
+      || words[1] < MIM_CACHE_HEADER_LENGTH || words[1] > length
+      || words[2] < 0 || words[2] > length
+      || words[3] < MIM_CACHE_HEADER_LENGTH || words[3] > length
+      || words[4] < 0 || words[4] > length
+      || ! (plist = compiled_plist (compiled, words[5])))
+    goto err;
+  if (key != Mnil)
+    {
+      for (pl = plist; ! MPLIST_TAIL_P (pl);)
+	if (MPLIST_PLIST_P (pl)
+	    && MPLIST_SYMBOL_P (MPLIST_PLIST (pl))
+	    && MPLIST_SYMBOL (MPLIST_PLIST (pl)) == key)
+	  pl = MPLIST_NEXT (pl);
+	else
+	  mplist__pop_unref (pl);
+    }
+  if (states)
+    {
+      compiled->nsymbols = words[2];
+      MTABLE_MALLOC (compiled->symbols, compiled->nsymbols + 1, MERROR_IM);
+      for (i = 0, p = words + words[1]; i < compiled->nsymbols; i++)
+	{
+	  if (mdatabase__cache_get_element (&p, end, &elt_key, &val) < 0
+	      || elt_key != Msymbol)
+	    goto err;
+	  compiled->symbols[i] = val;
+	}
+      *states = mplist ();
+      for (i = 0, p = words + words[3]; i < words[4]; i++)
+	{
+	  MIMState *state;
+	  MSymbol name;
+	  MText *title;
+
+	  if (mdatabase__cache_get_element (&p, end, &elt_key, &val) < 0
+	      || elt_key != Msymbol)
+	    goto err;
+	  name = val;
+	  if (mdatabase__cache_get_element (&p, end, &elt_key, &val) < 0
+	      || (elt_key != Mtext && elt_key != Mnil))
+	    goto err;
+	  title = val;
+	  if (p == end)
+	    {
+	      M17N_OBJECT_UNREF (title);
+	      goto err;
+	    }
+	  M17N_OBJECT (state, free_state, MERROR_IM);
+	  state->name = name;
+	  state->title = title;
+	  if (title)
+	    mtext_put_prop (title, 0, mtext_nchars (title),
+			    Mlanguage, im_info->language);
+	  MSTRUCT_CALLOC (state->map, MERROR_IM);
+	  state->map->compiled = compiled;
+	  state->map->node = *p++;
+	  state->compiled = compiled;
+	  M17N_OBJECT_REF (compiled);
+	  mplist_add (*states, name, state);
+	}
+    }
+  im_info->compiled = compiled;
+  return plist;
+
+ err:
+  if (states && *states)
+    {
+      MPLIST_DO (pl, *states)
+	M17N_OBJECT_UNREF (MPLIST_VAL (pl));
+      M17N_OBJECT_UNREF (*states);
+      *states = NULL;
+    }
+  M17N_OBJECT_UNREF (plist);
+  M17N_OBJECT_UNREF (compiled);
+  return NULL;
+}
+
+/* Build the root maps of the states of IM_INFO loaded by
+   load_compiled_im ().  The actions of the maps are validated with
+   the macros of IM_INFO.  */
+
+static void
+expand_compiled_states (MInputMethodInfo *im_info)
+{
+  MIMCompiled *compiled = im_info->compiled;
+  MPlist *plist;
+
+  if (! compiled)
+    return;
+  M17N_OBJECT_UNREF (compiled->macros);
+  compiled->macros = im_info->macros;
+  if (compiled->macros)
+    M17N_OBJECT_REF (compiled->macros);
+  MPLIST_DO (plist, im_info->states)
+    {
+      MIMState *state = MPLIST_VAL (plist);
+
+      if (state->map->compiled)
+	{
+	  expand_map (state->map);
+	  if (state->map->map_actions)
+	    M17N_OBJECT_REF (state->map->map_actions);
+	}
+    }
+}
+
+/* Add the maps of ELT, a map section of the form (map (NAME RULE
+   ...) ...), to IM_INFO->maps.  */
+
+static void
+load_maps (MInputMethodInfo *im_info, MPlist *elt)
+{
+  MPlist *pl = mplist__from_alist (MPLIST_NEXT (elt));
+
+  if (MFAILP (pl))
+    return;
+  if (! im_info->maps)
+    im_info->maps = pl;
+  else
+    {
+      mplist__conc (im_info->maps, pl);
+      M17N_OBJECT_UNREF (pl);
+    }
+}
+
+/* Return IM_INFO->maps.  If IM_INFO was loaded from compiled data,
+   the maps are loaded from it at first.  */
+
+static MPlist *
+im_info_maps (MInputMethodInfo *im_info)
+{
+  if (! im_info->maps && im_info->compiled)
+    {
+      MPlist *maps = compiled_plist (im_info->compiled,
+				     im_info->compiled->words[6]);
+      MPlist *plist;
+
+      if (! maps)
+	return NULL;
+      MPLIST_DO (plist, maps)
+	if (MPLIST_PLIST_P (plist))
+	  load_maps (im_info, MPLIST_PLIST (plist));
+      M17N_OBJECT_UNREF (maps);
+    }
+  return im_info->maps;
+}
+
 /* Return a newly created IM_INFO for an input method specified by
    LANUAGE, NAME, and EXTRA.  IM_INFO is stored in PLIST.  */
 
@@ -1462,6 +2214,7 @@ free_im_info (MInputMethodInfo *im_info)
   MDEBUG_PRINT2 ("freeing %s-%s\n", msymbol_name (im_info->language),
 		 msymbol_name (im_info->name));
   fini_im_info (im_info);
+  M17N_OBJECT_UNREF (im_info->compiled);
   free (im_info);
 }
 
@@ -1503,7 +2256,7 @@ lookup_im_info (MPlist *plist, MSymbol language, MSymbol name, MSymbol extra)
   return NULL;
 }
 
-static void load_im_info (MPlist *, MInputMethodInfo *);
+static void load_im_info (MPlist *, MInputMethodInfo *, MPlist *);
 
 #define get_custom_info(im_info)				\
   (im_custom_list						\
@@ -1584,7 +2337,7 @@ update_custom_info (void)
       if (language == Mnil || (name == Mnil && extra == Mnil))
 	continue;
       im_info = new_im_info (NULL, language, name, extra, im_custom_list);
-      load_im_info (im_data, im_info);
+      load_im_info (im_data, im_info, NULL);
     }
   M17N_OBJECT_UNREF (plist);
   return 0;
@@ -1615,7 +2368,7 @@ update_global_info (void)
       || ! (plist = mdatabase_load (global_info->mdb)))
     return -1;
 
-  load_im_info (plist, global_info);
+  load_im_info (plist, global_info, NULL);
   M17N_OBJECT_UNREF (plist);
   return 0;
 }
@@ -1629,7 +2382,7 @@ update_global_info (void)
 static MInputMethodInfo *
 get_im_info (MSymbol language, MSymbol name, MSymbol extra, MSymbol key)
 {
-  MPlist *plist;
+  MPlist *plist, *states = NULL;
   MInputMethodInfo *im_info;
   MDatabase *mdb;
 
@@ -1658,9 +2411,11 @@ get_im_info (MSymbol language, MSymbol name, MSymbol extra, MSymbol key)
 
   if (key == Mnil)
     {
-      plist = mdatabase_load (im_info->mdb);
+      plist = load_compiled_im (im_info, Mnil, &states);
+      if (! plist)
+	plist = mdatabase_load (im_info->mdb);
     }
-  else
+  else if (! (plist = load_compiled_im (im_info, key, NULL)))
     {
       mplist_push (load_im_info_keys, key, Mt);
       plist = mdatabase__load_for_keys (im_info->mdb, load_im_info_keys);
@@ -1670,8 +2425,10 @@ get_im_info (MSymbol language, MSymbol name, MSymbol extra, MSymbol key)
   if (! plist)
     MERROR (MERROR_IM, im_info);
   update_global_info ();
-  load_im_info (plist, im_info);
+  load_im_info (plist, im_info, states);
   M17N_OBJECT_UNREF (plist);
+  if (states)
+    expand_compiled_states (im_info);
   if (key == Mnil)
     {
       if (! im_info->cmds)
@@ -1698,19 +2455,23 @@ static int
 reload_im_info (MInputMethodInfo *im_info)
 {
   int check;
-  MPlist *plist;
+  MPlist *plist, *states = NULL;
 
   update_custom_info ();
   update_global_info ();
   check = mdatabase__check (im_info->mdb);
   if (check < 0)
     return -1;
-  plist = mdatabase_load (im_info->mdb);
+  plist = load_compiled_im (im_info, Mnil, &states);
+  if (! plist)
+    plist = mdatabase_load (im_info->mdb);
   if (! plist)
     return -1;
   fini_im_info (im_info);
-  load_im_info (plist, im_info);
+  load_im_info (plist, im_info, states);
   M17N_OBJECT_UNREF (plist);
+  if (states)
+    expand_compiled_states (im_info);
   if (! im_info->cmds)
     im_info->cmds = mplist ();
   if (! im_info->vars)
@@ -2308,11 +3069,12 @@ config_all_variables (MInputMethodInfo *im_info)
     }
 }
 
-/* Load an input method (LANGUAGE NAME) from PLIST into IM_INFO.
-   CONFIG contains configuration information of the input method.  */
+/* Load an input method (LANGUAGE NAME) from PLIST into IM_INFO.  If
+   STATES is not NULL, it is a list of the states compiled from PLIST,
+   and the states in PLIST are ignored.  */
 
 static void
-load_im_info (MPlist *plist, MInputMethodInfo *im_info)
+load_im_info (MPlist *plist, MInputMethodInfo *im_info, MPlist *states)
 {
   MPlist *pl, *p;
 
@@ -2352,18 +3114,7 @@ load_im_info (MPlist *plist, MInputMethodInfo *im_info)
 	    M17N_OBJECT_REF (im_info->title);
 	  }
 	else if (key == Mmap)
-	  {
-	    pl = mplist__from_alist (MPLIST_NEXT (elt));
-	    if (MFAILP (pl))
-	      continue;
-	    if (! im_info->maps)
-	      im_info->maps = pl;
-	    else
-	      {
-		mplist__conc (im_info->maps, pl);
-		M17N_OBJECT_UNREF (pl);
-	      }
-	  }
+	  load_maps (im_info, elt);
 	else if (key == Mmacro)
 	  {
 	    if (! im_info->macros)
@@ -2392,6 +3143,8 @@ load_im_info (MPlist *plist, MInputMethodInfo *im_info)
 	  }
 	else if (key == Mstate)
 	  {
+	    if (states)
+	      continue;
 	    MPLIST_DO (elt, MPLIST_NEXT (elt))
 	      {
 		MIMState *state;
@@ -2426,7 +3179,7 @@ load_im_info (MPlist *plist, MInputMethodInfo *im_info)
 	    elt = MPLIST_NEXT (elt);
 	    if (key == Mmap)
 	      {
-		if (! temp->maps || MPLIST_TAIL_P (temp->maps))
+		if (! im_info_maps (temp) || MPLIST_TAIL_P (temp->maps))
 		  continue;
 		if (! im_info->maps)
 		  im_info->maps = mplist ();
@@ -2476,6 +3229,8 @@ load_im_info (MPlist *plist, MInputMethodInfo *im_info)
 	    M17N_OBJECT_REF (im_info->description);
 	  }
       }
+  if (states)
+    im_info->states = states;
   if (im_info->macros)
     {
       MPLIST_DO (pl, im_info->macros)
@@ -3342,7 +4097,9 @@ take_action_list (MInputContext *ic, MPlist *action_list)
 		ic_info->key_head = 0;
 	      else
 		ic_info->key_head = - num;
-	      if (ic_info->key_head > ic_info->used)
+	      if (ic_info->key_head < 0)
+		ic_info->key_head = 0;
+	      else if (ic_info->key_head > ic_info->used)
 		ic_info->key_head = ic_info->used;
 	    }
 	  else if (MPLIST_MTEXT_P (args))
@@ -3604,9 +4361,9 @@ handle_key (MInputContext *ic)
   MInputMethodInfo *im_info = (MInputMethodInfo *) ic->im->info;
   MInputContextInfo *ic_info = (MInputContextInfo *) ic->info;
   MIMMap *map = ic_info->map;
-  MIMMap *submap = NULL;
+  MIMMap *submap;
   MSymbol key = ic_info->keys[ic_info->key_head];
-  MSymbol alias = Mnil;
+  MSymbol alias;
   int result;
   int i;
 
@@ -3632,15 +4389,7 @@ handle_key (MInputContext *ic)
 		 MSYMBOL_NAME (im_info->name),
 		 MSYMBOL_NAME (ic_info->state->name), msymbol_name (key));
 
-  if (map->submaps)
-    {
-      submap = mplist_get (map->submaps, key);
-      alias = key;
-      while (! submap
-	     && (alias = msymbol_get (alias, M_key_alias))
-	     && alias != key)
-	submap = mplist_get (map->submaps, alias);
-    }
+  submap = lookup_submap_with_alias (map, key, &alias);
 
   if (submap)
     {
@@ -3663,7 +4412,7 @@ handle_key (MInputContext *ic)
 	      return result;
 	    }
 	}
-      else if (map->submaps)
+      else if (map->nsubmaps > 0)
 	{
 	  for (i = ic_info->state_key_head; i < ic_info->key_head; i++)
 	    {
@@ -3677,7 +4426,7 @@ handle_key (MInputContext *ic)
 
       /* If this is the terminal map or we have shifted to another
 	 state, perform branch actions (if any).  */
-      if (! map->submaps || map != ic_info->map)
+      if (map->nsubmaps == 0 || map != ic_info->map)
 	{
 	  if (map->branch_actions)
 	    {
@@ -4139,20 +4888,11 @@ check_fallback (MInputContext *ic, MSymbol key)
 
   MPLIST_DO (plist, ic_info->fallbacks)
     {
-      MSymbol alias = key;
       MInputContext *this_ic = (MInputContext *) MPLIST_VAL (plist);
       MInputMethodInfo *this_im_info = (MInputMethodInfo * )this_ic->im->info;
       MIMMap *map = ((MIMState *) MPLIST_VAL (this_im_info->states))->map;
-      MIMMap *submap;
-      
-      if (! map->submaps)
-	continue;
-      submap = mplist_get (map->submaps, key);
-      while (! submap
-	     && (alias = msymbol_get (alias, M_key_alias))
-	     && alias != key)
-	submap = mplist_get (map->submaps, alias);
-      if (submap)
+
+      if (lookup_submap_with_alias (map, key, NULL))
 	return this_ic;
     }
   return NULL;
@@ -4366,26 +5106,24 @@ lookup (MInputContext *ic, MSymbol key, void *arg, MText *mt)
 /* Support functions for mdebug_dump_im.  */
 
 static void
-dump_im_map (MPlist *map_list, int indent)
+dump_im_map (MSymbol key, MIMMap *map, int indent)
 {
   char *prefix;
-  MSymbol key = MPLIST_KEY (map_list);
-  MIMMap *map = (MIMMap *) MPLIST_VAL (map_list);
+  int i;
 
   prefix = (char *) alloca (indent + 1);
   memset (prefix, 32, indent);
   prefix[indent] = '\0';
 
+  if (map->compiled)
+    expand_map (map);
   fprintf (mdebug__output, "(\"%s\" ", msymbol_name (key));
   if (map->map_actions)
     mdebug_dump_plist (map->map_actions, indent + 2);
-  if (map->submaps)
+  for (i = 0; i < map->nsubmaps; i++)
     {
-      MPLIST_DO (map_list, map->submaps)
-	{
-	  fprintf (mdebug__output, "\n%s  ", prefix);
-	  dump_im_map (map_list, indent + 2);
-	}
+      fprintf (mdebug__output, "\n%s  ", prefix);
+      dump_im_map (map->submaps[i].key, map->submaps[i].map, indent + 2);
     }
   if (map->branch_actions)
     {
@@ -4401,20 +5139,18 @@ static void
 dump_im_state (MIMState *state, int indent)
 {
   char *prefix;
-  MPlist *map_list;
+  int i;
 
   prefix = (char *) alloca (indent + 1);
   memset (prefix, 32, indent);
   prefix[indent] = '\0';
 
   fprintf (mdebug__output, "(%s", msymbol_name (state->name));
-  if (state->map->submaps)
+  for (i = 0; i < state->map->nsubmaps; i++)
     {
-      MPLIST_DO (map_list, state->map->submaps)
-	{
-	  fprintf (mdebug__output, "\n%s  ", prefix);
-	  dump_im_map (map_list, indent + 2);
-	}
+      fprintf (mdebug__output, "\n%s  ", prefix);
+      dump_im_map (state->map->submaps[i].key, state->map->submaps[i].map,
+		   indent + 2);
     }
   fprintf (mdebug__output, ")");
 }
@@ -6291,6 +7027,111 @@ minput_save_config (void)
   return (ret < 0 ? -1 : 1);
 }
 
+/*=*/
+
+/***en
+    @brief Compile an input method into a cache file.
+
+    The minput_compile_im () function compiles the input method
+    specified by $LANGUAGE and $NAME, i.e. its data and the key maps
+    of its states, and writes them into a binary cache file named
+    ".FILE.mimc" in the same directory as the file FILE of the input
+    method.  From then on, as long as FILE is not modified and the
+    version of the m17n library is not changed, minput_open_im ()
+    reads the input method from the cache file instead of parsing
+    FILE, and each map is built only when it is reached by a key.  So
+    the time to open the input method doesn't depend on the size of
+    its maps.
+
+    An input method whose maps depend on other data (i.e. it includes
+    another input method, has a map that contains command keys, or
+    has a branch whose map is not defined before the state) is not
+    compiled.
+
+    @return
+    If the input method was compiled, 1 is returned.  If it can't be
+    compiled, 0 is returned.  Otherwise, -1 is returned and
+    the external variable #merror_code is set to an error code.  */
+/***ja
+    @brief ϥ᥽åɤ򥭥åե˥ѥ뤹.
+
+    ؿ minput_compile_im ()  $LANGUAGE  $NAME ǻꤵ
+    ᥽åɡʤΥǡȳƾ֤Υޥåפ򥳥ѥ뤷
+    ϥ᥽åɤΥե FILE Ʊǥ쥯ȥˤ
+    ".FILE.mimc" Ȥ̾ΥХʥΥåե˽񤭽Ф
+    ʸ塢FILE ѹ줺 m17n 饤֥ΥСѤʤ
+    ꡢminput_open_im ()  FILE ϤˤΥåե
+    뤫ϥ᥽åɤɤߡƥޥåפϥˤäã줿Ȥ
+    ƺ롣äϥ᥽åɤ򳫤֤ϥޥåפ礭
+    ¸ʤ
+
+    ޥåפ¾Υǡ˰¸ϥ᥽åɡ¾ϥ᥽åɤ
+    ࡢޥɤΥޤޥåפġ뤤Ϥξ֤
+    Ƥʤޥåפʬ˻ĤΡˤϥѥ뤵ʤ
+
+    @return
+    ϥ᥽åɤѥ뤵 1 ֤ѥǤʤ
+    0 ֤ʳξ -1 ֤ѿ
+    #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_IM
+
+    @seealso
+    mdatabase_compile ()  */
+
+int
+minput_compile_im (MSymbol language, MSymbol name)
+{
+  MDatabase *mdb;
+  MPlist *plist;
+  MInputMethodInfo *im_info;
+  MIMCompileArg arg;
+  int result;
+
+  MINPUT__INIT ();
+  mdb = mdatabase_find (Minput_method, language, name, Mnil);
+  if (! mdb)
+    MERROR (MERROR_IM, -1);
+  plist = mdatabase_load (mdb);
+  if (! plist)
+    MERROR (MERROR_IM, -1);
+  if (! maps_compilable (plist))
+    {
+      M17N_OBJECT_UNREF (plist);
+      return 0;
+    }
+  memset (&arg, 0, sizeof arg);
+  arg.symbols = mplist ();
+  /* PLIST must be encoded before load_im_info () modifies it.  */
+  if (compile_im_data (&arg, plist) < 0)
+    result = 0;
+  else
+    {
+      /* Load the input method into a temporary IM_INFO so that the
+	 maps are not yet modified by input contexts.  */
+      MSTRUCT_CALLOC (im_info, MERROR_IM);
+      im_info->mdb = mdb;
+      im_info->language = language;
+      im_info->name = name;
+      im_info->extra = Mnil;
+      update_global_info ();
+      load_im_info (plist, im_info, NULL);
+      result = (! im_info->states ? 0
+		: save_compiled_im (im_info, &arg) < 0 ? -1 : 1);
+      free_im_info (im_info);
+    }
+  M17N_OBJECT_UNREF (plist);
+  M17N_OBJECT_UNREF (arg.symbols);
+  free (arg.keys);
+  free (arg.vals);
+  free (arg.buf.words);
+  if (result < 0)
+    MERROR (MERROR_IM, -1);
+  return result;
+}
+
 /***en
     @brief List available input methods.
 
@@ -6411,7 +7252,7 @@ minput_list (MSymbol language)
 		key = MPLIST_SYMBOL (elt);
 		if (key == Mmap)
 		  {
-		    if (! im_info->maps)
+		    if (! im_info_maps (im_info))
 		      break;
 		    num_maps++;
 		  }
@@ -25,6 +25,8 @@
 
 typedef struct _MInputMethodInfo MInputMethodInfo;
 
+typedef struct MIMCompiled MIMCompiled;
+
 struct _MInputMethodInfo
 {
   MDatabase *mdb;
@@ -34,6 +36,9 @@ struct _MInputMethodInfo
   MText *description;
   MText *title;
   MPlist *maps;
+  /* Compiled data the input method was loaded from, or NULL.  If not
+     NULL, MAPS is loaded from it on demand.  */
+  MIMCompiled *compiled;
   MPlist *states;
   MPlist *macros;
   MPlist *externals;
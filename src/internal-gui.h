@@ -60,8 +60,9 @@ struct MFrame
       descent of ASCII font of the default face.  */
   int ascent, descent;
 
-  /** Initialized to 0 and incremented on each modification of a face
-      on which one of the realized faces is based.  */
+  /** Updated by MFRAME_NEW_TICK () on creation of the frame and on
+      each modification of a face on which one of the realized faces
+      is based.  */
   unsigned tick;
 
   /** Pointer to device dependent information associated with the
@@ -86,8 +87,15 @@ struct MFrame
   /** List of realized fonts.  */
   MPlist *realized_font_list;
 
-  /** List of realized faces.  */
-  MPlist *realized_face_list;
+  /** Hash table of the realized faces created on this frame.  */
+  struct MRealizedFaceTable *realized_face_table;
+
+  /** Budget of the layout cache in bytes.  If zero, the cache is not
+      used.  */
+  int layout_cache_size;
+
+  /** Cache of glyph strings keyed by the contents of a line.  */
+  struct MLayoutCache *layout_cache;
 
   /** List of realized fontsets.  */
   MPlist *realized_fontset_list;
@@ -250,6 +258,13 @@ struct MDeviceDriver
 
 extern MSymbol Mlatin;
 
+/** Ticks are taken from a counter common to all frames so that a
+    glyph string made for a freed frame never matches a new frame
+    allocated at the same address.  */
+extern unsigned mframe__tick;
+
+#define MFRAME_NEW_TICK(frame) ((frame)->tick = ++mframe__tick)
+
 extern MSymbol Mgd;
 
 extern int mfont__init ();
@@ -260,6 +275,11 @@ extern void mface__fini ();
 
 extern int mdraw__init ();
 extern void mdraw__fini ();
+extern void mdraw__free_layout_cache (MFrame *frame);
+
+extern int mraw__device_init ();
+extern int mraw__device_fini ();
+extern int mraw__device_open (MFrame *frame, MPlist *param);
 
 extern int mfont__fontset_init ();
 extern void mfont__fontset_fini ();
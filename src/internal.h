@@ -75,6 +75,45 @@ extern int mdebug_hook ();
 
 #define MFAILP(cond) ((cond) ? 0 : mdebug_hook ())
 
+
+/** Thread support.  If the library is compiled with the macro
+    M17N_THREAD_SAFE defined, symbols can be interned, managed objects
+    can be referenced and unreferenced, and intervals of text
+    properties can be allocated concurrently by multiple threads, and
+    merror_code is local to each thread.  Otherwise, these macros are
+    no-ops.  */
+
+#ifdef M17N_THREAD_SAFE
+
+#include <pthread.h>
+
+#define M17N_THREAD_LOCAL __thread
+
+/** Define a mutex NAME statically.  */
+#define M17N_MUTEX(name) \
+  static pthread_mutex_t name = PTHREAD_MUTEX_INITIALIZER;
+
+#define M17N_LOCK(mutex) pthread_mutex_lock (&(mutex))
+
+#define M17N_UNLOCK(mutex) pthread_mutex_unlock (&(mutex))
+
+/** Read and write a flag that tells another thread has finished
+    initializing something.  */
+#define M17N_LOAD_ACQUIRE(var) __atomic_load_n (&(var), __ATOMIC_ACQUIRE)
+#define M17N_STORE_RELEASE(var, val) \
+  __atomic_store_n (&(var), (val), __ATOMIC_RELEASE)
+
+#else  /* not M17N_THREAD_SAFE */
+
+#define M17N_THREAD_LOCAL
+#define M17N_MUTEX(name)
+#define M17N_LOCK(mutex) ((void) 0)
+#define M17N_UNLOCK(mutex) ((void) 0)
+#define M17N_LOAD_ACQUIRE(var) (var)
+#define M17N_STORE_RELEASE(var, val) ((var) = (val))
+
+#endif /* not M17N_THREAD_SAFE */
+
 #define M_CHECK_CHAR(c, ret)		\
   if ((c) < 0 || (c) > MCHAR_MAX)	\
     MERROR (MERROR_CHAR, (ret));	\
@@ -331,6 +370,33 @@ typedef struct
   } while (0)
 
 
+#ifdef M17N_THREAD_SAFE
+
+/* The reference count of a managed object is updated atomically by
+   these functions.  They don't touch an object whose reference count
+   is 0.  m17n__object_unref () returns 0 if it has freed OBJECT.  */
+
+extern void m17n__object_ref (void *object);
+extern int m17n__object_unref (void *object);
+
+#define M17N_OBJECT_REF(object) m17n__object_ref (object)
+
+#define M17N_OBJECT_REF_NTIMES(object, n)	\
+  do {						\
+    int i;					\
+						\
+    for (i = 0; i < n; i++)			\
+      m17n__object_ref (object);		\
+  } while (0)
+
+#define M17N_OBJECT_UNREF(object)				\
+  do {								\
+    if ((object) && m17n__object_unref (object) == 0)		\
+      (object) = NULL;						\
+  } while (0)
+
+#else  /* not M17N_THREAD_SAFE */
+
 /**en Increment the reference count of OBJECT if the count is not
    0.  */
 /**ja OBJECT λȿ 0 Ǥʤ 1 䤹.  */
@@ -405,6 +471,8 @@ typedef struct
       }									\
   } while (0)
 
+#endif /* not M17N_THREAD_SAFE */
+
 typedef struct _M17NObjectArray M17NObjectArray;
 
 struct _M17NObjectArray
@@ -478,6 +546,18 @@ struct MText
   /**en Caches of the character position and the corresponding byte position. */
   /**ja ʸ֤бХȰ֤Υå */
   int cache_char_pos, cache_byte_pos;
+
+  /** Sparse index of unit positions of every Nth character (see
+      POS_INDEX_INTERVAL in mtext.c), built lazily for a long M-text.
+      The first <pos_index_used> elements are valid.  */
+  int *pos_index;
+  int pos_index_used, pos_index_size;
+
+  /** If <data> is borrowed from the caller of
+      mtext_from_external_data (), a function to call with <data> and
+      <release_arg> when the M-text stops referring to <data>.  */
+  void (*release) (void *data, void *arg);
+  void *release_arg;
 };
 
 /** short description of M_CHECK_POS */
@@ -528,10 +608,20 @@ struct MText
 
 #define MTEXT_READ_ONLY_P(mt) ((mt)->allocated < 0)
 
+/** Nonzero iff the data of MT is borrowed from the caller of
+    mtext_from_external_data () and not yet copied.  */
+
+#define MTEXT_BORROWED_P(mt) ((mt)->allocated == 0 && (mt)->data)
+
+/** Check if MT is modifiable.  If the data of MT is borrowed, make a
+    copy of it before MT is modified.  */
+
 #define M_CHECK_READONLY(mt, ret)	\
   do {					\
     if ((mt)->allocated < 0)		\
       MERROR (MERROR_MTEXT, (ret));	\
+    if (MTEXT_BORROWED_P (mt))		\
+      mtext__enlarge ((mt), 0);		\
   } while (0)
 
 #define mtext_nchars(mt) ((mt)->nchars)
@@ -555,6 +645,7 @@ enum MDebugFlag
     MDEBUG_FLT,
     MDEBUG_FONTSET,
     MDEBUG_INPUT,
+    MDEBUG_DRAW,
     MDEBUG_ALL,
     MDEBUG_MAX = MDEBUG_ALL
   };
@@ -228,7 +228,7 @@ get_xfrm (MText *mt)
 
   if (prop)
     {
-      if (prop->end == mt->nchars)
+      if (MTEXTPROP_END (prop) == mt->nchars)
 	{
 	  xfrm = (MXfrm *) prop->val;
 	  if (xfrm->locale == mlocale__ctype)
@@ -148,9 +148,6 @@ typedef struct
   XftDraw *xft_draw;
 #endif
 
-  /** List of pointers to realized faces on the frame.  */
-  MPlist *realized_face_list;
-
   /* List of single element whose value is a root of chain of realized
      fonts.  */
   MPlist *realized_font_list;
@@ -218,15 +215,6 @@ free_device (void *object)
     mfont__free_realized (MPLIST_VAL (device->realized_font_list));
   M17N_OBJECT_UNREF (device->realized_font_list);
 
-  MPLIST_DO (plist, device->realized_face_list)
-    {
-      MRealizedFace *rface = MPLIST_VAL (plist);
-
-      free (rface->info);
-      mface__free_realized (rface);
-    }
-  M17N_OBJECT_UNREF (device->realized_face_list);
-
   MPLIST_DO (plist, device->gc_list)
     {
       XFreeGC (device->display_info->display,
@@ -2319,7 +2307,6 @@ device_open (MFrame *frame, MPlist *param)
       pixels = DisplayHeight (display, screen_num);
       mm = DisplayHeightMM (display, screen_num);
       device->resy = (mm < 1) ? 100 : pixels * 25.4 / mm;
-      device->realized_face_list = mplist ();
       device->realized_font_list = mplist ();
       mplist_add (device->realized_font_list, Mt, NULL);
       device->realized_fontset_list = mplist ();
@@ -2354,7 +2341,6 @@ device_open (MFrame *frame, MPlist *param)
     mplist_add (frame->font_driver_list, Mx, &xfont_driver);
 
   frame->realized_font_list = device->realized_font_list;
-  frame->realized_face_list = device->realized_face_list;
   frame->realized_fontset_list = device->realized_fontset_list;
 
   if (widget)
@@ -465,8 +465,179 @@ report_object_array ()
 
 
 
+/* Increment the reference count of OBJ.  Return the resulting count
+   if it fits in 16 bits, -1 otherwise.  */
+
+static int
+ref_object (M17NObject *obj)
+{
+  M17NObjectRecord *record;
+  unsigned *count;
+
+  if (! obj->ref_count_extended)
+    {
+      if (++obj->ref_count)
+	return (int) obj->ref_count;
+      MSTRUCT_MALLOC (record, MERROR_OBJECT);
+      record->freer = obj->u.freer;
+      MLIST_INIT1 (record, counts, 1);
+      MLIST_APPEND1 (record, counts, 0, MERROR_OBJECT);
+      obj->u.record = record;
+      obj->ref_count_extended = 1;
+    }
+  else
+    record = obj->u.record;
+
+  count = record->counts;
+  while (*count == 0xFFFFFFFF)
+    *(count++) = 0;
+  (*count)++;
+  if (*count == 0xFFFFFFFF)
+    MLIST_APPEND1 (record, counts, 0, MERROR_OBJECT);
+  return -1;
+}
+
+/* Decrement the reference count of OBJ, and free OBJ if the count
+   becomes 0.  Return the resulting count if it fits in 16 bits, -1
+   otherwise.  */
+
+static int
+unref_object (M17NObject *obj)
+{
+  M17NObjectRecord *record;
+  unsigned *count;
+
+  if (! obj->ref_count_extended)
+    {
+      if (! --obj->ref_count)
+	{
+	  if (obj->u.freer)
+	    (obj->u.freer) (obj);
+	  else
+	    free (obj);
+	  return 0;
+	}
+      return (int) obj->ref_count;
+    }
+
+  record = obj->u.record;
+  count = record->counts;
+  while (! *count)
+    *(count++) = 0xFFFFFFFF;
+  (*count)--;
+  if (! record->counts[0])
+    {
+      obj->ref_count_extended = 0;
+      obj->ref_count--;
+      obj->u.freer = record->freer;
+      MLIST_FREE1 (record, counts);
+      free (record);
+    }
+  return -1;
+}
+
+#ifdef M17N_THREAD_SAFE
+
+/* Lock for the reference counts that can't be updated atomically.  */
+M17N_MUTEX (object_lock)
+
+/* Nonzero if the reference count of OBJ must be updated while
+   holding object_lock.  */
+#define REF_COUNT_LOCKED_P(obj) \
+  ((obj)->ref_count_extended || (obj)->ref_count == 0xFFFF)
+
+/* Add DELTA (1 or -1) to the reference count of OBJ atomically.  The
+   count shares the first word of OBJ with the other bit fields, and
+   the word is updated by compare-and-swap.  Return the resulting
+   count.  If the count is 0 and DELTA is -1 or SKIP_ZERO is nonzero,
+   return -2 without updating it.  If the count must be updated while
+   holding object_lock, return -1.  */
+
+static int
+add_ref_count (M17NObject *obj, int delta, int skip_zero)
+{
+  unsigned *word = (unsigned *) obj;
+  unsigned old_word = __atomic_load_n (word, __ATOMIC_RELAXED);
+  unsigned new_word;
+  M17NObject header;
+
+  do
+    {
+      memcpy (&header, &old_word, sizeof old_word);
+      if (REF_COUNT_LOCKED_P (&header))
+	return -1;
+      if (header.ref_count == 0 && (delta < 0 || skip_zero))
+	return -2;
+      header.ref_count += delta;
+      memcpy (&new_word, &header, sizeof new_word);
+    }
+  while (! __atomic_compare_exchange_n (word, &old_word, new_word, 1,
+					 __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+  return header.ref_count;
+}
+
+static int
+atomic_ref_object (M17NObject *obj, int skip_zero)
+{
+  int n;
+
+  while ((n = add_ref_count (obj, 1, skip_zero)) == -1)
+    {
+      int done = 0;
+
+      M17N_LOCK (object_lock);
+      if (REF_COUNT_LOCKED_P (obj))
+	n = ref_object (obj), done = 1;
+      M17N_UNLOCK (object_lock);
+      if (done)
+	break;
+    }
+  return n;
+}
+
+#endif /* M17N_THREAD_SAFE */
+
 /* Internal API */
 
+#ifdef M17N_THREAD_SAFE
+
+void
+m17n__object_ref (void *object)
+{
+  atomic_ref_object ((M17NObject *) object, 1);
+}
+
+int
+m17n__object_unref (void *object)
+{
+  M17NObject *obj = (M17NObject *) object;
+  int n;
+
+  while ((n = add_ref_count (obj, -1, 1)) == -1)
+    {
+      int done = 0;
+
+      /* While the count is in this state, unref_object () never
+	 frees OBJ.  */
+      M17N_LOCK (object_lock);
+      if (REF_COUNT_LOCKED_P (obj))
+	n = unref_object (obj), done = 1;
+      M17N_UNLOCK (object_lock);
+      if (done)
+	return n;
+    }
+  if (n == 0)
+    {
+      if (obj->u.freer)
+	(obj->u.freer) (object);
+      else
+	free (object);
+    }
+  return (n == -2 ? -1 : n);
+}
+
+#endif /* M17N_THREAD_SAFE */
+
 int m17n__core_initialized;
 int m17n__shell_initialized;
 int m17n__gui_initialized;
@@ -590,6 +761,7 @@ m17n_init_core (void)
   SET_DEBUG_FLAG ("MDEBUG_FLT", MDEBUG_FLT);
   SET_DEBUG_FLAG ("MDEBUG_FONTSET", MDEBUG_FONTSET);
   SET_DEBUG_FLAG ("MDEBUG_INPUT", MDEBUG_INPUT);
+  SET_DEBUG_FLAG ("MDEBUG_DRAW", MDEBUG_DRAW);
   /* for backward compatibility... */
   SET_DEBUG_FLAG ("MDEBUG_FONT_FLT", MDEBUG_FLT);
   SET_DEBUG_FLAG ("MDEBUG_FONT_OTF", MDEBUG_FLT);
@@ -866,31 +1038,11 @@ m17n_object (int size, void (*freer) (void *))
 int
 m17n_object_ref (void *object)
 {
-  M17NObject *obj = (M17NObject *) object;
-  M17NObjectRecord *record;
-  unsigned *count;
-
-  if (! obj->ref_count_extended)
-    {
-      if (++obj->ref_count)
-	return (int) obj->ref_count;
-      MSTRUCT_MALLOC (record, MERROR_OBJECT);
-      record->freer = obj->u.freer;
-      MLIST_INIT1 (record, counts, 1);
-      MLIST_APPEND1 (record, counts, 0, MERROR_OBJECT);
-      obj->u.record = record;
-      obj->ref_count_extended = 1;
-    }
-  else
-    record = obj->u.record;
-
-  count = record->counts;
-  while (*count == 0xFFFFFFFF)
-    *(count++) = 0;
-  (*count)++;
-  if (*count == 0xFFFFFFFF)
-    MLIST_APPEND1 (record, counts, 0, MERROR_OBJECT);
-  return -1;
+#ifdef M17N_THREAD_SAFE
+  return atomic_ref_object ((M17NObject *) object, 0);
+#else
+  return ref_object ((M17NObject *) object);
+#endif
 }
 
 /*=*/
@@ -926,37 +1078,11 @@ m17n_object_ref (void *object)
 int
 m17n_object_unref (void *object)
 {
-  M17NObject *obj = (M17NObject *) object;
-  M17NObjectRecord *record;
-  unsigned *count;
-
-  if (! obj->ref_count_extended)
-    {
-      if (! --obj->ref_count)
-	{
-	  if (obj->u.freer)
-	    (obj->u.freer) (object);
-	  else
-	    free (object);
-	  return 0;
-	}
-      return (int) obj->ref_count;
-    }
-
-  record = obj->u.record;
-  count = record->counts;
-  while (! *count)
-    *(count++) = 0xFFFFFFFF;
-  (*count)--;
-  if (! record->counts[0])
-    {
-      obj->ref_count_extended = 0;
-      obj->ref_count--;
-      obj->u.freer = record->freer;
-      MLIST_FREE1 (record, counts);
-      free (record);
-    }
-  return -1;
+#ifdef M17N_THREAD_SAFE
+  return m17n__object_unref (object);
+#else
+  return unref_object ((M17NObject *) object);
+#endif
 }
 
 /*=*/
@@ -1010,7 +1136,12 @@ m17n_object_unref (void *object)
     m17n library.  When a library function is called with an invalid
     argument, it sets this variable to one of @c enum #MErrorCode.
 
-    This variable initially has the value 0.  */
+    This variable initially has the value 0.
+
+    If the m17n library is compiled with the macro @c M17N_THREAD_SAFE
+    defined, each thread has its own copy of this variable, and an
+    application program must also be compiled with that macro
+    defined.  */
 
 /***ja 
     @brief m17n 饤֥Υ顼ɤݻ볰ѿ.
@@ -1019,9 +1150,12 @@ m17n_object_unref (void *object)
     饤֥ؿǤʤȤȤ˸ƤФ줿ݤˤϡѿ 
     @c enum #MErrorCode ΰĤ˥åȤ롣
 
-    ѿνͤ 0 Ǥ롣  */
+    ѿνͤ 0 Ǥ롣
 
-int merror_code;
+    m17n 饤֥꤬ޥ @c M17N_THREAD_SAFE ƥѥ뤵Ƥˤϡ
+    ѿϥåɤȤ̡¸ߤץꥱץ⤽Υޥƥѥ뤷ʤƤϤʤʤ  */
+
+M17N_THREAD_LOCAL int merror_code;
 
 /*=*/
 
@@ -1099,6 +1233,9 @@ void (*m17n_memory_full_handler) (enum MErrorCode err);
     <li> MDEBUG_INPUT -- If set to 1, print information about how an
     input method is running.
 
+    <li> MDEBUG_DRAW -- If set to 1, print information about how
+    text is drawn on a frame.
+
     <li> MDEBUG_ALL -- Setting this variable to 1 is equivalent to
     setting all the above variables to 1.
 
@@ -1153,6 +1290,9 @@ void (*m17n_memory_full_handler) (enum MErrorCode err);
     <li> MDEBUG_INPUT -- 1 ʤС¹ϥ᥽åɤξ֤դƤ
     ץȤ롣
 
+    <li> MDEBUG_DRAW -- 1 ʤСե졼ؤΥƥȤˤĤƤ
+    ץȤ롣
+
     <li> MDEBUG_ALL -- 1 ʤС嵭٤Ƥѿ 1 
     ˤΤƱ̤ġ
 
@@ -55,7 +55,11 @@ extern void m17n_init_core (void);
 extern void m17n_fini_core (void);
 #define M17N_FINI() m17n_fini_core ()
 
+#ifdef M17N_THREAD_SAFE
+extern __thread int merror_code;
+#else
 extern int merror_code;
+#endif
 
 #endif
 
@@ -365,6 +369,8 @@ extern int mchartable_map (MCharTable *table, void *ignore,
 
 extern void mchartable_range (MCharTable *table, int *from, int *to);
 
+extern int mchartable_freeze (MCharTable *table);
+
 extern MCharTable *mchar_get_prop_table (MSymbol key, MSymbol *type);
 
 /*
@@ -507,6 +513,12 @@ extern const int MTEXT_FORMAT_UTF_32;
 extern MText *mtext_from_data (const void *data, int nitems,
 			       enum MTextFormat format);
 
+extern MText *mtext_from_external_data (const void *data, int nitems,
+					enum MTextFormat format,
+					void (*release) (void *data,
+							 void *arg),
+					void *arg);
+
 /*=*/
 /*** @} */
 
@@ -613,9 +625,20 @@ enum MTextLineBreakOption
 
 extern int mtext_line_break (MText *mt, int pos, int option, int *after);
 
+extern int mtext_line_breaks (MText *mt, int from, int to, int option,
+			      int **breaks);
+
 /*** @ingroup m17nPlist */
 extern MPlist *mplist_deserialize (MText *mt);
 
+/*** @ingroup m17nCharacter */
+extern int mchar_get_prop_mtext (MText *mt, int from, int to, MSymbol key,
+				 void **values);
+
+/*** @ingroup m17nChartable */
+extern int mchartable_lookup_mtext (MCharTable *table, MText *mt,
+				    int from, int to, void **values);
+
 /*
  * (5-3) Text properties
  */
@@ -835,6 +858,9 @@ extern MPlist *mdatabase_list (MSymbol tag0, MSymbol tag1,
 /* Load a data.  */
 void *mdatabase_load (MDatabase *mdb);
 
+/* Compile a data into a cache file.  */
+extern int mdatabase_compile (MDatabase *mdb);
+
 /* Get tags of a data.  */
 extern MSymbol *mdatabase_tag (MDatabase *mdb);
 
@@ -253,6 +253,71 @@ static MSymbol Mgenerator, Mend;
 static MPlist *flt_list;
 static int flt_min_coverage, flt_max_coverage;
 
+/* How many fonts the cache of mflt_find () remembers.  */
+#define FLT_FIND_CACHE_FONTS 16
+
+/* Cache of the results of mflt_find ().  Each entry maps characters
+   to the FLT found for them with a font identified by FONT_ID (Mt for
+   no font), or to &flt_find_none if no FLT was found.  The entries
+   are ordered from the most recently used one, and are freed with
+   flt_list.  */
+
+static struct
+{
+  MSymbol font_id;
+  MCharTable *table;
+} flt_find_cache[FLT_FIND_CACHE_FONTS];
+
+static int flt_find_cache_used;
+static int flt_find_hits, flt_find_misses, flt_find_evicted;
+static char flt_find_none;
+
+/* Result of mflt_run () cached in flt_run_table.  */
+
+typedef struct FLTRunCache FLTRunCache;
+
+struct FLTRunCache
+{
+  /* Key of the entry.  KEY is the sequence of the character code and
+     the bytes following MFLTGlyph of each input glyph.  */
+  MSymbol font_id;
+  MFLT *flt;
+  int x_ppem, y_ppem;
+  int glyph_size;
+  int flags;
+  unsigned hash;
+  int key_bytes;
+  char *key;
+
+  /* Output glyphs.  Their <from> and <to> are relative to the start
+     of the input.  */
+  int used;
+  char *glyphs;
+
+  /* Number of bytes occupied by this entry including KEY and
+     GLYPHS.  */
+  int bytes;
+
+  /* Next entry in the same bucket of flt_run_table.  */
+  FLTRunCache *chain;
+
+  /* Adjacent entries in the LRU list.  PREV is used more recently.  */
+  FLTRunCache *prev, *next;
+};
+
+/* Hash table of cached results of mflt_run ().  The size is zero or a
+   power of 2.  The entries are freed with flt_list.  */
+static FLTRunCache **flt_run_table;
+static int flt_run_table_size;
+
+/* LRU list of the entries of flt_run_table.  */
+static FLTRunCache *flt_run_head, *flt_run_tail;
+
+/* Number of entries in flt_run_table, and the total bytes of them.  */
+static int flt_run_count, flt_run_bytes;
+
+static int flt_run_hits, flt_run_misses;
+
 enum GlyphInfoMask
 {
   CategoryCodeMask = 0x7F,
@@ -427,6 +492,71 @@ typedef struct
   int *cmd_ids;
 } FontLayoutCmdRule;
 
+enum FontLayoutNFAType
+  {
+    NFA_SET,
+    NFA_SPLIT,
+    NFA_MATCH
+  };
+
+/* State of an NFA compiled from regular expressions.  */
+
+typedef struct
+{
+  enum FontLayoutNFAType type;
+  /* Index of the byte set for NFA_SET, or of the rule for NFA_MATCH.  */
+  int arg;
+  /* Next states.  OUT1 is used only by NFA_SPLIT.  */
+  int out, out1;
+} FontLayoutNFAState;
+
+/* State of a DFA built from the above NFA.  */
+
+typedef struct
+{
+  /* Sorted indices of the NFA states of type NFA_SET or NFA_MATCH.  */
+  int *nfa;
+  int n_nfa;
+  unsigned hash;
+  /* Indices of the rules whose regular expressions match here.  */
+  int *accepts;
+  int n_accepts;
+  /* Index of the next state for each byte class, -1 if no rule can
+     match any more, or -2 if not yet computed.  */
+  int *next;
+} FontLayoutDFAState;
+
+/* DFA for all the regular expressions of the rules in a COND.  */
+
+typedef struct
+{
+  /* Number of rules compiled into the DFA.  */
+  int n_rules;
+  /* Index of each command of the COND in the rules, or -1 if the
+     command is not compiled.  */
+  int *rule_idx;
+
+  FontLayoutNFAState *nfa;
+  int n_nfa, nfa_size, nfa_start;
+  /* Sets of bytes (0x01..0x7F) consumed by NFA_SET states.  */
+  unsigned char (*sets)[16];
+  int n_sets, sets_size;
+
+  /* Bytes that no set distinguishes share a class.  */
+  unsigned char byte_class[128];
+  unsigned char class_byte[128];
+  int n_classes;
+
+  FontLayoutDFAState *states;
+  int n_states, states_size;
+
+  /* Work area for computing the closure of NFA states.  */
+  int *mark, mark_gen, *stack, *buf;
+
+  /* Nonzero if the DFA got too large to be used.  */
+  int overflow;
+} FontLayoutDFA;
+
 typedef struct
 {
   /* Beginning and end indices of series of SEQ commands.  */
@@ -436,6 +566,9 @@ typedef struct
 
   int n_cmds;
   int *cmd_ids;
+
+  /* DFA for the regular expressions of the commands, or NULL.  */
+  FontLayoutDFA *dfa;
 } FontLayoutCmdCond;
 
 enum FontLayoutCmdType
@@ -1011,6 +1144,7 @@ load_command (FontLayoutStage *stage, MPlist *plist,
 	  cond = &cmd->body.cond;
 	  cond->seq_beg = cond->seq_end = -1;
 	  cond->seq_from = cond->seq_to = 0;
+	  cond->dfa = NULL;
 	  cond->n_cmds = len;
 	  MTABLE_CALLOC (cond->cmd_ids, len, MERROR_DRAW);
 	  for (i = 0; i < len; i++, elt = MPLIST_NEXT (elt))
@@ -1259,6 +1393,577 @@ load_command (FontLayoutStage *stage, MPlist *plist,
   return id;
 }
 
+/* DFA for the regular expressions of a COND.
+
+   The regular expression of a rule is anchored at the head, and is
+   matched against the category codes of glyphs (ctx->encoded).  A
+   COND usually tries many such rules in turn.  So, when a generator
+   is loaded, the regular expressions of the rules in each COND are
+   compiled into one NFA, and a DFA is built from it lazily while
+   running.  A single scan of the DFA tells which rules match and the
+   length of the longest match of each.  A rule that doesn't match is
+   skipped, and a rule without subexpressions doesn't need regexec ()
+   at all.
+
+   Only the subset of POSIX extended regular expressions that FLTs
+   use is supported: ASCII bytes, ".", bracket expressions without
+   character classes, grouping, "|", "*", "+", "?", and "{M,N}".  A
+   rule using anything else is left to regexec ().  */
+
+/* Maximum number of NFA and DFA states of a COND.  */
+#define FLT_NFA_MAX_STATES 4096
+#define FLT_DFA_MAX_STATES 1024
+
+enum RENodeType
+  {
+    RE_EMPTY,
+    RE_SET,
+    RE_CAT,
+    RE_ALT,
+    RE_REPEAT
+  };
+
+/* Node of a parsed regular expression.  */
+
+typedef struct
+{
+  enum RENodeType type;
+  /* Sub-nodes.  B is used only by RE_CAT and RE_ALT.  */
+  int a, b;
+  /* Index of the byte set for RE_SET.  */
+  int set;
+  /* Range of repetition for RE_REPEAT.  MAX is -1 for no limit.  */
+  int min, max;
+} RENode;
+
+typedef struct
+{
+  char *p;
+  FontLayoutDFA *dfa;
+  RENode *nodes;
+  int used, size;
+} REParser;
+
+static int re_parse_alt (REParser *parser, int depth);
+
+static int
+re_new_node (REParser *parser, enum RENodeType type, int a, int b)
+{
+  RENode *node;
+
+  if (parser->used == parser->size)
+    {
+      parser->size = parser->size ? parser->size * 2 : 64;
+      MTABLE_REALLOC (parser->nodes, parser->size, MERROR_FLT);
+    }
+  node = parser->nodes + parser->used;
+  node->type = type;
+  node->a = a, node->b = b;
+  node->set = -1;
+  node->min = node->max = 0;
+  return parser->used++;
+}
+
+static int
+re_new_set (FontLayoutDFA *dfa)
+{
+  if (dfa->n_sets == dfa->sets_size)
+    {
+      dfa->sets_size = dfa->sets_size ? dfa->sets_size * 2 : 16;
+      MTABLE_REALLOC (dfa->sets, dfa->sets_size, MERROR_FLT);
+    }
+  memset (dfa->sets[dfa->n_sets], 0, 16);
+  return dfa->n_sets++;
+}
+
+#define RE_SET_ADD(set, c) ((set)[(c) >> 3] |= 1 << ((c) & 7))
+#define RE_SET_HAS(set, c) ((set)[(c) >> 3] & (1 << ((c) & 7)))
+
+/* Parse a bracket expression following "[".  */
+
+static int
+re_parse_bracket (REParser *parser)
+{
+  unsigned char set[16];
+  int negate = 0, first = 1, node, c, i;
+
+  memset (set, 0, 16);
+  if (*parser->p == '^')
+    negate = 1, parser->p++;
+  while (1)
+    {
+      c = (unsigned char) *parser->p++;
+      if (c == ']' && ! first)
+	break;
+      first = 0;
+      if (c == 0 || c >= 0x80)
+	return -1;
+      if (c == '[' && (*parser->p == ':' || *parser->p == '.'
+		       || *parser->p == '='))
+	return -1;
+      if (parser->p[0] == '-' && parser->p[1] && parser->p[1] != ']')
+	{
+	  int to = (unsigned char) parser->p[1];
+
+	  if (to >= 0x80 || to < c || to == '[')
+	    return -1;
+	  parser->p += 2;
+	  for (; c <= to; c++)
+	    RE_SET_ADD (set, c);
+	}
+      else
+	RE_SET_ADD (set, c);
+    }
+  node = re_new_node (parser, RE_SET, -1, -1);
+  parser->nodes[node].set = re_new_set (parser->dfa);
+  for (c = 1; c < 0x80; c++)
+    if ((RE_SET_HAS (set, c) != 0) != negate)
+      RE_SET_ADD (parser->dfa->sets[parser->nodes[node].set], c);
+  for (i = 0; i < 16; i++)
+    if (parser->dfa->sets[parser->nodes[node].set][i])
+      break;
+  return (i < 16 ? node : -1);
+}
+
+static int
+re_parse_number (REParser *parser)
+{
+  int n = 0;
+
+  if (! isdigit ((unsigned char) *parser->p))
+    return -1;
+  while (isdigit ((unsigned char) *parser->p))
+    {
+      n = n * 10 + (*parser->p++ - '0');
+      if (n > 255)
+	return -1;
+    }
+  return n;
+}
+
+/* Parse an atom and the following repetition operators.  */
+
+static int
+re_parse_repeat (REParser *parser, int depth)
+{
+  int c = (unsigned char) *parser->p++;
+  int node;
+
+  if (c == '(')
+    {
+      if (depth > 32)
+	return -1;
+      if (*parser->p == ')')
+	node = re_new_node (parser, RE_EMPTY, -1, -1);
+      else if ((node = re_parse_alt (parser, depth + 1)) < 0)
+	return -1;
+      if (*parser->p++ != ')')
+	return -1;
+    }
+  else if (c == '[')
+    {
+      if ((node = re_parse_bracket (parser)) < 0)
+	return -1;
+    }
+  else if (c == '.')
+    {
+      node = re_new_node (parser, RE_SET, -1, -1);
+      parser->nodes[node].set = re_new_set (parser->dfa);
+      for (c = 1; c < 0x80; c++)
+	RE_SET_ADD (parser->dfa->sets[parser->nodes[node].set], c);
+    }
+  else
+    {
+      if (c == '\\')
+	{
+	  c = (unsigned char) *parser->p++;
+	  if (isalnum (c) || c == '<' || c == '>' || c == '`' || c == '\'')
+	    return -1;
+	}
+      else if (c == '^' || c == '$' || c == '*' || c == '+' || c == '?'
+	       || c == '{' || c == '|' || c == ')')
+	return -1;
+      if (c == 0 || c >= 0x80)
+	return -1;
+      node = re_new_node (parser, RE_SET, -1, -1);
+      parser->nodes[node].set = re_new_set (parser->dfa);
+      RE_SET_ADD (parser->dfa->sets[parser->nodes[node].set], c);
+    }
+
+  while ((c = *parser->p) == '*' || c == '+' || c == '?' || c == '{')
+    {
+      int min, max;
+
+      parser->p++;
+      if (c == '{')
+	{
+	  if ((min = re_parse_number (parser)) < 0)
+	    return -1;
+	  max = min;
+	  if (*parser->p == ',')
+	    {
+	      parser->p++;
+	      max = (*parser->p == '}' ? -1 : re_parse_number (parser));
+	      if (max >= 0 && max < min)
+		return -1;
+	      if (max < 0 && *parser->p != '}')
+		return -1;
+	    }
+	  if (*parser->p++ != '}')
+	    return -1;
+	}
+      else
+	{
+	  min = c == '+';
+	  max = c == '?' ? 1 : -1;
+	}
+      node = re_new_node (parser, RE_REPEAT, node, -1);
+      parser->nodes[node].min = min;
+      parser->nodes[node].max = max;
+    }
+  return node;
+}
+
+static int
+re_parse_alt (REParser *parser, int depth)
+{
+  int alt = -1;
+
+  while (1)
+    {
+      int cat = -1;
+
+      while (*parser->p && *parser->p != '|' && *parser->p != ')')
+	{
+	  int node = re_parse_repeat (parser, depth);
+
+	  if (node < 0)
+	    return -1;
+	  cat = cat < 0 ? node : re_new_node (parser, RE_CAT, cat, node);
+	}
+      if (cat < 0)
+	cat = re_new_node (parser, RE_EMPTY, -1, -1);
+      alt = alt < 0 ? cat : re_new_node (parser, RE_ALT, alt, cat);
+      if (*parser->p != '|')
+	return alt;
+      parser->p++;
+    }
+}
+
+static int
+nfa_new_state (FontLayoutDFA *dfa, enum FontLayoutNFAType type,
+	       int arg, int out, int out1)
+{
+  FontLayoutNFAState *state;
+
+  if (dfa->n_nfa == FLT_NFA_MAX_STATES)
+    return -1;
+  if (dfa->n_nfa == dfa->nfa_size)
+    {
+      dfa->nfa_size = dfa->nfa_size ? dfa->nfa_size * 2 : 64;
+      MTABLE_REALLOC (dfa->nfa, dfa->nfa_size, MERROR_FLT);
+    }
+  state = dfa->nfa + dfa->n_nfa;
+  state->type = type;
+  state->arg = arg;
+  state->out = out, state->out1 = out1;
+  return dfa->n_nfa++;
+}
+
+/* Compile NODE into NFA states continuing to the state NEXT, and
+   return the first state.  */
+
+static int
+nfa_compile (FontLayoutDFA *dfa, RENode *nodes, int node, int next)
+{
+  RENode *re = nodes + node;
+  int state, loop, i;
+
+  if (next < 0)
+    return -1;
+  switch (re->type)
+    {
+    case RE_EMPTY:
+      return next;
+    case RE_SET:
+      return nfa_new_state (dfa, NFA_SET, re->set, next, -1);
+    case RE_CAT:
+      return nfa_compile (dfa, nodes, re->a,
+			  nfa_compile (dfa, nodes, re->b, next));
+    case RE_ALT:
+      state = nfa_compile (dfa, nodes, re->a, next);
+      loop = nfa_compile (dfa, nodes, re->b, next);
+      if (state < 0 || loop < 0)
+	return -1;
+      return nfa_new_state (dfa, NFA_SPLIT, 0, state, loop);
+    default:			/* RE_REPEAT */
+      if (re->max < 0)
+	{
+	  loop = nfa_new_state (dfa, NFA_SPLIT, 0, -1, next);
+	  if (loop < 0
+	      || (state = nfa_compile (dfa, nodes, re->a, loop)) < 0)
+	    return -1;
+	  dfa->nfa[loop].out = state;
+	  state = loop;
+	}
+      else
+	for (state = next, i = re->min; i < re->max && state >= 0; i++)
+	  {
+	    int body = nfa_compile (dfa, nodes, re->a, state);
+
+	    state = (body < 0 ? -1
+		     : nfa_new_state (dfa, NFA_SPLIT, 0, body, next));
+	  }
+      for (i = 0; i < re->min && state >= 0; i++)
+	state = nfa_compile (dfa, nodes, re->a, state);
+      return state;
+    }
+}
+
+/* Add the closure of the NFA state STATE to DFA->buf.  */
+
+static int
+nfa_closure (FontLayoutDFA *dfa, int state, int n)
+{
+  int sp = 0;
+
+  dfa->stack[sp++] = state;
+  while (sp > 0)
+    {
+      state = dfa->stack[--sp];
+      if (dfa->mark[state] == dfa->mark_gen)
+	continue;
+      dfa->mark[state] = dfa->mark_gen;
+      if (dfa->nfa[state].type == NFA_SPLIT)
+	{
+	  dfa->stack[sp++] = dfa->nfa[state].out1;
+	  dfa->stack[sp++] = dfa->nfa[state].out;
+	}
+      else
+	dfa->buf[n++] = state;
+    }
+  return n;
+}
+
+/* Return the index of the DFA state for the N NFA states in
+   DFA->buf, or -1 if the DFA gets too large.  */
+
+static int
+dfa_get_state (FontLayoutDFA *dfa, int n)
+{
+  FontLayoutDFAState *state;
+  unsigned hash = 2166136261U;
+  int i, j;
+
+  for (i = 1; i < n; i++)
+    {
+      int s = dfa->buf[i];
+
+      for (j = i; j > 0 && dfa->buf[j - 1] > s; j--)
+	dfa->buf[j] = dfa->buf[j - 1];
+      dfa->buf[j] = s;
+    }
+  for (i = 0; i < n; i++)
+    hash = (hash ^ dfa->buf[i]) * 16777619U;
+  for (i = 0; i < dfa->n_states; i++)
+    if (dfa->states[i].hash == hash && dfa->states[i].n_nfa == n
+	&& ! memcmp (dfa->states[i].nfa, dfa->buf, sizeof (int) * n))
+      return i;
+  if (dfa->n_states == FLT_DFA_MAX_STATES)
+    {
+      dfa->overflow = 1;
+      return -1;
+    }
+  if (dfa->n_states == dfa->states_size)
+    {
+      dfa->states_size = dfa->states_size ? dfa->states_size * 2 : 16;
+      MTABLE_REALLOC (dfa->states, dfa->states_size, MERROR_FLT);
+    }
+  state = dfa->states + dfa->n_states;
+  state->n_nfa = n;
+  state->hash = hash;
+  MTABLE_MALLOC (state->nfa, n > 0 ? n : 1, MERROR_FLT);
+  memcpy (state->nfa, dfa->buf, sizeof (int) * n);
+  MTABLE_MALLOC (state->accepts, n > 0 ? n : 1, MERROR_FLT);
+  for (i = state->n_accepts = 0; i < n; i++)
+    if (dfa->nfa[dfa->buf[i]].type == NFA_MATCH)
+      state->accepts[state->n_accepts++] = dfa->nfa[dfa->buf[i]].arg;
+  MTABLE_MALLOC (state->next, dfa->n_classes, MERROR_FLT);
+  for (i = 0; i < dfa->n_classes; i++)
+    state->next[i] = -2;
+  return dfa->n_states++;
+}
+
+/* Compute the state following the DFA state FROM by a byte of the
+   class CLS.  */
+
+static int
+dfa_next_state (FontLayoutDFA *dfa, int from, int cls)
+{
+  int c = dfa->class_byte[cls];
+  int i, n = 0, next;
+
+  dfa->mark_gen++;
+  for (i = 0; i < dfa->states[from].n_nfa; i++)
+    {
+      FontLayoutNFAState *nfa = dfa->nfa + dfa->states[from].nfa[i];
+
+      if (nfa->type == NFA_SET && RE_SET_HAS (dfa->sets[nfa->arg], c))
+	n = nfa_closure (dfa, nfa->out, n);
+    }
+  next = n > 0 ? dfa_get_state (dfa, n) : -1;
+  if (next >= 0 || n == 0)
+    dfa->states[from].next[cls] = next;
+  return next;
+}
+
+static void
+free_cond_dfa (FontLayoutDFA *dfa)
+{
+  int i;
+
+  for (i = 0; i < dfa->n_states; i++)
+    {
+      free (dfa->states[i].nfa);
+      free (dfa->states[i].accepts);
+      free (dfa->states[i].next);
+    }
+  free (dfa->states);
+  free (dfa->nfa);
+  free (dfa->sets);
+  free (dfa->mark);
+  free (dfa->stack);
+  free (dfa->buf);
+  free (dfa->rule_idx);
+  free (dfa);
+}
+
+/* Build a DFA for the regular expressions of the rules in COND of
+   STAGE.  */
+
+static void
+build_cond_dfa (FontLayoutStage *stage, FontLayoutCmdCond *cond)
+{
+  FontLayoutDFA *dfa;
+  REParser parser;
+  int i, n, start = -1;
+
+  MSTRUCT_CALLOC (dfa, MERROR_FLT);
+  MTABLE_MALLOC (dfa->rule_idx, cond->n_cmds, MERROR_FLT);
+  memset (&parser, 0, sizeof parser);
+  parser.dfa = dfa;
+  for (i = 0; i < cond->n_cmds; i++)
+    {
+      int id = cond->cmd_ids[i];
+      FontLayoutCmd *cmd;
+      int node, match, state;
+
+      dfa->rule_idx[i] = -1;
+      if (id > CMD_ID_OFFSET_INDEX)
+	continue;
+      cmd = stage->cmds + CMD_ID_TO_INDEX (id);
+      if (cmd->type != FontLayoutCmdTypeRule
+	  || cmd->body.rule.src_type != SRC_REGEX)
+	continue;
+      parser.p = cmd->body.rule.src.re.pattern + 1;
+      parser.used = 0;
+      node = re_parse_alt (&parser, 0);
+      if (node < 0 || *parser.p)
+	continue;
+      n = dfa->n_nfa;
+      match = nfa_new_state (dfa, NFA_MATCH, dfa->n_rules, -1, -1);
+      state = nfa_compile (dfa, parser.nodes, node, match);
+      if (state >= 0 && start >= 0)
+	state = nfa_new_state (dfa, NFA_SPLIT, 0, start, state);
+      if (state < 0)
+	{
+	  dfa->n_nfa = n;
+	  continue;
+	}
+      start = state;
+      dfa->rule_idx[i] = dfa->n_rules++;
+    }
+  free (parser.nodes);
+  if (dfa->n_rules == 0)
+    {
+      free_cond_dfa (dfa);
+      return;
+    }
+  dfa->nfa_start = start;
+
+  /* Make classes of bytes that go to the same NFA states.  */
+  memset (dfa->byte_class, 0, 128);
+  dfa->n_classes = 1;
+  for (n = 0; n < dfa->n_sets; n++)
+    {
+      int count_in[128], count_all[128], new_class[128];
+      int c, k = dfa->n_classes;
+
+      memset (count_in, 0, sizeof (int) * k);
+      memset (count_all, 0, sizeof (int) * k);
+      for (c = 1; c < 0x80; c++)
+	{
+	  count_all[dfa->byte_class[c]]++;
+	  if (RE_SET_HAS (dfa->sets[n], c))
+	    count_in[dfa->byte_class[c]]++;
+	}
+      for (i = 0; i < k; i++)
+	new_class[i] = (count_in[i] > 0 && count_in[i] < count_all[i]
+			? dfa->n_classes++ : i);
+      for (c = 1; c < 0x80; c++)
+	if (RE_SET_HAS (dfa->sets[n], c))
+	  dfa->byte_class[c] = new_class[dfa->byte_class[c]];
+    }
+  for (i = 0x7F; i > 0; i--)
+    dfa->class_byte[dfa->byte_class[i]] = i;
+
+  MTABLE_CALLOC (dfa->mark, dfa->n_nfa, MERROR_FLT);
+  MTABLE_MALLOC (dfa->stack, dfa->n_nfa * 2 + 1, MERROR_FLT);
+  MTABLE_MALLOC (dfa->buf, dfa->n_nfa, MERROR_FLT);
+  dfa->mark_gen = 1;
+  dfa_get_state (dfa, nfa_closure (dfa, start, 0));
+  cond->dfa = dfa;
+}
+
+/* Run DFA on the LEN bytes at STR.  For each rule compiled into DFA,
+   set the length of the longest match in MATCH_LEN, or -1 if it
+   doesn't match.  Return 0 on success, or -1 if the DFA can't be used
+   for STR.  */
+
+static int
+run_cond_dfa (FontLayoutDFA *dfa, char *str, int len, int *match_len)
+{
+  int state = 0, i, j;
+
+  if (dfa->overflow)
+    return -1;
+  for (j = 0; j < dfa->n_rules; j++)
+    match_len[j] = -1;
+  for (i = 0; ; i++)
+    {
+      FontLayoutDFAState *s = dfa->states + state;
+      int c;
+
+      for (j = 0; j < s->n_accepts; j++)
+	match_len[s->accepts[j]] = i;
+      if (i == len || (c = (unsigned char) str[i]) == 0)
+	break;
+      if (c >= 0x80)
+	return -1;
+      c = dfa->byte_class[c];
+      state = s->next[c];
+      if (state == -2)
+	state = dfa_next_state (dfa, s - dfa->states, c);
+      if (state < 0)
+	{
+	  if (dfa->overflow)
+	    return -1;
+	  break;
+	}
+    }
+  return 0;
+}
+
 static void
 free_flt_command (FontLayoutCmd *cmd)
 {
@@ -1276,7 +1981,11 @@ free_flt_command (FontLayoutCmd *cmd)
       free (rule->cmd_ids);
     }
   else if (cmd->type == FontLayoutCmdTypeCond)
-    free (cmd->body.cond.cmd_ids);
+    {
+      free (cmd->body.cond.cmd_ids);
+      if (cmd->body.cond.dfa)
+	free_cond_dfa (cmd->body.cond.dfa);
+    }
   else if (cmd->type == FontLayoutCmdTypeOTF
 	   || cmd->type == FontLayoutCmdTypeOTFCategory)
     {
@@ -1298,7 +2007,7 @@ load_generator (MPlist *plist)
   FontLayoutStage *stage;
   MPlist *elt, *pl;
   FontLayoutCmd dummy;
-  int result;
+  int result, i;
 
   MSTRUCT_CALLOC (stage, MERROR_DRAW);
   MLIST_INIT1 (stage, cmds, 32);
@@ -1325,6 +2034,9 @@ load_generator (MPlist *plist)
       free (stage);
       return NULL;
     }
+  for (i = 0; i < stage->used; i++)
+    if (stage->cmds[i].type == FontLayoutCmdTypeCond)
+      build_cond_dfa (stage, &stage->cmds[i].body.cond);
 
   return stage;
 }
@@ -1476,9 +2188,249 @@ free_flt_stage (MFLT *flt, FontLayoutStage *stage)
   free (stage);
 }
 
+/* Return the cache table of mflt_find () for FONT_ID.  */
+
+static MCharTable *
+get_flt_find_cache (MSymbol font_id)
+{
+  MCharTable *table;
+  int i;
+
+  for (i = 0; i < flt_find_cache_used; i++)
+    if (flt_find_cache[i].font_id == font_id)
+      break;
+  if (i < flt_find_cache_used)
+    table = flt_find_cache[i].table;
+  else
+    {
+      if (i == FLT_FIND_CACHE_FONTS)
+	{
+	  i--;
+	  M17N_OBJECT_UNREF (flt_find_cache[i].table);
+	  flt_find_evicted++;
+	}
+      else
+	flt_find_cache_used++;
+      table = mchartable (Mnil, NULL);
+    }
+  for (; i > 0; i--)
+    flt_find_cache[i] = flt_find_cache[i - 1];
+  flt_find_cache[0].font_id = font_id;
+  flt_find_cache[0].table = table;
+  return table;
+}
+
+static void
+free_flt_find_cache ()
+{
+  int i;
+
+  if (flt_find_hits + flt_find_misses > 0)
+    MDEBUG_PRINT5 (" [FLT] find cache: %d hits, %d misses (%d%%),"
+		   " %d fonts, %d evicted\n", flt_find_hits, flt_find_misses,
+		   flt_find_hits * 100 / (flt_find_hits + flt_find_misses),
+		   flt_find_cache_used, flt_find_evicted);
+  for (i = 0; i < flt_find_cache_used; i++)
+    M17N_OBJECT_UNREF (flt_find_cache[i].table);
+  flt_find_cache_used = 0;
+  flt_find_hits = flt_find_misses = flt_find_evicted = 0;
+}
+
+#define FLT_RUN_HASH(hash) ((hash) & (flt_run_table_size - 1))
+
+static void
+flt_run_remove (FLTRunCache *entry)
+{
+  FLTRunCache **p = flt_run_table + FLT_RUN_HASH (entry->hash);
+
+  while (*p != entry)
+    p = &(*p)->chain;
+  *p = entry->chain;
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    flt_run_head = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    flt_run_tail = entry->prev;
+  flt_run_count--;
+  flt_run_bytes -= entry->bytes;
+  free (entry);
+}
+
+static void
+free_flt_run_cache ()
+{
+  if (flt_run_hits + flt_run_misses > 0)
+    MDEBUG_PRINT4 (" [FLT] run cache: %d hits, %d misses (%d%%),"
+		   " %d bytes\n", flt_run_hits, flt_run_misses,
+		   flt_run_hits * 100 / (flt_run_hits + flt_run_misses),
+		   flt_run_bytes);
+  while (flt_run_head)
+    flt_run_remove (flt_run_head);
+  if (flt_run_table)
+    {
+      free (flt_run_table);
+      flt_run_table = NULL;
+      flt_run_table_size = 0;
+    }
+  flt_run_hits = flt_run_misses = 0;
+}
+
+/* Set the key of PROBE for running FLT on glyphs of GSTRING between
+   FROM and TO with FONT identified by FONT_ID.  The key is stored in
+   KEY that must have enough room.  Return 0 on success, or -1 if the
+   result must not be cached because some glyph is already
+   encoded.  */
+
+static int
+setup_flt_run_key (FLTRunCache *probe, char *key, MSymbol font_id, MFLT *flt,
+		   MFLTFont *font, MFLTGlyphString *gstring, int from, int to)
+{
+  int extra = gstring->glyph_size - sizeof (MFLTGlyph);
+  unsigned hash = 2166136261U;
+  char *p = key;
+  int i;
+
+  for (i = from; i < to; i++)
+    {
+      MFLTGlyph *g = GREF (gstring, i);
+
+      if (g->encoded)
+	return -1;
+      memcpy (p, &g->c, sizeof (int));
+      p += sizeof (int);
+      if (extra > 0)
+	{
+	  memcpy (p, g + 1, extra);
+	  p += extra;
+	}
+    }
+  probe->font_id = font_id;
+  probe->flt = flt;
+  probe->x_ppem = font->x_ppem;
+  probe->y_ppem = font->y_ppem;
+  probe->glyph_size = gstring->glyph_size;
+  probe->flags = (gstring->r2l != 0) | (mflt_enable_new_feature != 0) << 1;
+  probe->key = key;
+  probe->key_bytes = p - key;
+  for (p = key; p < key + probe->key_bytes; p++)
+    hash = (hash ^ (unsigned char) *p) * 16777619U;
+  hash ^= ((unsigned) (size_t) font_id >> 4) * 2654435761U;
+  hash ^= ((unsigned) (size_t) flt >> 4) * 40503U;
+  hash ^= (probe->x_ppem << 16) ^ probe->y_ppem ^ (probe->flags << 30);
+  probe->hash = hash;
+  return 0;
+}
+
+/* Return the cached result of mflt_run () that has the same key as
+   PROBE, or NULL if there's none.  */
+
+static FLTRunCache *
+lookup_flt_run_cache (FLTRunCache *probe)
+{
+  FLTRunCache *entry;
+
+  if (flt_run_table)
+    for (entry = flt_run_table[FLT_RUN_HASH (probe->hash)]; entry;
+	 entry = entry->chain)
+      if (entry->hash == probe->hash
+	  && entry->font_id == probe->font_id
+	  && entry->flt == probe->flt
+	  && entry->x_ppem == probe->x_ppem
+	  && entry->y_ppem == probe->y_ppem
+	  && entry->glyph_size == probe->glyph_size
+	  && entry->flags == probe->flags
+	  && entry->key_bytes == probe->key_bytes
+	  && memcmp (entry->key, probe->key, probe->key_bytes) == 0)
+	{
+	  flt_run_hits++;
+	  if (entry->prev)
+	    {
+	      entry->prev->next = entry->next;
+	      if (entry->next)
+		entry->next->prev = entry->prev;
+	      else
+		flt_run_tail = entry->prev;
+	      entry->prev = NULL;
+	      entry->next = flt_run_head;
+	      flt_run_head->prev = entry;
+	      flt_run_head = entry;
+	    }
+	  return entry;
+	}
+  flt_run_misses++;
+  return NULL;
+}
+
+/* Cache the glyphs of GSTRING between FROM and TO as the result of
+   mflt_run () for the key of PROBE.  */
+
+static void
+put_flt_run_cache (FLTRunCache *probe, MFLTGlyphString *gstring,
+		   int from, int to)
+{
+  FLTRunCache *entry;
+  int glyph_bytes = gstring->glyph_size * (to - from);
+  int bytes = sizeof (FLTRunCache) + probe->key_bytes + glyph_bytes;
+  int i;
+
+  if (bytes > mflt_run_cache_size)
+    return;
+  while (flt_run_bytes + bytes > mflt_run_cache_size)
+    flt_run_remove (flt_run_tail);
+
+  if (flt_run_count >= flt_run_table_size)
+    {
+      flt_run_table_size = flt_run_table_size ? flt_run_table_size * 2 : 256;
+      if (flt_run_table)
+	free (flt_run_table);
+      MTABLE_CALLOC (flt_run_table, flt_run_table_size, MERROR_FLT);
+      for (entry = flt_run_head; entry; entry = entry->next)
+	{
+	  i = FLT_RUN_HASH (entry->hash);
+	  entry->chain = flt_run_table[i];
+	  flt_run_table[i] = entry;
+	}
+    }
+
+  entry = malloc (bytes);
+  if (! entry)
+    MEMORY_FULL (MERROR_FLT);
+  *entry = *probe;
+  entry->key = (char *) (entry + 1);
+  memcpy (entry->key, probe->key, probe->key_bytes);
+  entry->used = to - from;
+  entry->glyphs = entry->key + probe->key_bytes;
+  memcpy (entry->glyphs, GREF (gstring, from), glyph_bytes);
+  for (i = 0; i < entry->used; i++)
+    {
+      MFLTGlyph *g = (MFLTGlyph *) (entry->glyphs + gstring->glyph_size * i);
+
+      g->from -= from;
+      g->to -= from;
+    }
+  entry->bytes = bytes;
+  i = FLT_RUN_HASH (entry->hash);
+  entry->chain = flt_run_table[i];
+  flt_run_table[i] = entry;
+  entry->prev = NULL;
+  entry->next = flt_run_head;
+  if (flt_run_head)
+    flt_run_head->prev = entry;
+  else
+    flt_run_tail = entry;
+  flt_run_head = entry;
+  flt_run_count++;
+  flt_run_bytes += bytes;
+}
+
 static void
 free_flt_list ()
 {
+  free_flt_find_cache ();
+  free_flt_run_cache ();
   if (flt_list)
     {
       MPlist *plist, *pl;
@@ -1594,6 +2546,11 @@ typedef struct
   int combining_code;
   int left_padding;
   int check_mask;
+  /* Length of the match of the next regular expression rule found by
+     the DFA of a COND, or -1.  */
+  int regex_match_len;
+  /* Incremented each time <encoded> is modified while running.  */
+  int encoded_changes;
 } FontLayoutContext;
 
 static int run_command (int, int, int, int, FontLayoutContext *);
@@ -1618,14 +2575,26 @@ run_rule (int depth,
       regmatch_t pmatch[NMATCH];
       char saved_code;
       int result;
+      int match_len = ctx->regex_match_len;
 
+      ctx->regex_match_len = -1;
       if (from > to)
 	return 0;
       saved_code = ctx->encoded[to - ctx->encoded_offset];
       ctx->encoded[to - ctx->encoded_offset] = '\0';
-      result = regexec (&(rule->src.re.preg),
-			ctx->encoded + (from - ctx->encoded_offset),
-			NMATCH, pmatch, 0);
+      if (match_len >= 0 && rule->src.re.preg.re_nsub == 0)
+	{
+	  /* The DFA of the COND has already found the match.  */
+	  pmatch[0].rm_so = 0;
+	  pmatch[0].rm_eo = match_len;
+	  for (i = 1; i < NMATCH; i++)
+	    pmatch[i].rm_so = pmatch[i].rm_eo = -1;
+	  result = 0;
+	}
+      else
+	result = regexec (&(rule->src.re.preg),
+			  ctx->encoded + (from - ctx->encoded_offset),
+			  NMATCH, pmatch, 0);
       if (result == 0 && pmatch[0].rm_so == 0)
 	{
 	  if (MDEBUG_FLAG () > 2)
@@ -1852,17 +2821,42 @@ run_cond (int depth,
 	  FontLayoutCmdCond *cond, int from, int to, FontLayoutContext *ctx)
 {
   int i, pos = 0;
+  int *match_len = NULL;
+  int encoded_changes = ctx->encoded_changes;
 
   if (MDEBUG_FLAG () > 2)
     MDEBUG_PRINT2 ("\n [FLT] %*s(COND", depth, "");
   depth++;
+  if (cond->dfa && from <= to)
+    {
+      match_len = alloca (sizeof (int) * cond->dfa->n_rules);
+      if (run_cond_dfa (cond->dfa, ctx->encoded + (from - ctx->encoded_offset),
+			to - from, match_len) < 0)
+	match_len = NULL;
+    }
   for (i = 0; i < cond->n_cmds; i++)
     {
       /* TODO: Write a code for optimization utilizaing the info
 	 cond->seq_XXX.  */
-      if ((pos = run_command (depth, cond->cmd_ids[i], from, to, ctx))
-	  != 0)
+      if (match_len && cond->dfa->rule_idx[i] >= 0)
+	{
+	  if (match_len[cond->dfa->rule_idx[i]] < 0)
+	    continue;
+	  ctx->regex_match_len = match_len[cond->dfa->rule_idx[i]];
+	}
+      pos = run_command (depth, cond->cmd_ids[i], from, to, ctx);
+      ctx->regex_match_len = -1;
+      if (pos != 0)
 	break;
+      if (match_len && ctx->encoded_changes != encoded_changes)
+	{
+	  /* The failed command has changed the category codes.  */
+	  encoded_changes = ctx->encoded_changes;
+	  if (run_cond_dfa (cond->dfa,
+			    ctx->encoded + (from - ctx->encoded_offset),
+			    to - from, match_len) < 0)
+	    match_len = NULL;
+	}
     }
   if (pos < 0)
     return pos;
@@ -1900,7 +2894,10 @@ decode_packed_otf_tag (FontLayoutContext *ctx, MFLTGlyphString *gstring,
 	      {
 		enc = category->feature_table.code[i];
 		if (ctx->in == gstring)
-		  ctx->encoded[from - ctx->encoded_offset] = enc;
+		  {
+		    ctx->encoded[from - ctx->encoded_offset] = enc;
+		    ctx->encoded_changes++;
+		  }
 		break;
 	      }
 	}
@@ -2050,6 +3047,7 @@ try_otf (int depth, MFLTOtfSpec *otf_spec, int from, int to,
 	      ctx->encoded[i - ctx->encoded_offset] = enc;
 	    }
 	}
+      ctx->encoded_changes++;
       return from;
     }
 
@@ -2642,6 +3640,86 @@ configure_flt (MFLT *flt, MFLTFont *font, MSymbol font_id)
   return configured;
 }
 
+/* Find an FLT suitable for the character C and FONT.  This is the
+   uncached body of mflt_find ().  */
+
+static MFLT *
+find_flt (int c, MFLTFont *font)
+{
+  MPlist *plist, *pl;
+  MFLT *flt;
+  static MSymbol unicode_bmp = NULL, unicode_full = NULL;
+
+  if (! unicode_bmp)
+    {
+      unicode_bmp = msymbol ("unicode-bmp");
+      unicode_full = msymbol ("unicode-full");
+    }
+
+  if (! flt_list && list_flt () < 0)
+    return NULL;
+  /* Skip configured FLTs.  */
+  MPLIST_DO (plist, flt_list)
+    if (((MFLT *) MPLIST_VAL (plist))->font_id == Mnil)
+      break;
+  if (font)
+    {
+      MFLT *best = NULL;
+
+      MPLIST_DO (pl, plist)
+	{
+	  flt = MPLIST_VAL (pl);
+	  if (flt->registry != unicode_bmp
+	      && flt->registry != unicode_full)
+	    continue;
+	  if (flt->family && flt->family != font->family)
+	    continue;
+	  if (flt->name == Mcombining
+	      && ! mchartable_lookup (flt->coverage->table, 0))
+	    setup_combining_flt (flt);
+	  if (c >= 0
+	      && ! mchartable_lookup (flt->coverage->table, c))
+	    continue;
+	  if (flt->otf.sym)
+	    {
+	      MFLTOtfSpec *spec = &flt->otf;
+
+	      if (! font->check_otf)
+		{
+		  if ((spec->features[0] && spec->features[0][0] != 0xFFFFFFFF)
+		      || (spec->features[1] && spec->features[1][0] != 0xFFFFFFFF))
+		    continue;
+		}
+	      else if (! font->check_otf (font, spec))
+		continue;
+	      goto found;
+	    }
+	  best = flt;
+	}
+      if (best == NULL)
+	return NULL;
+      flt = best;
+      goto found;
+    }
+  if (c >= 0)
+    {
+      MPLIST_DO (pl, plist)
+	{
+	  flt = MPLIST_VAL (pl);
+	  if (mchartable_lookup (flt->coverage->table, c))
+	    goto found;
+	}
+    }
+  return NULL;
+
+ found:
+  if (! CHECK_FLT_STAGES (flt))
+    return NULL;
+  if (font && flt->need_config && mflt_font_id)
+    flt = configure_flt (flt, font, mflt_font_id (font));
+  return flt;
+}
+
 /* Internal API */
 
 int m17n__flt_initialized;
@@ -2775,77 +3853,33 @@ mflt_get (MSymbol name)
 MFLT *
 mflt_find (int c, MFLTFont *font)
 {
-  MPlist *plist, *pl;
+  MSymbol font_id = Mnil;
+  MCharTable *table = NULL;
   MFLT *flt;
-  static MSymbol unicode_bmp = NULL, unicode_full = NULL;
-
-  if (! unicode_bmp)
-    {
-      unicode_bmp = msymbol ("unicode-bmp");
-      unicode_full = msymbol ("unicode-full");
-    }
 
   if (! flt_list && list_flt () < 0)
     return NULL;
-  /* Skip configured FLTs.  */
-  MPLIST_DO (plist, flt_list)
-    if (((MFLT *) MPLIST_VAL (plist))->font_id == Mnil)
-      break;
-  if (font)
+  if (c >= 0)
     {
-      MFLT *best = NULL;
-
-      MPLIST_DO (pl, plist)
-	{
-	  flt = MPLIST_VAL (pl);
-	  if (flt->registry != unicode_bmp
-	      && flt->registry != unicode_full)
-	    continue;
-	  if (flt->family && flt->family != font->family)
-	    continue;
-	  if (flt->name == Mcombining
-	      && ! mchartable_lookup (flt->coverage->table, 0))
-	    setup_combining_flt (flt);
-	  if (c >= 0
-	      && ! mchartable_lookup (flt->coverage->table, c))
-	    continue;
-	  if (flt->otf.sym)
-	    {
-	      MFLTOtfSpec *spec = &flt->otf;
-
-	      if (! font->check_otf)
-		{
-		  if ((spec->features[0] && spec->features[0][0] != 0xFFFFFFFF)
-		      || (spec->features[1] && spec->features[1][0] != 0xFFFFFFFF))
-		    continue;
-		}
-	      else if (! font->check_otf (font, spec))
-		continue;
-	      goto found;
-	    }
-	  best = flt;
-	}
-      if (best == NULL)
-	return NULL;
-      flt = best;
-      goto found;
+      if (! font)
+	font_id = Mt;
+      else if (mflt_font_id)
+	font_id = mflt_font_id (font);
     }
-  if (c >= 0)
+  if (font_id != Mnil)
     {
-      MPLIST_DO (pl, plist)
+      table = get_flt_find_cache (font_id);
+      flt = mchartable_lookup (table, c);
+      if (flt)
 	{
-	  flt = MPLIST_VAL (pl);
-	  if (mchartable_lookup (flt->coverage->table, c))
-	    goto found;
+	  flt_find_hits++;
+	  return (flt == (MFLT *) &flt_find_none ? NULL : flt);
 	}
+      flt_find_misses++;
     }
-  return NULL;
-
- found:
-  if (! CHECK_FLT_STAGES (flt))
-    return NULL;
-  if (font && flt->need_config && mflt_font_id)
-    flt = configure_flt (flt, font, mflt_font_id (font));
+  flt = find_flt (c, font);
+  if (table)
+    mchartable_set (table, c, flt ? flt : (MFLT *) &flt_find_none);
   return flt;
 }
 
@@ -2937,6 +3971,38 @@ mflt_run (MFLTGlyphString *gstring, int from, int to,
   int c, i, j, k;
   int this_from, this_to;
   MSymbol font_id = mflt_font_id ? mflt_font_id (font) : Mnil;
+  FLTRunCache probe, *cache = NULL;
+
+  if (mflt_run_cache_size <= 0)
+    {
+      if (flt_run_head)
+	free_flt_run_cache ();
+    }
+  else if (font_id != Mnil && from < to
+	   && gstring->glyph_size >= sizeof (MFLTGlyph)
+	   && setup_flt_run_key (&probe,
+				 alloca ((sizeof (int) + gstring->glyph_size
+					  - sizeof (MFLTGlyph)) * (to - from)),
+				 font_id, flt, font, gstring, from, to) == 0)
+    {
+      cache = lookup_flt_run_cache (&probe);
+      if (cache)
+	{
+	  out = *gstring;
+	  out.glyphs = (MFLTGlyph *) cache->glyphs;
+	  out.used = out.allocated = cache->used;
+	  if (GREPLACE (&out, 0, cache->used, gstring, from, to) < 0)
+	    return -2;
+	  for (i = from; i < from + cache->used; i++)
+	    {
+	      g = GREF (gstring, i);
+	      g->from += from;
+	      g->to += from;
+	    }
+	  return from + cache->used;
+	}
+      cache = &probe;
+    }
 
   out = *gstring;
   out.glyphs = NULL;
@@ -3047,6 +4113,7 @@ mflt_run (MFLTGlyphString *gstring, int from, int to,
 	  ctx.match_indices = match_indices;
 	  ctx.font = font;
 	  ctx.cluster_begin_idx = -1;
+	  ctx.regex_match_len = -1;
 	  ctx.in = gstring;
 	  ctx.out = &out;
 	  j = run_stages (gstring, this_from, this_to, flt, &ctx);
@@ -3108,9 +4175,84 @@ mflt_run (MFLTGlyphString *gstring, int from, int to,
 	}
     }
 
+  if (cache)
+    put_flt_run_cache (cache, gstring, from, to);
   return to;
 }
 
+/*=*/
+/***en
+    @brief Size of the cache of layout results.
+
+    The variable mflt_run_cache_size is the maximum number of bytes
+    that the m17n library uses for keeping the results of #mflt_run
+    (), so that the same characters are not laid out again with the
+    same font and FLT.  When the cache is full, the least recently used
+    results are discarded.  The default value is zero, which means
+    that results are not cached.
+
+    A result is cached only if the variable #mflt_font_id is set and
+    returns a non-nil symbol for the font, and no glyph is encoded
+    before calling #mflt_run ().  The symbol must identify the font
+    and its callback functions, and the members \<x_ppem\> and
+    \<y_ppem\> of the font are also compared.  When the glyph string
+    has a larger \<glyph_size\> than that of #MFLTGlyph, the extra
+    bytes of input glyphs are compared too, and are copied along with
+    the output glyphs.  */
+
+/***ja
+    @brief 쥤ȷ̤Υå礭.
+
+    ѿ mflt_run_cache_size ϡƱʸƱեȤ FLT Ǻ
+    쥤ȤʤƤ褦 #mflt_run () η̤ݻ뤿
+    m17n 饤֥꤬ѤХȿǤ롣å夬դˤ
+    ȡǤĹֻȤƤʤ̤ΤƤ롣ǥեͤ 0
+    Ǥꡢ̤ϥå夵ʤ
+
+    ̤å夵Τϡѿ #mflt_font_id ꤵƤƤ
+    ΥեȤФ nil Ǥʤܥ֤#mflt_run () Ƥ
+    ˤɤΥդ⥨󥳡ɤƤʤ˸¤롣Υܥ
+    եȤȤΥХåؿ̤ʤƤϤʤ餺եȤ
+     \<x_ppem\>  \<y_ppem\> Ӥ롣
+    \<glyph_size\>  #MFLTGlyph 礭礭硢ϥդ
+    ;ʬʥХȤӤ졢ϥդȤȤ˥ԡ롣  */
+
+int mflt_run_cache_size;
+
+/*=*/
+/***en
+    @brief Get the statistics of the cache of layout results.
+
+    The mflt_run_cache_stats () function stores the number of calls
+    of #mflt_run () that found their result in the cache in the place
+    pointed by $HITS, and the number of calls that had to lay out
+    characters in the place pointed by $MISSES.  Calls that can't use
+    the cache are not counted.  $HITS and/or $MISSES may be NULL.
+
+    @seealso
+    mflt_run_cache_size  */
+
+/***ja
+    @brief 쥤ȷ̤Υåפ.
+
+    ؿ mflt_run_cache_stats () ϡ̤򥭥å夫鸫Ĥ
+    #mflt_run () θƤӽФο $HITS ؤˡʸ쥤
+    ȤʤФʤʤäƤӽФο $MISSES ؤ˳Ǽ
+    롣åȤʤƤӽФϿʤ$HITS  $MISSES 
+    NULL Ǥ褤
+
+    @seealso
+    mflt_run_cache_size  */
+
+void
+mflt_run_cache_stats (int *hits, int *misses)
+{
+  if (hits)
+    *hits = flt_run_hits;
+  if (misses)
+    *misses = flt_run_misses;
+}
+
 /***en
     @brief Flag to control several new OTF handling commands.
 
@@ -427,6 +427,10 @@ extern MCharTable *mflt_coverage (MFLT *flt);
 extern int mflt_run (MFLTGlyphString *gstring, int from, int to,
 		     MFLTFont *font, MFLT *flt);
 
+extern int mflt_run_cache_size;
+
+extern void mflt_run_cache_stats (int *hits, int *misses);
+
 /*=*/
 /*** @} */
 
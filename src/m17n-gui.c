@@ -110,6 +110,8 @@ free_frame (void *object)
 {
   MFrame *frame = (MFrame *) object;
 
+  mdraw__free_layout_cache (frame);
+  mface__free_realized_face_table (frame);
   (*frame->driver->close) (frame);
   M17N_OBJECT_UNREF (frame->face);
   M17N_OBJECT_UNREF (frame->font_driver_list);
@@ -143,7 +145,6 @@ register_device_library (MSymbol name, char *lib)
 static struct {
   MPlist *realized_fontset_list;
   MPlist *realized_font_list;
-  MPlist *realized_face_list;
 } null_device;
 
 static void
@@ -181,7 +182,6 @@ null_device_init ()
 {
   null_device.realized_fontset_list = mplist ();
   null_device.realized_font_list = mplist ();
-  null_device.realized_face_list = mplist ();  
   return 0;
 }
 
@@ -194,10 +194,6 @@ null_device_fini ()
     mfont__free_realized_fontset ((MRealizedFontset *) MPLIST_VAL (plist));
   M17N_OBJECT_UNREF (null_device.realized_fontset_list);
 
-  MPLIST_DO (plist, null_device.realized_face_list)
-    mface__free_realized ((MRealizedFace *) MPLIST_VAL (plist));
-  M17N_OBJECT_UNREF (null_device.realized_face_list);
-
   if (MPLIST_VAL (null_device.realized_font_list))
     mfont__free_realized (MPLIST_VAL (null_device.realized_font_list));
   M17N_OBJECT_UNREF (null_device.realized_font_list);
@@ -218,7 +214,6 @@ null_device_open (MFrame *frame, MPlist *param)
   frame->font_driver_list = mplist ();
   mplist_add (frame->font_driver_list, Mfreetype, &mfont__ft_driver);
   frame->realized_font_list = null_device.realized_font_list;
-  frame->realized_face_list = null_device.realized_face_list;
   frame->realized_fontset_list = null_device.realized_fontset_list;
   face = mface_copy (mface__default);
   mplist_push (param, Mface, face);
@@ -229,10 +224,18 @@ null_device_open (MFrame *frame, MPlist *param)
 static MDeviceLibraryInterface null_interface =
   { NULL, NULL, null_device_init, null_device_open, null_device_fini };
 
+/** Raw pixel buffer device support (m17n-raw.c).  It is built in
+    because it depends on nothing but FreeType.  */
+
+static MDeviceLibraryInterface raw_interface =
+  { NULL, NULL, mraw__device_init, mraw__device_open, mraw__device_fini };
+
 #endif
 
 /* Internal API */
 
+unsigned mframe__tick;
+
 
 /* External API */
 
@@ -255,11 +258,13 @@ m17n_init_win (void)
   MDEBUG_PUSH_TIME ();
 
   Mgd = msymbol ("gd");
+  Mraw = msymbol ("raw");
 
   Mfont = msymbol ("font");
   Mfont_width = msymbol ("font-width");
   Mfont_ascent = msymbol ("font-ascent");
   Mfont_descent = msymbol ("font-descent");
+  Mlayout_cache_size = msymbol ("layout-cache-size");
   Mdevice = msymbol ("device");
 
   Mdisplay = msymbol ("display");
@@ -330,6 +335,11 @@ m17n_fini_win (void)
       (*null_interface.fini) ();
       null_interface.handle = NULL;
     }
+  if (raw_interface.handle)
+    {
+      (*raw_interface.fini) ();
+      raw_interface.handle = NULL;
+    }
 #endif	/* not HAVE_FREETYPE */
   M17N_OBJECT_UNREF (device_library_list);
   minput__win_fini ();
@@ -395,6 +405,8 @@ MSymbol Mdevice, Mdisplay, Mscreen, Mdrawable, Mdepth, Mcolormap, Mwidget;
 
 MSymbol Mgd;
 
+MSymbol Mraw;
+
 /*=*/
 
 /***en
@@ -412,6 +424,7 @@ MSymbol Mfont;
 MSymbol Mfont_width;
 MSymbol Mfont_ascent;
 MSymbol Mfont_descent;
+MSymbol Mlayout_cache_size;
 
 /*=*/
 
@@ -430,7 +443,8 @@ MSymbol Mfont_descent;
 
     <ul>
 
-    <li> @b Mdevice, the value must be one of #Mx, @b Mgd, and #Mnil.
+    <li> @b Mdevice, the value must be one of #Mx, @b Mgd, @b Mraw,
+    and #Mnil.
 
     If the value is #Mx, the frame is for X Window System.  The
     argument #MDrawWindow specified together with the frame must be of
@@ -442,6 +456,17 @@ MSymbol Mfont_descent;
     frame must be of type @c gdImagePtr.  The frame is writable
     only, thus functions minput_XXX can't be used for the frame.
 
+    If the value is @b Mraw, the frame is for a pixel buffer in
+    memory.  The argument #MDrawWindow specified together with the
+    frame must be a pointer to #MDrawBuffer whose contents are set by
+    the caller.  The device needs no library other than FreeType, and
+    keeps no drawing state of its own, thus many frames can be opened
+    at once.  Frames of the same resolution share realized fonts, so
+    functions mdraw_XXX must not be called concurrently even for
+    different frames.  If the m17n library is compiled with the macro
+    @c M17N_THREAD_SAFE defined, only the rendering of glyph images is
+    protected by a lock.  The frame is writable only.
+
     If the value is #Mnil, the frame is for a null device.  The frame
     is not writable nor readable, thus functions mdraw_XXX that
     require the argument #MDrawWindow and functions minput_XXX can't
@@ -519,6 +544,23 @@ MSymbol Mfont_descent;
 
     </ul>
 
+    The following key is also recognized on any device.
+
+    <ul>
+
+    <li> #Mlayout_cache_size, the value must be an integer.
+
+    The frame caches the layout of lines (glyph strings) by their
+    contents up to the specified number of bytes, and a line of
+    another M-text that has the same characters, text properties, and
+    drawing control shares the cached layout.  This speeds up drawing
+    the same short texts repeatedly from fresh M-texts.  The least
+    recently used layouts are discarded when the cache exceeds the
+    size.  If this parameter is not specified or the value is zero,
+    the cache is not used.
+
+    </ul>
+
     @return
     If the operation was successful, mframe () returns a pointer to a
     newly created frame.  Otherwise, it returns @c NULL.  */
@@ -535,7 +577,8 @@ MSymbol Mfont_descent;
 
     <ul>
 
-    <li> @b Mdevice. ͤ #Mx, @b Mgd, #Mnil Τ줫ǤʤƤϤʤʤ
+    <li> @b Mdevice. ͤ #Mx, @b Mgd, @b Mraw, #Mnil
+    Τ줫ǤʤƤϤʤʤ
 
     ͤ #Mx ʤСե졼 X ɥƥѤǤ롣
     Υե졼ȶ˻ꤵ줿 #MDrawWindow ϡ @c Window
@@ -547,6 +590,17 @@ MSymbol Mfont_descent;
     #MDrawWindow ϡ @c gdImagePtr ǤʤƤϤʤʤե졼Ͻ񤭽ФѤǤꡢ
     minput_ ǻϤޤ̾δؿϻѤǤʤ
 
+    ͤ @b Mraw ʤСե졼ϥΥԥХåեѤǤ롣
+    Υե졼ȶ˻ꤵ줿 #MDrawWindow ϡƤӽФ¦Ƥꤷ
+    #MDrawBuffer ؤΥݥ󥿤ǤʤƤϤʤʤΥǥХ FreeType
+    ʳΥ饤֥ɬפȤȤǤ֤ʤΤǡ
+    ¿Υե졼Ʊ˳ȤǤ롣Ʊ٤Υե졼
+    ¸줿եȤͭΤǡۤʤե졼ФƤǤäƤ
+    mdraw_ ǻϤޤ̾δؿ¹ԤƸƤǤϤʤʤm17n
+    饤֥꤬ޥ @c M17N_THREAD_SAFE ƥѥ뤵
+    Ǥ⡢åݸΤϥե᡼Ǥ롣
+    ե졼Ͻ񤭽ФѤǤ롣
+
     ͤ #Mnil ʤСե졼, null 
     ǥХѤǤ롣Υե졼ɤ߽񤭤ǤʤΤǡ #MDrawWindow 
     ɬפȤmdraw_ ǻϤޤ̾δؿ䡢minput_ ǻϤޤ̾δؿϻѤǤʤ
@@ -613,6 +667,20 @@ MSymbol Mfont_descent;
 
     </ul>
 
+    ʲΥϤɤΥǥХǤǧ롣
+
+    <ul>
+
+    <li> #Mlayout_cache_size. ͤǤʤƤϤʤʤ
+
+    ե졼ϹԤΥ쥤ȡʥˤ򤽤Ƥ򥭡Ȥƻꤵ줿Хȿޤǥå夷
+    Ʊʸƥȥץѥƥ̤ M-text ιԤϥå夵줿쥤Ȥͭ롣
+    ˤꡢƱûƥȤ򿷤 M-text 鷫֤褹®ʤ롣
+    å夬ΥĶȡǤĹȤƤʤ쥤Ȥ˴롣
+    Υѥ᡼ꤵʤͤ 0 ʤСåϻȤʤ
+
+    </ul>
+
     @return
      mframe() Ͽե졼ؤΥݥ󥿤֤Ǥʤ
     @c NULL ֤  */
@@ -641,10 +709,10 @@ mframe (MPlist *plist)
       device = Mx;
     }
 
-  if (device == Mnil)
+  if (device == Mnil || device == Mraw)
     {
 #ifdef HAVE_FREETYPE
-      interface = &null_interface;
+      interface = device == Mnil ? &null_interface : &raw_interface;
       if (! interface->handle)
 	{
 	  (*interface->init) ();
@@ -680,6 +748,7 @@ mframe (MPlist *plist)
     }
 
   M17N_OBJECT (frame, free_frame, MERROR_FRAME);
+  MFRAME_NEW_TICK (frame);
   if ((*interface->open) (frame, plist) < 0)
     {
       free (frame);
@@ -693,6 +762,8 @@ mframe (MPlist *plist)
   MPLIST_DO (pl, plist)
     if (MPLIST_KEY (pl) == Mface)
       mface_merge (frame->face, (MFace *) MPLIST_VAL (pl));
+    else if (MPLIST_KEY (pl) == Mlayout_cache_size)
+      frame->layout_cache_size = (int) MPLIST_VAL (pl);
   mface__update_frame_face (frame);
   frame->font
     = frame->rface->rfont ? (MFont *) frame->rface->rfont : NULL;
@@ -724,6 +795,9 @@ mframe (MPlist *plist)
 
         Mfont_descent   int             Descent of the default font.
 
+        Mlayout_cache_size
+                        int             Budget of the layout cache.
+
 @endverbatim
 
     In the m17n-X library, the followings are also accepted.
@@ -763,6 +837,9 @@ mframe (MPlist *plist)
 
         Mfont_descent   int             ǥեȤΥեȤ descent
 
+        Mlayout_cache_size
+                        int             쥤ȥå
+
 @endverbatim
 
      m17n-X 饤֥ǤϡʲΥѤǤ롣
@@ -796,6 +873,8 @@ mframe_get_prop (MFrame *frame, MSymbol key)
     return (void *) (frame->ascent);
   if (key == Mfont_descent)
     return (void *) (frame->descent);
+  if (key == Mlayout_cache_size)
+    return (void *) (frame->layout_cache_size);
   return (*frame->driver->get_prop) (frame, key);
 }
 
@@ -85,11 +85,13 @@ typedef struct MFrame MFrame;
 /*=*/
 
 extern MSymbol Mdevice;
+extern MSymbol Mraw;
 
 extern MSymbol Mfont;
 extern MSymbol Mfont_width;
 extern MSymbol Mfont_ascent;
 extern MSymbol Mfont_descent;
+extern MSymbol Mlayout_cache_size;
 extern MFrame *mframe_default;
 
 extern MSymbol Mdisplay;
@@ -148,6 +150,8 @@ extern MSymbol Mx, Mfreetype, Mxft;
 
 extern MPlist *mfont_freetype_path;
 
+extern int mfont_glyph_cache_size;
+
 extern MFont *mfont ();
 
 extern MFont *mfont_copy (MFont *font);
@@ -466,6 +470,75 @@ extern void mface_update (MFrame *frame, MFace *face);
 typedef void *MDrawWindow;
 /*=*/
 
+/*** @ingroup m17nDraw */
+/***en
+    @brief Pixel formats of #MDrawBuffer.
+
+    The enum #MDrawBufferFormat is for the pixel format of the
+    structure #MDrawBuffer.  */
+/***ja
+    @brief #MDrawBuffer Υԥ.
+
+     #MDrawBufferFormat Ϲ¤ #MDrawBuffer Υԥɽ  */
+
+enum MDrawBufferFormat
+  {
+    /***en Four bytes per pixel in the order of red, green, blue, and
+	alpha.  */
+    /***ja 1ԥ뤢4ХȤǡ֡Сġեν硣  */
+    MDRAW_BUFFER_RGBA,
+    /***en One byte of coverage per pixel.  */
+    /***ja 1ԥ뤢1ХȤʤΨ  */
+    MDRAW_BUFFER_A8
+  };
+
+/*=*/
+
+/*** @ingroup m17nDraw */
+/***en
+    @brief Type of pixel buffers for the raw device.
+
+    The type #MDrawBuffer is for a pixel buffer owned by an
+    application program.  A pointer to it must be coerced to the type
+    #MDrawWindow when used with a frame created with the device @b
+    Mraw.
+
+    Glyphs are blended into the buffer by their anti-aliased coverage.
+    In the format #MDRAW_BUFFER_A8, the background of a face is drawn
+    as 0, and the foreground as 255; the colors are not used.  */
+/***ja
+    @brief raw ǥХѤΥԥХåեη.
+
+    #MDrawBuffer ϥץꥱץबͭԥХåեѤηǤ롣
+    ǥХ @b Mraw ե졼ȶѤϡ
+    ؤΥݥ󥿤 #MDrawWindow ѴʤƤϤʤʤ
+
+    դϥꥢʤΨ˽äƥХåե˹롣
+     #MDRAW_BUFFER_A8 Ǥϡեطʤ 0ʤ 255 Ȥ졢
+    Ѥʤ  */
+
+typedef struct
+{
+  /***en Pointer to the first pixel of the top row.  */
+  /***ja ǾԤκǽΥԥؤΥݥ󥿡  */
+  unsigned char *data;
+
+  /***en Width and height of the buffer in pixels.  */
+  /***ja ХåեΥԥñ̤ȹ⤵  */
+  int width, height;
+
+  /***en Number of bytes from the start of a row to that of the next
+      row.  */
+  /***ja ԤƬ鼡ιԤƬޤǤΥХȿ  */
+  int stride;
+
+  /***en Pixel format of the buffer.  */
+  /***ja ХåեΥԥ  */
+  enum MDrawBufferFormat format;
+} MDrawBuffer;
+
+/*=*/
+
 /*** @ingroup m17nDraw */
 /***en
     @brief Window system dependent type for a region.
@@ -0,0 +1,597 @@
+/* m17n-raw.c -- implementation of the GUI API on raw pixel buffers.
+   Copyright (C) 2026
+     National Institute of Advanced Industrial Science and Technology (AIST)
+     Registration Number H15PRO112
+
+   This file is part of the m17n library.
+
+   The m17n library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   The m17n library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the m17n library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301 USA.  */
+
+#if !defined (FOR_DOXYGEN) || defined (DOXYGEN_INTERNAL_MODULE)
+/*** @addtogroup m17nInternal
+     @{ */
+
+/* The raw device draws into an MDrawBuffer supplied by the caller as
+   MDrawWindow.  It depends on nothing but FreeType, and keeps no
+   scratch image of its own; all the state of a drawing operation
+   lives in the buffer.  Frames of the same resolution share an
+   MRawDevice which holds the realized fonts and fontsets until the
+   device is finalized, so that opening a frame is cheap and any
+   number of frames can be opened.
+
+   As the frames share fonts, calls of the drawing functions for them
+   must not run concurrently.  Only the rendering of glyph images is
+   protected by mfont__ft_lock_render () in a library compiled with
+   M17N_THREAD_SAFE.  */
+
+#include "config.h"
+
+#ifdef HAVE_FREETYPE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "m17n-gui.h"
+#include "m17n-misc.h"
+#include "internal.h"
+#include "internal-gui.h"
+#include "symbol.h"
+#include "plist.h"
+#include "font.h"
+#include "fontset.h"
+#include "face.h"
+#include "device.h"
+
+#define INTERSECT_RECTANGLE(r1, r2, rect) \
+  mdevice__intersect_rectangle (r1, r2, rect)
+
+typedef struct
+{
+  M17NObject control;
+
+  int dpi;
+
+  /* The value is the root of the chain of realized fonts.  */
+  MPlist *realized_font_list;
+
+  /** List of pointers to realized fontsets.  */
+  MPlist *realized_fontset_list;
+
+  /* Frame the realized fonts and fontsets refer to after the frame
+     that realized them is closed.  Only the members needed to open
+     fonts are set.  */
+  MFrame frame;
+} MRawDevice;
+
+/* List of MRawDevices.  */
+static MPlist *device_list;
+
+/* Clip RECT by the bounds of BUF.  Return zero if nothing is left.  */
+
+static int
+clip_to_buffer (MDrawBuffer *buf, MDrawMetric *rect)
+{
+  MDrawMetric bounds;
+
+  bounds.x = bounds.y = 0;
+  bounds.width = buf->width, bounds.height = buf->height;
+  return INTERSECT_RECTANGLE (rect, &bounds, rect);
+}
+
+/* Return 1 iff the pixel at (X, Y) is in one of the rectangles of
+   REGION preceding the element TAIL.  Used not to blend a pixel twice
+   where rectangles of a region overlap.  */
+
+static int
+covered_before (MPlist *region, MPlist *tail, int x, int y)
+{
+  for (; region != tail; region = MPLIST_NEXT (region))
+    {
+      MDrawMetric *r = MPLIST_VAL (region);
+
+      if (x >= r->x && x < r->x + (int) r->width
+	  && y >= r->y && y < r->y + (int) r->height)
+	return 1;
+    }
+  return 0;
+}
+
+/* Fill the area RECT of BUF, which must be within the bounds of BUF,
+   by COLOR.  An A8 buffer is filled by VALUE instead.  */
+
+static void
+fill_clipped_rect (MDrawBuffer *buf, MDrawMetric *rect, int color, int value)
+{
+  unsigned char *row = buf->data + buf->stride * rect->y;
+  int i, j;
+
+  if (buf->format == MDRAW_BUFFER_A8)
+    for (i = 0; i < rect->height; i++, row += buf->stride)
+      memset (row + rect->x, value, rect->width);
+  else
+    {
+      unsigned char r = color >> 16, g = (color >> 8) & 0xFF, b = color & 0xFF;
+
+      for (i = 0; i < rect->height; i++, row += buf->stride)
+	{
+	  unsigned char *p = row + rect->x * 4;
+
+	  for (j = 0; j < rect->width; j++, p += 4)
+	    p[0] = r, p[1] = g, p[2] = b, p[3] = 0xFF;
+	}
+    }
+}
+
+static void
+fill_rect (MDrawBuffer *buf, int x, int y, int width, int height,
+	   int color, int value, MDrawRegion region)
+{
+  MDrawMetric rect;
+
+  if (width <= 0 || height <= 0)
+    return;
+  rect.x = x, rect.y = y, rect.width = width, rect.height = height;
+  if (! region)
+    {
+      if (clip_to_buffer (buf, &rect))
+	fill_clipped_rect (buf, &rect, color, value);
+    }
+  else
+    {
+      MPlist *plist;
+
+      MPLIST_DO (plist, (MPlist *) region)
+	{
+	  MDrawMetric *r = MPLIST_VAL (plist), new;
+
+	  if (INTERSECT_RECTANGLE (r, &rect, &new)
+	      && clip_to_buffer (buf, &new))
+	    fill_clipped_rect (buf, &new, color, value);
+	}
+    }
+}
+
+/* Blend the pixel at P by COLOR with coverage ALPHA (0..255).  An A8
+   pixel is blended toward VALUE instead.  */
+
+#define BLEND(c0, c1, alpha) \
+  ((c0) + (((int) (c1) - (int) (c0)) * (alpha) + 127) / 255)
+
+static void
+blend_clipped_bitmap (MDrawBuffer *buf, MGlyphBitmap *bitmap,
+		      int x, int y, MDrawMetric *clip,
+		      MPlist *region, MPlist *tail, int color, int value)
+{
+  unsigned char r = color >> 16, g = (color >> 8) & 0xFF, b = color & 0xFF;
+  int x0 = clip->x - x, x1 = x0 + clip->width;
+  int y0 = clip->y - y, y1 = y0 + clip->height;
+  int check_overlap = region && region != tail;
+  int i, j;
+
+  for (i = y0; i < y1; i++)
+    {
+      unsigned char *bmp = bitmap->buffer + bitmap->pitch * i;
+      unsigned char *row = buf->data + buf->stride * (y + i);
+
+      for (j = x0; j < x1; j++)
+	{
+	  int alpha = (bitmap->mono
+		       ? (bmp[j / 8] & (1 << (7 - (j % 8)))) ? 255 : 0
+		       : bmp[j]);
+	  unsigned char *p;
+
+	  if (! alpha
+	      || (check_overlap && covered_before (region, tail, x + j, y + i)))
+	    continue;
+	  if (buf->format == MDRAW_BUFFER_A8)
+	    {
+	      p = row + x + j;
+	      *p = BLEND (*p, value, alpha);
+	    }
+	  else
+	    {
+	      p = row + (x + j) * 4;
+	      p[0] = BLEND (p[0], r, alpha);
+	      p[1] = BLEND (p[1], g, alpha);
+	      p[2] = BLEND (p[2], b, alpha);
+	      p[3] = BLEND (p[3], 0xFF, alpha);
+	    }
+	}
+    }
+}
+
+static void
+blend_bitmap (MDrawBuffer *buf, MGlyphBitmap *bitmap, int x, int y,
+	      int color, int value, MDrawRegion region)
+{
+  MDrawMetric rect;
+  int width = bitmap->width;
+
+  if (bitmap->mono && width > bitmap->pitch * 8)
+    width = bitmap->pitch * 8;
+  if (width <= 0 || bitmap->rows <= 0)
+    return;
+  rect.x = x, rect.y = y;
+  rect.width = width, rect.height = bitmap->rows;
+  if (! region)
+    {
+      if (clip_to_buffer (buf, &rect))
+	blend_clipped_bitmap (buf, bitmap, x, y, &rect, NULL, NULL,
+			      color, value);
+    }
+  else
+    {
+      MPlist *plist;
+
+      MPLIST_DO (plist, (MPlist *) region)
+	{
+	  MDrawMetric *r = MPLIST_VAL (plist), new;
+
+	  if (INTERSECT_RECTANGLE (r, &rect, &new)
+	      && clip_to_buffer (buf, &new))
+	    blend_clipped_bitmap (buf, bitmap, x, y, &new,
+				  (MPlist *) region, plist, color, value);
+	}
+    }
+}
+
+static MRealizedFont *raw_font_open (MFrame *, MFont *, MFont *,
+				     MRealizedFont *);
+static void raw_render (MDrawWindow, int, int, MGlyphString *,
+			MGlyph *, MGlyph *, int, MDrawRegion);
+
+static MFontDriver raw_font_driver =
+  { NULL, raw_font_open, NULL, NULL, NULL, raw_render, NULL };
+
+static MRealizedFont *
+raw_font_open (MFrame *frame, MFont *font, MFont *spec, MRealizedFont *rfont)
+{
+  double size = font->size ? font->size : spec->size;
+  int reg = spec->property[MFONT_REGISTRY];
+  MRealizedFont *new;
+
+  if (rfont)
+    {
+      MRealizedFont *save = NULL;
+
+      for (; rfont; rfont = rfont->next)
+	if (rfont->font == font
+	    && (rfont->font->size ? rfont->font->size == size
+		: rfont->spec.size == size)
+	    && rfont->spec.property[MFONT_REGISTRY] == reg)
+	  {
+	    if (! save)
+	      save = rfont;
+	    if (rfont->driver == &raw_font_driver)
+	      return rfont;
+	  }
+      rfont = save;
+    }
+  rfont = (mfont__ft_driver.open) (frame, font, spec, rfont);
+  if (! rfont)
+    return NULL;
+  M17N_OBJECT_REF (rfont->info);
+  MSTRUCT_CALLOC (new, MERROR_WIN);
+  *new = *rfont;
+  new->driver = &raw_font_driver;
+  new->next = MPLIST_VAL (frame->realized_font_list);
+  MPLIST_VAL (frame->realized_font_list) = new;
+  return new;
+}
+
+static void
+raw_render (MDrawWindow win, int x, int y,
+	    MGlyphString *gstring, MGlyph *from, MGlyph *to,
+	    int reverse, MDrawRegion region)
+{
+  MDrawBuffer *buf = (MDrawBuffer *) win;
+  MRealizedFace *rface = from->rface;
+  int color, value;
+
+  if (from == to)
+    return;
+
+  /* It is assured that the all glyphs in the current range use the
+     same realized face.  */
+  color = ((int *) rface->info)[reverse ? COLOR_INVERSE : COLOR_NORMAL];
+  value = reverse ? 0 : 0xFF;
+  y -= rface->rfont->baseline_offset >> 6;
+
+  for (; from < to; x += from++->g.xadv)
+    {
+      MGlyphBitmap *bitmap;
+
+      mfont__ft_lock_render ();
+      bitmap = mfont__ft_render_glyph (rface->rfont, from->g.code,
+				       gstring->anti_alias);
+      blend_bitmap (buf, bitmap, x + bitmap->left + from->g.xoff,
+		    y - bitmap->top + from->g.yoff, color, value, region);
+      mfont__ft_unlock_render ();
+    }
+}
+
+static void
+free_device (void *object)
+{
+  MRawDevice *device = object;
+  MPlist *plist;
+
+  MPLIST_DO (plist, device->realized_fontset_list)
+    mfont__free_realized_fontset ((MRealizedFontset *) MPLIST_VAL (plist));
+  M17N_OBJECT_UNREF (device->realized_fontset_list);
+
+  if (MPLIST_VAL (device->realized_font_list))
+    mfont__free_realized (MPLIST_VAL (device->realized_font_list));
+  M17N_OBJECT_UNREF (device->realized_font_list);
+  M17N_OBJECT_UNREF (device->frame.font_driver_list);
+  free (object);
+}
+
+static void
+raw_close (MFrame *frame)
+{
+  MRawDevice *device = frame->device;
+  MRealizedFont *rfont;
+  MPlist *plist;
+
+  /* The fonts realized for FRAME are used by the other frames and by
+     frames opened later.  */
+  for (rfont = MPLIST_VAL (device->realized_font_list); rfont;
+       rfont = rfont->next)
+    if (rfont->frame == frame)
+      rfont->frame = &device->frame;
+  MPLIST_DO (plist, device->realized_fontset_list)
+    mfont__move_realized_fontset (MPLIST_VAL (plist), frame, &device->frame);
+  M17N_OBJECT_UNREF (device);
+}
+
+static void *
+raw_get_prop (MFrame *frame, MSymbol key)
+{
+  return NULL;
+}
+
+static void
+raw_fill_space (MFrame *frame, MDrawWindow win, MRealizedFace *rface,
+		int reverse,
+		int x, int y, int width, int height, MDrawRegion region)
+{
+  int *colors = rface->info;
+
+  fill_rect ((MDrawBuffer *) win, x, y, width, height,
+	     colors[reverse ? COLOR_NORMAL : COLOR_INVERSE],
+	     reverse ? 0xFF : 0, region);
+}
+
+static void
+raw_draw_empty_boxes (MDrawWindow win, int x, int y,
+		      MGlyphString *gstring, MGlyph *from, MGlyph *to,
+		      int reverse, MDrawRegion region)
+{
+  MDrawBuffer *buf = (MDrawBuffer *) win;
+  int *colors = from->rface->info;
+  int color = colors[reverse ? COLOR_INVERSE : COLOR_NORMAL];
+  int value = reverse ? 0 : 0xFF;
+  int height;
+
+  if (from == to)
+    return;
+
+  y -= gstring->ascent - 1;
+  height = gstring->ascent + gstring->descent - 2;
+  for (; from < to; x += from++->g.xadv)
+    {
+      int width = from->g.xadv - 1;
+
+      fill_rect (buf, x, y, width, 1, color, value, region);
+      fill_rect (buf, x, y + height - 1, width, 1, color, value, region);
+      fill_rect (buf, x, y + 1, 1, height - 2, color, value, region);
+      fill_rect (buf, x + width - 1, y + 1, 1, height - 2, color, value,
+		 region);
+    }
+}
+
+static void
+raw_draw_hline (MFrame *frame, MDrawWindow win, MGlyphString *gstring,
+		MRealizedFace *rface, int reverse,
+		int x, int y, int width, MDrawRegion region)
+{
+  enum MFaceHLineType type = rface->hline->type;
+  int height = rface->hline->width;
+  int *colors = rface->info;
+
+  y = (type == MFACE_HLINE_BOTTOM
+       ? y + gstring->text_descent - height
+       : type == MFACE_HLINE_UNDER
+       ? y + 1
+       : type == MFACE_HLINE_STRIKE_THROUGH
+       ? y - ((gstring->ascent + gstring->descent) / 2)
+       : y - gstring->text_ascent);
+  fill_rect ((MDrawBuffer *) win, x, y, width, height,
+	     colors[COLOR_HLINE], 0xFF, region);
+}
+
+static void
+raw_draw_box (MFrame *frame, MDrawWindow win, MGlyphString *gstring,
+	      MGlyph *g, int x, int y, int width, MDrawRegion region)
+{
+  MDrawBuffer *buf = (MDrawBuffer *) win;
+  int *colors = g->rface->info;
+  MRealizedFace *rface = g->rface;
+  MFaceBoxProp *box = rface->box;
+  int y0, y1;
+  int i;
+
+  y0 = y - (gstring->text_ascent
+	    + rface->box->inner_vmargin + rface->box->width);
+  y1 = y + (gstring->text_descent
+	    + rface->box->inner_vmargin + rface->box->width - 1);
+
+  if (g->type == GLYPH_BOX)
+    {
+      int x0, x1;
+
+      if (g->left_padding)
+	x0 = x + box->outer_hmargin, x1 = x + g->g.xadv - 1;
+      else
+	x0 = x, x1 = x + g->g.xadv - box->outer_hmargin - 1;
+
+      /* Draw the top side.  */
+      fill_rect (buf, x0, y0, x1 - x0 + 1, box->width,
+		 colors[COLOR_BOX_TOP], 0xFF, region);
+
+      /* Draw the bottom side.  */
+      fill_rect (buf, x0, y1 - box->width + 1, x1 - x0 + 1, box->width,
+		 colors[COLOR_BOX_BOTTOM], 0xFF, region);
+
+      if (g->left_padding > 0)
+	{
+	  /* Draw the left side.  */
+	  for (i = 0; i < rface->box->width; i++)
+	    fill_rect (buf, x0 + i, y0 + i, 1, y1 - y0 - i * 2 + 1,
+		       colors[COLOR_BOX_LEFT], 0xFF, region);
+	}
+      else
+	{
+	  /* Draw the right side.  */
+	  for (i = 0; i < rface->box->width; i++)
+	    fill_rect (buf, x1 - i, y0 + i, 1, y1 - y0 - i * 2 + 1,
+		       colors[COLOR_BOX_RIGHT], 0xFF, region);
+	}
+
+    }
+  else
+    {
+      /* Draw the top side.  */
+      fill_rect (buf, x, y0, width, box->width,
+		 colors[COLOR_BOX_TOP], 0xFF, region);
+
+      /* Draw the bottom side.  */
+      fill_rect (buf, x, y1 - box->width + 1, width, box->width,
+		 colors[COLOR_BOX_BOTTOM], 0xFF, region);
+    }
+}
+
+
+static MDeviceDriver raw_driver =
+  {
+    raw_close,
+    raw_get_prop,
+    mdevice__realize_face,
+    mdevice__free_realized_face,
+    raw_fill_space,
+    raw_draw_empty_boxes,
+    raw_draw_hline,
+    raw_draw_box,
+    NULL,
+    mdevice__region_from_rect,
+    mdevice__union_rect_with_region,
+    mdevice__intersect_region,
+    mdevice__region_add_rect,
+    mdevice__region_to_rect,
+    mdevice__free_region,
+    mdevice__dump_region,
+  };
+
+
+/* Internal API */
+
+int
+mraw__device_init ()
+{
+  mdevice__init ();
+  device_list = mplist ();
+
+  raw_font_driver.select = mfont__ft_driver.select;
+  raw_font_driver.find_metric = mfont__ft_driver.find_metric;
+  raw_font_driver.has_char = mfont__ft_driver.has_char;
+  raw_font_driver.encode_char = mfont__ft_driver.encode_char;
+  raw_font_driver.list = mfont__ft_driver.list;
+  raw_font_driver.check_otf = mfont__ft_driver.check_otf;
+  raw_font_driver.drive_otf = mfont__ft_driver.drive_otf;
+
+  return 0;
+}
+
+int
+mraw__device_fini ()
+{
+  MPlist *plist;
+
+  MPLIST_DO (plist, device_list)
+    M17N_OBJECT_UNREF (MPLIST_VAL (plist));
+  M17N_OBJECT_UNREF (device_list);
+  mdevice__fini ();
+  return 0;
+}
+
+int
+mraw__device_open (MFrame *frame, MPlist *param)
+{
+  MRawDevice *device = NULL;
+  MFace *face;
+  MPlist *plist;
+  int dpi = (int) mplist_get (param, Mresolution);
+
+  if (dpi == 0)
+    dpi = 100;
+  MPLIST_DO (plist, device_list)
+    {
+      device = MPLIST_VAL (plist);
+      if (device->dpi == dpi)
+	break;
+    }
+  if (MPLIST_TAIL_P (plist))
+    {
+      /* DEVICE_LIST keeps a reference to the device.  */
+      M17N_OBJECT (device, free_device, MERROR_WIN);
+      device->dpi = dpi;
+      device->realized_font_list = mplist ();
+      device->realized_fontset_list = mplist ();
+      device->frame.device = device;
+      device->frame.device_type = MDEVICE_SUPPORT_OUTPUT;
+      device->frame.dpi = dpi;
+      device->frame.driver = &raw_driver;
+      device->frame.font_driver_list = mplist ();
+      mplist_add (device->frame.font_driver_list, Mfreetype,
+		  &raw_font_driver);
+      device->frame.realized_font_list = device->realized_font_list;
+      device->frame.realized_fontset_list = device->realized_fontset_list;
+      mplist_push (device_list, Mt, device);
+    }
+  M17N_OBJECT_REF (device);
+
+  frame->device = device;
+  frame->device_type = MDEVICE_SUPPORT_OUTPUT;
+  frame->dpi = dpi;
+  frame->driver = &raw_driver;
+  frame->font_driver_list = mplist ();
+  mplist_add (frame->font_driver_list, Mfreetype, &raw_font_driver);
+  frame->realized_font_list = device->realized_font_list;
+  frame->realized_fontset_list = device->realized_fontset_list;
+  face = mface_copy (mface__default);
+  mface_put_prop (face, Mfoundry, Mnil);
+  mface_put_prop (face, Mfamily, Mnil);
+  mplist_push (param, Mface, face);
+  M17N_OBJECT_UNREF (face);
+  return 0;
+}
+
+#endif	/* HAVE_FREETYPE */
+
+/*** @} */
+#endif /* !FOR_DOXYGEN || DOXYGEN_INTERNAL_MODULE */
@@ -37,6 +37,29 @@
 
 /* External API */
 
+/***en
+    @brief Flag to make the initialization of the library lazy.
+
+    If the variable #m17n_lazy_init is set to nonzero before calling
+    M17N_INIT (), the definitions of charsets read from the m17n
+    database are just registered by name, and each charset is
+    actually defined on the first lookup by mchar_resolve_charset (),
+    mconv_resolve_coding (), or any other function that needs it.
+    Coding systems and character property tables are always realized
+    on demand.  The default value is 0.  */
+
+/***ja
+    @brief 饤֥νٱ䤵ե饰.
+
+    M17N_INIT () Ƥѿ #m17n_lazy_init  0 ʳꤹȡ
+    m17n ǡ١ɤ߹ޤ줿ʸåȤ̾Ͽ졢
+    ʸåȤ mchar_resolve_charset ()  mconv_resolve_coding ()
+    ʤɤɬפȤؿˤäƺǽ˻Ȥ줿Ȥ˼ºݤ롣
+    ɷϤʸץѥƥơ֥Ͼɬ׻˼β롣
+    ǥեͤ 0 Ǥ롣  */
+
+int m17n_lazy_init;
+
 void
 m17n_init (void)
 {
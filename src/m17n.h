@@ -34,6 +34,7 @@
 M17N_BEGIN_HEADER
 
 #if !defined (FOR_DOXYGEN) || defined (DOXYGEN_INTERNAL_MODULE)
+extern int m17n_lazy_init;
 extern void m17n_init (void);
 #undef M17N_INIT
 #ifdef _M17N_FLT_H_
@@ -743,6 +744,9 @@ extern MConverter *mconv_rebind_stream (MConverter *converter, FILE *fp);
 
 extern MText *mconv_decode (MConverter *converter, MText *mt);
 
+extern MText *mconv_decode_parallel (MConverter *converter, MText *mt,
+				     int nthreads);
+
 MText *mconv_decode_buffer (MSymbol name, const unsigned char *buf, int n);
 
 MText *mconv_decode_stream (MSymbol name, FILE *fp);   
@@ -1377,6 +1381,8 @@ extern char *minput_config_file (void);
 
 extern int minput_save_config (void);
 
+extern int minput_compile_im (MSymbol language, MSymbol name);
+
 extern int minput_callback (MInputContext *ic, MSymbol command);
 
 /* obsolete functions */
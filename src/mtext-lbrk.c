@@ -125,6 +125,9 @@ static char *lba_pair_table[] =
 
 static MCharTable *lbc_table;
 
+/* Lock for loading lbc_table.  */
+M17N_MUTEX (lbc_lock)
+
 /* Set LBC to enum LineBreakClass of the character at POS of MT
    (length is LEN) while converting LBC_AI and LBC_XX to LBC_AL,
    LBC_CB to LBC_B2, LBC_CR, LBC_LF, and LBC_NL to LBC_BK.  If POS is
@@ -138,20 +141,192 @@ static MCharTable *lbc_table;
       {									\
 	int c = mtext_ref_char ((MT), (POS));				\
 	(LBC) = (enum LineBreakClass) mchartable_lookup (lbc_table, c);	\
-	if ((LBC) == LBC_NL)						\
-	  (LBC) = LBC_BK;						\
-	else if ((LBC) == LBC_AI)					\
-	  (LBC) = ((OPTION) & MTEXT_LBO_AI_AS_ID) ? LBC_ID : LBC_AL;	\
-	else if (! ((OPTION) & MTEXT_LBO_KOREAN_SP)			\
-		 && (LBC) >= LBC_H2 && (LBC) <= LBC_JT)			\
-	  (LBC) = LBC_AL;						\
-	else if ((LBC) == LBC_CB)					\
-	  (LBC) = LBC_B2;						\
-	else if ((LBC) == LBC_XX)					\
-	  (LBC) = LBC_AL;						\
+	NORMALIZE_LBC ((LBC), (OPTION));				\
       }									\
   } while (0)
 
+#define NORMALIZE_LBC(LBC, OPTION)					\
+  do {									\
+    if ((LBC) == LBC_NL)						\
+      (LBC) = LBC_BK;							\
+    else if ((LBC) == LBC_AI)						\
+      (LBC) = ((OPTION) & MTEXT_LBO_AI_AS_ID) ? LBC_ID : LBC_AL;	\
+    else if (! ((OPTION) & MTEXT_LBO_KOREAN_SP)				\
+	     && (LBC) >= LBC_H2 && (LBC) <= LBC_JT)			\
+      (LBC) = LBC_AL;							\
+    else if ((LBC) == LBC_CB)						\
+      (LBC) = LBC_B2;							\
+    else if ((LBC) == LBC_XX)						\
+      (LBC) = LBC_AL;							\
+  } while (0)
+
+/* Like GET_LBC, but take the value of lbc_table from the chunk of
+   STATE if POS is in it.  */
+
+#define GET_STATE_LBC(LBC, MT, LEN, POS, OPTION, STATE)		\
+  do {									\
+    if ((POS) >= (STATE)->lbc_from && (POS) < (STATE)->lbc_to)		\
+      {									\
+	(LBC) = ((enum LineBreakClass)					\
+		 (STATE)->lbc_chunk[(POS) - (STATE)->lbc_from]);	\
+	NORMALIZE_LBC ((LBC), (OPTION));				\
+      }									\
+    else								\
+      GET_LBC ((LBC), (MT), (LEN), (POS), (OPTION));			\
+  } while (0)
+
+static void
+load_lbc_table ()
+{
+  if (! M17N_LOAD_ACQUIRE (lbc_table))
+    {
+      M17N_LOCK (lbc_lock);
+      if (! lbc_table)
+	{
+	  MSymbol key = mchar_define_property ("linebreak", Minteger);
+
+	  M17N_STORE_RELEASE (lbc_table, mchar_get_prop_table (key, NULL));
+	}
+      M17N_UNLOCK (lbc_lock);
+    }
+}
+
+/* Number of characters whose line break classes are looked up at
+   once by fill_lbc_chunk ().  */
+#define LBC_CHUNK_SIZE 256
+
+/* State of scanning an M-text by line_break_p ().  It remembers the
+   results of the last backward skip of combining marks and the last
+   word segmentation to avoid repeating them at each position.  */
+
+typedef struct
+{
+  /* Positions CM_BASE + 1 through CM_TOP are all of LBC_CM, and the
+     position CM_BASE is not.  */
+  int cm_top, cm_base;
+
+  /* Positions WS_FROM through WS_TO - 1 are a word segmented by
+     mtext__word_segment (), which returned WS_VAL for them.  */
+  int ws_from, ws_to, ws_val;
+
+  /* LBC_CHUNK[I] is the value of lbc_table for the character at
+     LBC_FROM + I, where LBC_FROM + I < LBC_TO.  */
+  void *lbc_chunk[LBC_CHUNK_SIZE];
+  int lbc_from, lbc_to;
+} MLineBreakState;
+
+/* Look up lbc_table for the characters of MT from POS in a batch,
+   and store the values in the chunk of STATE.  */
+
+static void
+fill_lbc_chunk (MText *mt, int len, int pos, MLineBreakState *state)
+{
+  if (pos < 0)
+    pos = 0;
+  state->lbc_from = pos;
+  state->lbc_to = pos + LBC_CHUNK_SIZE < len ? pos + LBC_CHUNK_SIZE : len;
+  if (state->lbc_from < state->lbc_to)
+    mchartable_lookup_mtext (lbc_table, mt, state->lbc_from, state->lbc_to,
+			     state->lbc_chunk);
+}
+
+/* Return 1 if POS (0 < POS < LEN) is a proper linebreak position of
+   MT, i.e. mtext_line_break () returns POS for POS provided that
+   there's a linebreak position before POS.  Otherwise return 0.  This
+   checks the same conditions as the first step of the backward search
+   in mtext_line_break ().  */
+
+static int
+line_break_p (MText *mt, int len, int pos, int option, MLineBreakState *state)
+{
+  enum LineBreakClass Blbc, Albc;
+  int Bpos;
+  int indirect;
+  enum LineBreakAction action;
+
+  GET_STATE_LBC (Albc, mt, len, pos, option, state);
+  if (Albc == LBC_SP)
+    {
+      if (! (option & MTEXT_LBO_SP_CM))
+	return 0;
+      GET_STATE_LBC (Albc, mt, len, pos + 1, option, state);
+      if (Albc != LBC_CM)
+	return 0;
+      Albc = LBC_ID;
+    }
+  else if ((option & MTEXT_LBO_SP_CM) && Albc == LBC_CM)
+    {
+      GET_STATE_LBC (Blbc, mt, len, pos - 1, option, state);
+      if (Blbc == LBC_SP)
+	return 0;
+    }
+
+  if (Albc == LBC_CR)
+    Albc = LBC_BK;
+  else if (Albc == LBC_LF)
+    {
+      GET_STATE_LBC (Blbc, mt, len, pos - 1, option, state);
+      if (Blbc == LBC_CR)
+	return 0;
+      Albc = LBC_BK;
+    }
+  else if (Albc == LBC_SA)
+    {
+      if (pos < state->ws_from || pos >= state->ws_to)
+	{
+	  int from, to;
+	  int val = mtext__word_segment (mt, pos, &from, &to);
+
+	  if (val < 0)
+	    from = to = pos;
+	  state->ws_from = from, state->ws_to = to, state->ws_val = val;
+	  if (val < 0)
+	    state->ws_to++;
+	}
+      if (state->ws_from < pos)
+	return 0;
+      Albc = state->ws_val > 0 ? LBC_BB : LBC_AL;
+    }
+
+  Bpos = pos;
+  do {
+    Bpos--;
+    GET_STATE_LBC (Blbc, mt, len, Bpos, option, state);
+  } while (Blbc == LBC_SP);
+  if (Blbc == LBC_BK || Blbc == LBC_LF || Blbc == LBC_CR)
+    /* Explicit break.  */
+    return 1;
+
+  indirect = Bpos + 1 < pos;
+
+  if (Blbc == LBC_CM)
+    {
+      int top = Bpos;
+
+      if (state->cm_top == Bpos - 1)
+	Bpos = state->cm_base + 1;
+      do {
+	Bpos--;
+	GET_STATE_LBC (Blbc, mt, len, Bpos, option, state);
+      } while (Blbc == LBC_CM);
+      state->cm_top = top, state->cm_base = Bpos;
+      if ((option & MTEXT_LBO_SP_CM) && (Blbc == LBC_SP))
+	Blbc = LBC_ID;
+      else if (Blbc == LBC_SP || Blbc == LBC_ZW
+	       || Blbc == LBC_BK || Blbc == LBC_LF || Blbc == LBC_CR)
+	Blbc = LBC_AL;
+    }
+  if (Blbc == LBC_SA)
+    Blbc = LBC_AL;
+
+  if (Albc == LBC_BK)
+    return 0;
+  action = lba_pair_table[Blbc][Albc];
+  return (action == LBA_DIRECT
+	  || ((action == LBA_INDIRECT || action == LBA_COMBINING_INDIRECT)
+	      && indirect));
+}
+
 
 /*** @} */
 #endif /* !FOR_DOXYGEN || DOXYGEN_INTERNAL_MODULE */
@@ -196,12 +371,7 @@ mtext_line_break (MText *mt, int pos, int option, int *after)
       return pos;
     }
 
-  if (! lbc_table)
-    {
-      MSymbol key = mchar_define_property ("linebreak", Minteger);
-
-      lbc_table = mchar_get_prop_table (key, NULL);
-    }
+  load_lbc_table ();
 
   GET_LBC (lbc, mt, len, pos, option);
   Apos = pos;
@@ -432,6 +602,122 @@ mtext_line_break (MText *mt, int pos, int option, int *after)
   return (break_before > 0 ? break_before : break_after);
 }
 
+/*=*/
+
+/***en
+    @brief Find all linebreak positions in a region of an M-text.
+
+    The mtext_line_breaks () function finds all proper linebreak
+    positions of M-text $MT between $FROM and $TO (both inclusive)
+    in a single forward pass, makes an array of them in ascending
+    order, and stores the pointer to the array in the place pointed to
+    by $BREAKS.  A position is included if and only if
+    mtext_line_break () returns the position itself for it.  The end
+    of $MT is always a linebreak position.
+
+    $OPTION has the same meaning as in mtext_line_break ().
+
+    The caller should free the array by free () when it becomes
+    unnecessary.  To break a long text incrementally, call this
+    function for consecutive regions.
+
+    @return
+    If the operation was successful, mtext_line_breaks () returns the
+    number of elements of the array.  Otherwise it returns -1 and
+    assigns an error code to the external variable #merror_code.  */
+
+/***ja
+    @brief M-text ΰƤβ԰֤.
+
+    ؿ mtext_line_breaks () ϡM-text $MT  $FROM  $TO ޤ
+    ξüޤˤŬڤʲ԰֤٤Ƶᡢ򾺽¤٤äơ
+    $BREAKS ؤˤؤΥݥ󥿤Ǽ롣
+    ֤ޤޤΤϡΰ֤Ф mtext_line_break ()
+    ΰּȤ֤˸¤롣$MT Ͼ˲԰֤Ǥ롣
+
+    $OPTION ΰ̣ mtext_line_break () ƱǤ롣
+
+    ƤӽФ¦פˤʤä free () ǲʤФʤʤ
+    ĹƥȤ򾯤ĲԤϡϢ³ΰˤĤƤδؿƤ٤Ф褤
+
+    @return
+    Сmtext_line_breaks () ǿ֤
+    Ǥʤ -1 ֤ѿ #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_RANGE
+
+    @seealso
+    mtext_line_break ()  */
+
+int
+mtext_line_breaks (MText *mt, int from, int to, int option, int **breaks)
+{
+  int len = mtext_len (mt);
+  int size, used = 0;
+  int pos, found, i;
+  MLineBreakState state;
+
+  M_CHECK_RANGE_X (mt, from, to, -1);
+  load_lbc_table ();
+  size = (to - from) / 8 + 1;
+  MTABLE_MALLOC (*breaks, size, MERROR_MTEXT);
+
+  state.cm_top = state.cm_base = -2;
+  state.ws_from = state.ws_to = 0;
+  state.ws_val = 0;
+  state.lbc_from = state.lbc_to = 0;
+
+  /* FOUND is nonzero if there's a linebreak position before POS.
+     Otherwise, mtext_line_break () searches forward from POS, and
+     returns POS for a space following a hard break.  */
+  pos = from > 0 || len == 0 ? from : 1;
+  fill_lbc_chunk (mt, len, pos - LBC_CHUNK_SIZE / 2, &state);
+  for (found = 0, i = pos - 1; i > 0 && ! found; i--)
+    found = line_break_p (mt, len, i, option, &state);
+  for (; pos <= to; pos++)
+    {
+      int this;
+
+      if (pos + 1 >= state.lbc_to && state.lbc_to < len)
+	fill_lbc_chunk (mt, len, pos - 2, &state);
+      if (pos == len)
+	this = 1;
+      else if (line_break_p (mt, len, pos, option, &state))
+	this = found = 1;
+      else if (! found)
+	{
+	  enum LineBreakClass lbc;
+
+	  GET_STATE_LBC (lbc, mt, len, pos, option, &state);
+	  this = 0;
+	  if (lbc == LBC_SP)
+	    {
+	      if (option & MTEXT_LBO_SP_CM)
+		GET_STATE_LBC (lbc, mt, len, pos + 1, option, &state);
+	      if (lbc != LBC_CM)
+		{
+		  GET_STATE_LBC (lbc, mt, len, pos - 1, option, &state);
+		  this = (lbc == LBC_BK || lbc == LBC_LF || lbc == LBC_CR);
+		}
+	    }
+	}
+      else
+	this = 0;
+      if (this)
+	{
+	  if (used == size)
+	    {
+	      size *= 2;
+	      MTABLE_REALLOC (*breaks, size, MERROR_MTEXT);
+	    }
+	  (*breaks)[used++] = pos;
+	}
+    }
+  return used;
+}
+
 /*** @} */ 
 
 /*
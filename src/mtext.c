@@ -152,6 +152,24 @@ static MSymbol M_charbag;
     (char_pos)--;							\
   } while (0)
 
+/** In an M-text of POS_INDEX_THRESHOLD or more characters, the unit
+    position of every POS_INDEX_INTERVAL-th character is recorded in
+    MT->pos_index on demand, so that the conversion between character
+    and unit positions need not scan more than POS_INDEX_INTERVAL
+    characters.  */
+
+#define POS_INDEX_INTERVAL 128
+#define POS_INDEX_THRESHOLD 4096
+
+/** Discard the entries of the position index of M-text MT that may
+    be invalidated by a modification at character position POS.  */
+
+#define POS_INDEX_TRUNCATE(mt, pos)				\
+  do {								\
+    if ((mt)->pos_index_used > (pos) / POS_INDEX_INTERVAL + 1)	\
+      (mt)->pos_index_used = (pos) / POS_INDEX_INTERVAL + 1;	\
+  } while (0)
+
 #define FORMAT_COVERAGE(fmt)					\
   (fmt == MTEXT_FORMAT_UTF_8 ? MTEXT_COVERAGE_FULL		\
    : fmt == MTEXT_FORMAT_US_ASCII ? MTEXT_COVERAGE_ASCII	\
@@ -358,7 +376,8 @@ insert (MText *mt1, int pos, MText *mt2, int from, int to)
 
   mtext__adjust_plist_for_insert
     (mt1, pos, to - from,
-     mtext__copy_plist (mt2->plist, from, to, mt1, pos));
+     mtext__copy_plist (mt2->plist, from, to, mt1));
+  POS_INDEX_TRUNCATE (mt1, pos);
   mt1->nchars += to - from;
   mt1->nbytes += new_units;
   if (mt1->cache_char_pos > pos)
@@ -380,7 +399,7 @@ get_charbag (MText *mt)
 
   if (prop)
     {
-      if (prop->end == mt->nchars)
+      if (MTEXTPROP_END (prop) == mt->nchars)
 	return ((MCharTable *) prop->val);
       mtext_detach_property (prop);
     }
@@ -430,7 +449,7 @@ count_utf_8_chars (const void *data, int nitems)
       if (! CHAR_HEAD_P_UTF8 (p))
 	return -1;
       n = CHAR_UNITS_BY_HEAD_UTF8 (*p);
-      if (p + n > pend)
+      if (n == 0 || n > pend - p)
 	return -1;
       for (i = 1; i < n; i++)
 	if (CHAR_HEAD_P_UTF8 (p + i))
@@ -607,8 +626,15 @@ free_mtext (void *object)
 
   if (mt->plist)
     mtext__free_plist (mt);
-  if (mt->data && mt->allocated >= 0)
+  if (MTEXT_BORROWED_P (mt))
+    {
+      if (mt->release)
+	(*mt->release) (mt->data, mt->release_arg);
+    }
+  else if (mt->data && mt->allocated >= 0)
     free (mt->data);
+  if (mt->pos_index)
+    free (mt->pos_index);
   M17N_OBJECT_UNREGISTER (mtext_table, mt);
   free (object);
 }
@@ -794,7 +820,7 @@ init_case_conversion ()
 
 #define LOOKUP								\
   do {									\
-    MPlist *pl = (MPlist *) mchartable_lookup (case_mapping, c);	\
+    MPlist *pl = mappings[opos - start];				\
 									\
     if (pl)								\
       {									\
@@ -816,6 +842,19 @@ init_case_conversion ()
   } while (0)
 
 
+/* Return an array of the values of case_mapping for the characters
+   of MT between POS and END.  */
+
+static MPlist **
+case_mappings (MText *mt, int pos, int end)
+{
+  MPlist **mappings;
+
+  MTABLE_MALLOC (mappings, end - pos + 1, MERROR_MTEXT);
+  mchartable_lookup_mtext (case_mapping, mt, pos, end, (void **) mappings);
+  return mappings;
+}
+
 int
 uppercase_precheck (MText *mt, int pos, int end)
 {
@@ -985,12 +1024,111 @@ mtext__fini (void)
 }
 
 
+/* Extend the position index of MT until its last entry reaches
+   character position POS or unit position POS_UNIT, or no more entry
+   fits in MT.  */
+
+static void
+extend_pos_index (MText *mt, int pos, int pos_unit)
+{
+  int char_pos, unit_pos;
+
+  if (mt->pos_index_size <= mt->nchars / POS_INDEX_INTERVAL)
+    {
+      mt->pos_index_size = mt->nchars / POS_INDEX_INTERVAL + 1;
+      MTABLE_REALLOC (mt->pos_index, mt->pos_index_size, MERROR_MTEXT);
+    }
+  if (mt->pos_index_used == 0)
+    mt->pos_index[mt->pos_index_used++] = 0;
+  char_pos = (mt->pos_index_used - 1) * POS_INDEX_INTERVAL;
+  unit_pos = mt->pos_index[mt->pos_index_used - 1];
+  while (char_pos < pos && unit_pos < pos_unit
+	 && char_pos + POS_INDEX_INTERVAL <= mt->nchars)
+    {
+      int limit = char_pos + POS_INDEX_INTERVAL;
+
+      while (char_pos < limit)
+	INC_POSITION (mt, char_pos, unit_pos);
+      mt->pos_index[mt->pos_index_used++] = unit_pos;
+    }
+}
+
+/* Find the nearest indexed position at or before character position
+   POS (if POS is not negative) or unit position POS_UNIT (otherwise)
+   of MT, and set *CHAR_POS and *UNIT_POS to it.  Return 0 if found.
+   Return -1 if MT is not worth indexing or the cache or the end of MT
+   is near enough to POS (or POS_UNIT).  */
+
+static int
+find_pos_index (MText *mt, int pos, int pos_unit,
+		int *char_pos, int *unit_pos)
+{
+  int last, idx;
+
+  if (mt->nchars < POS_INDEX_THRESHOLD
+      || mt->nchars == mt->nbytes)
+    return -1;
+  if (pos >= 0)
+    {
+      if (pos >= mt->cache_char_pos - POS_INDEX_INTERVAL
+	  && pos <= mt->cache_char_pos + POS_INDEX_INTERVAL)
+	return -1;
+      last = (mt->pos_index_used - 1) * POS_INDEX_INTERVAL;
+      if (pos > last)
+	{
+	  if (mt->nchars - pos < pos - last)
+	    return -1;
+	  extend_pos_index (mt, pos, mt->nbytes + 1);
+	}
+      idx = pos / POS_INDEX_INTERVAL;
+    }
+  else
+    {
+      int low, high;
+
+      if (pos_unit >= mt->cache_byte_pos - POS_INDEX_INTERVAL
+	  && pos_unit <= mt->cache_byte_pos + POS_INDEX_INTERVAL)
+	return -1;
+      last = mt->pos_index_used > 0 ? mt->pos_index[mt->pos_index_used - 1] : 0;
+      if (mt->pos_index_used == 0 || pos_unit > last)
+	{
+	  if (mt->nbytes - pos_unit < pos_unit - last)
+	    return -1;
+	  extend_pos_index (mt, mt->nchars + 1, pos_unit);
+	}
+      /* Find the last entry not exceeding POS_UNIT.  */
+      low = 0, high = mt->pos_index_used;
+      while (high - low > 1)
+	{
+	  int mid = (low + high) / 2;
+
+	  if (mt->pos_index[mid] <= pos_unit)
+	    low = mid;
+	  else
+	    high = mid;
+	}
+      idx = low;
+    }
+  *char_pos = idx * POS_INDEX_INTERVAL;
+  *unit_pos = mt->pos_index[idx];
+  return 0;
+}
+
+
 int
 mtext__char_to_byte (MText *mt, int pos)
 {
   int char_pos, byte_pos;
   int forward;
 
+  if (find_pos_index (mt, pos, 0, &char_pos, &byte_pos) == 0)
+    {
+      while (char_pos < pos)
+	INC_POSITION (mt, char_pos, byte_pos);
+      mt->cache_char_pos = char_pos;
+      mt->cache_byte_pos = byte_pos;
+      return byte_pos;
+    }
   if (pos < mt->cache_char_pos)
     {
       if (mt->cache_char_pos == mt->cache_byte_pos)
@@ -1043,6 +1181,14 @@ mtext__byte_to_char (MText *mt, int pos_byte)
   int char_pos, byte_pos;
   int forward;
 
+  if (find_pos_index (mt, -1, pos_byte, &char_pos, &byte_pos) == 0)
+    {
+      while (byte_pos < pos_byte)
+	INC_POSITION (mt, char_pos, byte_pos);
+      mt->cache_char_pos = char_pos;
+      mt->cache_byte_pos = byte_pos;
+      return char_pos;
+    }
   if (pos_byte < mt->cache_byte_pos)
     {
       if (mt->cache_char_pos == mt->cache_byte_pos)
@@ -1096,6 +1242,24 @@ void
 mtext__enlarge (MText *mt, int nbytes)
 {
   nbytes += MAX_UTF8_CHAR_BYTES;
+  if (MTEXT_BORROWED_P (mt))
+    {
+      /* Copy the borrowed data, and give it back to the owner.  */
+      int unit_bytes = UNIT_BYTES (mt->format);
+      int data_bytes = mt->nbytes * unit_bytes;
+      unsigned char *data = mt->data;
+
+      if (nbytes < data_bytes + unit_bytes)
+	nbytes = data_bytes + unit_bytes;
+      MTABLE_MALLOC (mt->data, nbytes, MERROR_MTEXT);
+      memcpy (mt->data, data, data_bytes);
+      memset (mt->data + data_bytes, 0, unit_bytes);
+      mt->allocated = nbytes;
+      if (mt->release)
+	(*mt->release) (data, mt->release_arg);
+      mt->release = NULL;
+      return;
+    }
   if (mt->allocated >= nbytes)
     return;
   if (nbytes < MALLOC_MININUM_BYTES)
@@ -1199,6 +1363,8 @@ mtext__adjust_format (MText *mt, enum MTextFormat format)
 {
   int i, c;
 
+  if (MTEXT_BORROWED_P (mt))
+    mtext__enlarge (mt, 0);
   if (mt->nchars > 0)
     switch (format)
       {
@@ -1270,6 +1436,7 @@ mtext__adjust_format (MText *mt, enum MTextFormat format)
       }
   mt->format = format;
   mt->coverage = FORMAT_COVERAGE (format);
+  mt->pos_index_used = 0;
 }
 
 
@@ -1395,13 +1562,15 @@ mtext__eol (MText *mt, int pos)
 int
 mtext__lowercase (MText *mt, int pos, int end)
 {
-  int opos = pos;
+  int start = pos, opos = pos;
   int c;
   MText *orig = NULL;
   MSymbol lang;
+  MPlist **mappings;
 
   if (lowercase_precheck (mt, pos, end))
     orig = mtext_dup (mt);
+  mappings = case_mappings (mt, pos, end);
 
   for (; pos < end; opos++)
     {
@@ -1450,6 +1619,7 @@ mtext__lowercase (MText *mt, int pos, int end)
 	LOOKUP;
     }
 
+  free (mappings);
   if (orig)
     m17n_object_unref (orig);
 
@@ -1459,15 +1629,16 @@ mtext__lowercase (MText *mt, int pos, int end)
 int
 mtext__titlecase (MText *mt, int pos, int end)
 {
-  int opos = pos;
+  int start = pos, opos = pos;
   int c;
   MText *orig = NULL;
   MSymbol lang;
-  MPlist *pl;
+  MPlist *pl, **mappings;
 
   /* Precheck for titlecase is identical to that for uppercase. */
   if (uppercase_precheck (mt, pos, end))
     orig = mtext_dup (mt);
+  mappings = case_mappings (mt, pos, end);
 
   for (; pos < end; opos++)
     {
@@ -1480,7 +1651,7 @@ mtext__titlecase (MText *mt, int pos, int end)
       else if (lang == Mlt && c == 0x0307 && after_soft_dotted (orig, opos))
 	DELETE;
 
-      else if ((pl = (MPlist *) mchartable_lookup (case_mapping, c)))
+      else if ((pl = mappings[opos - start]))
 	{
 	  /* Titlecase is the 2nd element. */
 	  MText *title
@@ -1502,6 +1673,7 @@ mtext__titlecase (MText *mt, int pos, int end)
 	pos++;
     }
 
+  free (mappings);
   if (orig)
     m17n_object_unref (orig);
 
@@ -1511,16 +1683,17 @@ mtext__titlecase (MText *mt, int pos, int end)
 int
 mtext__uppercase (MText *mt, int pos, int end)
 {
-  int opos = pos;
+  int start = pos, opos = pos;
   int c;
   MText *orig = NULL;
   MSymbol lang;
-  MPlist *pl;
+  MPlist *pl, **mappings;
 
   CASE_CONV_INIT (-1);
 
   if (uppercase_precheck (mt, 0, end))
     orig = mtext_dup (mt);
+  mappings = case_mappings (mt, pos, end);
 
   for (; pos < end; opos++)
     {
@@ -1535,7 +1708,7 @@ mtext__uppercase (MText *mt, int pos, int end)
 	       
       else
 	{
-	  if ((pl = (MPlist *) mchartable_lookup (case_mapping, c)) != NULL)
+	  if ((pl = mappings[opos - start]) != NULL)
 	    {
 	      MText *upper;
 	      int ulen;
@@ -1560,6 +1733,7 @@ mtext__uppercase (MText *mt, int pos, int end)
 	}
     }
 
+  free (mappings);
   if (orig)
     m17n_object_unref (orig);
 
@@ -1701,6 +1875,80 @@ mtext_from_data (const void *data, int nitems, enum MTextFormat format)
 
 /*=*/
 
+/***en
+    @brief Allocate a new M-text borrowing external data.
+
+    The mtext_from_external_data () function allocates a new M-text
+    whose character sequence is specified by array $DATA of $NITEMS
+    elements in the same way as mtext_from_data ().  $DATA must not
+    be @c NULL.
+
+    Unlike mtext_from_data (), the resulting M-text is modifiable.
+    The M-text refers to $DATA directly (e.g. a memory-mapped file)
+    until it is modified for the first time.  At that time, the
+    character sequence is copied into memory owned by the M-text.
+    $DATA itself is never modified.
+
+    When the M-text stops referring to $DATA, i.e. either when it is
+    modified for the first time or when it is freed, the function
+    $RELEASE (if not @c NULL) is called with $DATA and $ARG.  The
+    contents of $DATA must not be modified nor freed until then.
+
+    @return
+    If the operation was successful, mtext_from_external_data ()
+    returns a pointer to the allocated M-text.  Otherwise it returns
+    @c NULL and assigns an error code to the external variable
+    #merror_code.  */
+/***ja
+    @brief ΥǡѤ뿷 M-text Ƥ.
+
+    ؿ mtext_from_external_data () ϡmtext_from_data () 
+    Ʊͤˡǿ $NITEMS  $DATA 
+    ǻꤵ줿ʸĿ M-text Ƥ롣$DATA  
+    @c NULL ǤäƤϤʤʤ
+
+    mtext_from_data () ȰۤʤꡢƤ줿 M-text ѹǤ롣
+    M-text Ϻǽѹޤ $DATA (ȤХ˥ޥåפ줿ե)
+    ľܻȤλʸ M-text Ȥͭʣ̤롣
+    $DATA Τѹ뤳ȤϤʤ
+
+    M-text  $DATA 򻲾Ȥʤʤäʤǽѹ줿줿ˡ
+    ؿ $RELEASE  @c NULL Ǥʤ $DATA  $ARG ȤƸƤФ롣
+    ޤǤ $DATA ƤѹꤷƤϤʤʤ
+
+    @return
+    Сmtext_from_external_data () ϳƤ줿
+    M-text ؤΥݥ󥿤֤Ǥʤ @c NULL ֤ѿ
+    #merror_code ˥顼ɤꤹ롣  */
+
+/***
+    @errors
+    @c MERROR_MTEXT
+
+    @seealso
+    mtext_from_data ()  */
+
+MText *
+mtext_from_external_data (const void *data, int nitems,
+			  enum MTextFormat format,
+			  void (*release) (void *data, void *arg), void *arg)
+{
+  MText *mt;
+
+  if (! data || nitems < 0
+      || format < MTEXT_FORMAT_US_ASCII || format >= MTEXT_FORMAT_MAX)
+    MERROR (MERROR_MTEXT, NULL);
+  mt = mtext__from_data (data, nitems, format, 0);
+  if (! mt)
+    return NULL;
+  mt->allocated = 0;
+  mt->release = release;
+  mt->release_arg = arg;
+  return mt;
+}
+
+/*=*/
+
 /***en
     @brief Get information about the text data in M-text.
 
@@ -1925,8 +2173,12 @@ mtext_set_char (MText *mt, int pos, int c)
 
   if (delta)
     {
+      int i;
+
       if (mt->cache_char_pos > pos)
 	mt->cache_byte_pos += delta;
+      for (i = pos / POS_INDEX_INTERVAL + 1; i < mt->pos_index_used; i++)
+	mt->pos_index[i] += delta;
 
       if ((mt->nbytes + delta + 1) * unit_bytes > mt->allocated)
 	{
@@ -2417,6 +2669,7 @@ mtext_del (MText *mt, int from, int to)
     }
 
   mtext__adjust_plist_for_delete (mt, from, to - from);
+  POS_INDEX_TRUNCATE (mt, from);
   memmove (mt->data + from_byte * unit_bytes, 
 	   mt->data + to_byte * unit_bytes,
 	   (mt->nbytes - to_byte + 1) * unit_bytes);
@@ -2598,6 +2851,7 @@ mtext_ins_char (MText *mt, int pos, int c, int n)
       mt->cache_char_pos += n;
       mt->cache_byte_pos += nunits * n;
     }
+  POS_INDEX_TRUNCATE (mt, pos);
   memmove (mt->data + (pos_unit + nunits * n) * unit_bytes,
 	   mt->data + pos_unit * unit_bytes,
 	   (mt->nbytes - pos_unit + 1) * unit_bytes);
@@ -2735,6 +2989,7 @@ mtext_replace (MText *mt1, int from1, int to1,
     memmove (p + new_bytes, p + old_bytes,
 	     (mt1->nbytes + 1) * unit_bytes - (from1_byte + old_bytes));
   memcpy (p, mt2->data + from2_byte, new_bytes);
+  POS_INDEX_TRUNCATE (mt1, from1);
   mt1->nchars += len2 - len1;
   mt1->nbytes += (new_bytes - old_bytes) / unit_bytes;
   if (mt1->cache_char_pos >= to1)
@@ -93,25 +93,124 @@
 
 static int num_symbols;
 
+/* Initial number of buckets of the symbol table.  It must be a power
+   of 2.  */
 #define SYMBOL_TABLE_SIZE 1024
 
-static MSymbol symbol_table[SYMBOL_TABLE_SIZE];
+/* The symbol table is doubled when the number of symbols exceeds
+   SYMBOL_TABLE_LOAD times of the number of buckets.  */
+#define SYMBOL_TABLE_LOAD 1
+
+static MSymbol *symbol_table;
+
+static int symbol_table_size;
+
+/* Lock for symbol_table and num_symbols.  */
+M17N_MUTEX (symbol_lock)
+
+/* Return the FNV-1a hash value of STR of LEN bytes.  */
 
 static unsigned
 hash_string (const char *str, int len)
 {
-  unsigned hash = 0;
-  const char *end = str + len;
-  unsigned c;
+  unsigned hash = 2166136261U;
+  const unsigned char *p = (const unsigned char *) str;
+  const unsigned char *end = p + len;
 
-  while (str < end)
+  while (p < end)
     {
-      c = *((unsigned char *) str++);
-      if (c >= 0140)
-	c -= 40;
-      hash = ((hash << 3) + (hash >> 28) + c);
+      hash ^= *p++;
+      hash *= 16777619U;
     }
-  return hash & (SYMBOL_TABLE_SIZE - 1);
+  return hash;
+}
+
+/* Double the size of the symbol table.  */
+
+static void
+enlarge_symbol_table ()
+{
+  int size = symbol_table_size * 2;
+  MSymbol *table, sym, next;
+  int i;
+
+  MTABLE_CALLOC (table, size, MERROR_SYMBOL);
+  for (i = 0; i < symbol_table_size; i++)
+    for (sym = symbol_table[i]; sym; sym = next)
+      {
+	next = sym->next;
+	sym->next = table[sym->hash & (size - 1)];
+	table[sym->hash & (size - 1)] = sym;
+      }
+  free (symbol_table);
+  symbol_table = table;
+  symbol_table_size = size;
+}
+
+/* Return a symbol whose name is NAME of LEN bytes (not counting the
+   terminating NUL) and whose hash value is HASH, or NULL if there's
+   no such symbol.  */
+
+static MSymbol
+find_symbol (const char *name, int len, unsigned hash)
+{
+  MSymbol sym;
+
+  if (! symbol_table)
+    return NULL;
+  len++;
+  for (sym = symbol_table[hash & (symbol_table_size - 1)]; sym;
+       sym = sym->next)
+    if (hash == sym->hash
+	&& len == sym->length
+	&& ! memcmp (name, sym->name, len - 1))
+      return sym;
+  return NULL;
+}
+
+/* Make a new symbol whose name is NAME of LEN bytes and whose hash
+   value is HASH, and register it in the symbol table.  */
+
+static MSymbol
+make_symbol (const char *name, int len, unsigned hash)
+{
+  MSymbol sym;
+  int idx;
+
+  if (! symbol_table)
+    {
+      symbol_table_size = SYMBOL_TABLE_SIZE;
+      MTABLE_CALLOC (symbol_table, symbol_table_size, MERROR_SYMBOL);
+    }
+  else if (num_symbols >= symbol_table_size * SYMBOL_TABLE_LOAD)
+    enlarge_symbol_table ();
+  num_symbols++;
+  MTABLE_CALLOC (sym, 1, MERROR_SYMBOL);
+  MTABLE_MALLOC (sym->name, len + 1, MERROR_SYMBOL);
+  memcpy (sym->name, name, len);
+  sym->name[len] = '\0';
+  sym->length = len + 1;
+  sym->hash = hash;
+  idx = hash & (symbol_table_size - 1);
+  sym->next = symbol_table[idx];
+  symbol_table[idx] = sym;
+  return sym;
+}
+
+/* Return a symbol whose name is NAME of LEN bytes and whose hash
+   value is HASH.  If there's no such symbol, make it.  */
+
+static MSymbol
+intern_symbol (const char *name, int len, unsigned hash)
+{
+  MSymbol sym;
+
+  M17N_LOCK (symbol_lock);
+  sym = find_symbol (name, len, hash);
+  if (! sym)
+    sym = make_symbol (name, len, hash);
+  M17N_UNLOCK (symbol_lock);
+  return sym;
 }
 
 
@@ -150,7 +249,7 @@ msymbol__fini ()
   int i;
   MSymbol sym;
 
-  for (i = 0; i < SYMBOL_TABLE_SIZE; i++)
+  for (i = 0; i < symbol_table_size; i++)
     for (sym = symbol_table[i]; sym; sym = sym->next)
       if (! MPLIST_TAIL_P (&sym->plist))
 	{
@@ -168,7 +267,7 @@ msymbol__free_table ()
   MSymbol sym, next;
   int freed_symbols = 0;
 
-  for (i = 0; i < SYMBOL_TABLE_SIZE; i++)
+  for (i = 0; i < symbol_table_size; i++)
     {
       for (sym = symbol_table[i]; sym; sym = next)
 	{
@@ -177,8 +276,10 @@ msymbol__free_table ()
 	  free (sym);
 	  freed_symbols++;
 	}
-      symbol_table[i] = NULL;
     }
+  free (symbol_table);
+  symbol_table = NULL;
+  symbol_table_size = 0;
   if (mdebug__flags[MDEBUG_FINI])
     fprintf (mdebug__output, "%16s %7d %7d %7d\n", "Symbol",
 	     num_symbols, freed_symbols, num_symbols - freed_symbols);
@@ -189,11 +290,15 @@ msymbol__free_table ()
 MSymbol
 msymbol__with_len (const char *name, int len)
 {
-  char *p = alloca (len + 1);
+  const char *p = memchr (name, '\0', len);
+  unsigned hash;
 
-  memcpy (p, name, len);
-  p[len] = '\0';
-  return msymbol (p);
+  if (p)
+    len = p - name;
+  if (len == 3 && name[0] == 'n' && name[1] == 'i' && name[2] == 'l')
+    return Mnil;
+  hash = hash_string (name, len);
+  return intern_symbol (name, len, hash);
 }
 
 /** Return a plist of symbols that has non-NULL property PROP.  If
@@ -207,7 +312,7 @@ msymbol__list (MSymbol prop)
   int i;
   MSymbol sym;
 
-  for (i = 0; i < SYMBOL_TABLE_SIZE; i++)
+  for (i = 0; i < symbol_table_size; i++)
     for (sym = symbol_table[i]; sym; sym = sym->next)
       if (prop == Mnil || msymbol_get (sym, prop))
 	mplist_push (plist, sym, NULL);
@@ -397,7 +502,6 @@ MSymbol Msymbol;
 MSymbol
 msymbol (const char *name)
 {
-  MSymbol sym;
   int len;
   unsigned hash;
 
@@ -405,21 +509,7 @@ msymbol (const char *name)
   if (len == 3 && name[0] == 'n' && name[1] == 'i' && name[2] == 'l')
     return Mnil;
   hash = hash_string (name, len);
-  len++;
-  for (sym = symbol_table[hash]; sym; sym = sym->next)
-    if (len == sym->length
-	&& *name == *(sym->name)
-	&& ! memcmp (name, sym->name, len))
-      return sym;
-
-  num_symbols++;
-  MTABLE_CALLOC (sym, 1, MERROR_SYMBOL);
-  MTABLE_MALLOC (sym->name, len, MERROR_SYMBOL);
-  memcpy (sym->name, name, len);
-  sym->length = len;
-  sym->next = symbol_table[hash];
-  symbol_table[hash] = sym;
-  return sym;
+  return intern_symbol (name, len, hash);
 }
 
 /***en
@@ -466,21 +556,15 @@ msymbol_as_managing_key (const char *name)
   if (len == 3 && name[0] == 'n' && name[1] == 'i' && name[2] == 'l')
     MERROR (MERROR_SYMBOL, Mnil);
   hash = hash_string (name, len);
-  len++;
-  for (sym = symbol_table[hash]; sym; sym = sym->next)
-    if (len == sym->length
-	&& *name == *(sym->name)
-	&& ! memcmp (name, sym->name, len))
+  M17N_LOCK (symbol_lock);
+  if (find_symbol (name, len, hash))
+    {
+      M17N_UNLOCK (symbol_lock);
       MERROR (MERROR_SYMBOL, Mnil);
-
-  num_symbols++;
-  MTABLE_CALLOC (sym, 1, MERROR_SYMBOL);
+    }
+  sym = make_symbol (name, len, hash);
   sym->managing_key = 1;
-  MTABLE_MALLOC (sym->name, len, MERROR_SYMBOL);
-  memcpy (sym->name, name, len);
-  sym->length = len;
-  sym->next = symbol_table[hash];
-  symbol_table[hash] = sym;
+  M17N_UNLOCK (symbol_lock);
   return sym;
 }
 
@@ -542,13 +626,10 @@ msymbol_exist (const char *name)
   if (len == 3 && name[0] == 'n' && name[1] == 'i' && name[2] == 'l')
     return Mnil;
   hash = hash_string (name, len);
-  len++;
-  for (sym = symbol_table[hash]; sym; sym = sym->next)
-    if (len == sym->length
-	&& *name == *(sym->name)
-	&& ! memcmp (name, sym->name, len))
-      return sym;
-  return Mnil;
+  M17N_LOCK (symbol_lock);
+  sym = find_symbol (name, len, hash);
+  M17N_UNLOCK (symbol_lock);
+  return (sym ? sym : Mnil);
 }
 
 /*=*/
@@ -791,7 +872,8 @@ mdebug_dump_symbol (MSymbol symbol, int indent)
     The mdebug_dump_all_symbols () function prints names of all
     symbols to the stderr or to what specified by the environment
     variable MDEBUG_OUTPUT_FILE.  $INDENT specifies how many columns
-    to indent the lines but the first one.
+    to indent the lines but the first one.  The statistics of the
+    hash chains of the symbol table follow the names.
 
     @return
     This function returns #Mnil.
@@ -803,7 +885,8 @@ mdebug_dump_symbol (MSymbol symbol, int indent)
 
     ؿ mdebug_dump_all_symbols () ϡ٤ƤΥܥ̾ɸ२
     顼Ϥ⤷ϴĶѿ MDEBUG_DUMP_FONT ǻꤵ줿ե˰
-    롣 $INDENT ϣܰʹߤΥǥȤꤹ롣
+    롣 $INDENT ϣܰʹߤΥǥȤꤹ롣̾³ƥ
+    ơ֥Υϥåפ롣
 
     @return
     δؿ #Mnil ֤ 
@@ -816,7 +899,7 @@ MSymbol
 mdebug_dump_all_symbols (int indent)
 {
   char *prefix;
-  int i, n;
+  int i, n, used, longest;
   MSymbol sym;
 
   if (indent < 0)
@@ -826,15 +909,26 @@ mdebug_dump_all_symbols (int indent)
   prefix[indent] = 0;
 
   fprintf (mdebug__output, "(symbol-list");
-  for (i = n = 0; i < SYMBOL_TABLE_SIZE; i++)
+  for (i = n = used = longest = 0; i < symbol_table_size; i++)
     if ((sym = symbol_table[i]))
       {
+	int len = 0;
+
 	fprintf (mdebug__output, "\n%s  (%4d", prefix, i);
-	for (; sym; sym = sym->next, n++)
+	for (; sym; sym = sym->next, len++)
 	  fprintf (mdebug__output, " '%s'", sym->name);
 	fprintf (mdebug__output, ")");
+	n += len;
+	used++;
+	if (longest < len)
+	  longest = len;
       }
   fprintf (mdebug__output, "\n%s  (total %d)", prefix, n);
+  fprintf (mdebug__output, "\n%s  (buckets %d used %d longest-chain %d)",
+	   prefix, symbol_table_size, used, longest);
+  if (used > 0)
+    fprintf (mdebug__output, "\n%s  (average-chain %.2f)",
+	     prefix, (double) n / used);
   fprintf (mdebug__output, ")");
   return Mnil;
 }
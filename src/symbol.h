@@ -37,6 +37,9 @@ struct MSymbolStruct
   /* Byte length of <name>.  */
   int length;
 
+  /* Hash value of <name>.  */
+  unsigned hash;
+
   /* Plist of the symbol.  */
   MPlist plist;
 
@@ -78,7 +78,12 @@
 #include "mtext.h"
 #include "textprop.h"
 
-#define TEXT_PROP_DEBUG
+/* Define TEXT_PROP_DEBUG to check the consistency of a plist after
+   each modification.  The check walks through all the intervals and
+   computes the position of each, thus it turns insertion and deletion
+   of text, which otherwise take time proportional to the logarithm of
+   the number of intervals, into O(N log N) operations.  So it is not
+   defined by default.  */
 
 #undef xassert
 #ifdef TEXT_PROP_DEBUG
@@ -131,6 +136,8 @@ MTextPlist b     |-intvl1-|--intvl2--|--intvl3--|-intvl4-|--intvl5--|
 
 typedef struct MInterval MInterval;
 
+typedef struct MIntervalPool MIntervalPool;
+
 struct MInterval
 {
   /** Stack of pointers to text properties.  If the interval does not
@@ -144,15 +151,30 @@ struct MInterval
   /** Length of <stack>.  */
   int stack_length;
 
-  /** Start and end character positions of the interval.  If <end> is
-      negative, this interval is not in use.  */
-  int start, end;
+  /** Number of characters in the interval.  If negative, this
+      interval is not in use.  The start position of the interval is
+      not recorded but computed by interval_start () from the lengths
+      of the intervals preceding it in the search tree.  */
+  int length;
+
+  /** Sum of <length> of the intervals in the subtree of the search
+      tree rooted at this interval.  */
+  int total;
 
-  /** Pointers to the previous and next intervals.  If <start> is 0,
-      <prev> is NULL and this interval is pointed by MTextPlist->head.
-      If <end> is the size of the M-text, <next> is NULL, and this
-      interval is pointed by MTextPlist->tail.  */
+  /** Pointers to the previous and next intervals.  If the interval
+      starts at 0, <prev> is NULL and this interval is pointed by
+      MTextPlist->head.  If it ends at the end of the M-text, <next> is
+      NULL, and this interval is pointed by MTextPlist->tail.  */
   MInterval *prev, *next;
+
+  /** Parent and children in the search tree of the owning plist.  */
+  MInterval *parent, *left, *right;
+
+  /** Heap priority of the interval in the search tree.  */
+  unsigned priority;
+
+  /** Interval-pool containing the interval.  */
+  MIntervalPool *pool;
 };  
 
 /** MTextPlist is a structure to hold text properties of an M-text by
@@ -165,12 +187,13 @@ struct MTextPlist
   /** Key of the property.  */
   MSymbol key;
 
-  /** The head and tail intervals.  <head>->start is always 0.
-      <tail->end is always MText->nchars.  */
+  /** The head and tail intervals.  <head> always starts at 0, and
+      <tail> always ends at MText->nchars.  */
   MInterval *head, *tail;
 
-  /** Lastly accessed interval.  */
-  MInterval *cache;
+  /** Root of the search tree (treap ordered by position) of all the
+      intervals.  <root>->total is always MText->nchars.  */
+  MInterval *root;
 
   /* Not yet implemented.  */
   int (*modification_hook) (MText *mt, MSymbol key, int from, int to);
@@ -185,106 +208,266 @@ struct MTextPlist
 
 #define INTERVAL_POOL_SIZE 1024
 
-typedef struct MIntervalPool MIntervalPool;
-
 
 /** MIntervalPool is the structure for an interval-pool which store
     intervals.  Each interval-pool contains INTERVAL_POOL_SIZE number
-    of intervals, and is chained from the root #interval_pool.  */
+    of intervals, and is chained from the root #interval_pool_root.  */
 
 struct MIntervalPool
 {
   /** Array of intervals.  */
   MInterval intervals[INTERVAL_POOL_SIZE];
 
-  /** The smallest index to an unused interval.  */
-  int free_slot;
+  /** Chain of unused intervals linked by their <next>.  */
+  MInterval *free_list;
 
-  /** Pointer to the next interval-pool.  */
-  MIntervalPool *next;
+  /** How many intervals are in use.  */
+  int used;
+
+  /** Root of the chain containing this interval-pool.  A root points
+      to itself.  */
+  MIntervalPool *root;
+
+  /** Pointers to the next and previous interval-pools in the chain
+      from the root.  */
+  MIntervalPool *next, *prev;
+
+  /** Pointers to the next and previous interval-pools that have
+      unused intervals.  */
+  MIntervalPool *next_free, *prev_free;
+
+  /** The following members are used only in a root.  */
+
+  /** The first interval-pool that has unused intervals.  */
+  MIntervalPool *free_pools;
+
+#ifdef M17N_THREAD_SAFE
+  /** Lock for the members above of all the interval-pools chained
+      from this root, and for <length> and <next> of unused intervals.
+      They are updated by another thread when it frees an interval
+      allocated by the owner of the root.  */
+  pthread_mutex_t lock;
+
+  /** Nonzero if a thread owns the interval-pools chained from this
+      root.  */
+  int owned;
+
+  /** Pointer to the next root in #interval_pool_roots.  */
+  MIntervalPool *next_root;
+#endif
 };
 
 
-/** Root of interval-pools.  */
+/** Root of interval-pools of the current thread.  */
 
-static MIntervalPool interval_pool_root;
+static M17N_THREAD_LOCAL MIntervalPool *interval_pool_root;
+
+/** Seed of the priorities given to new intervals.  */
+
+static M17N_THREAD_LOCAL unsigned interval_priority_seed = 2463534242U;
+
+#ifdef M17N_THREAD_SAFE
+
+/** List of all roots of interval-pools.  A root is released when the
+    owner thread exits, and is taken over by another thread.  */
+
+static MIntervalPool *interval_pool_roots;
+
+M17N_MUTEX (interval_pool_lock)
+
+/** Key to release the root of the current thread at thread exit.  */
+
+static pthread_key_t interval_pool_key;
+
+static void
+release_interval_pool_root (void *root)
+{
+  M17N_LOCK (interval_pool_lock);
+  ((MIntervalPool *) root)->owned = 0;
+  M17N_UNLOCK (interval_pool_lock);
+}
+
+#endif /* M17N_THREAD_SAFE */
 
 /* For debugging. */
 
 static M17NObjectArray text_property_table;
 
-/** Return a newly allocated interval pool.  */
+/** Return a newly allocated interval pool, and put it in the chain
+    from ROOT.  If ROOT is NULL, the new interval pool is a root.  */
 
 static MIntervalPool *
-new_interval_pool ()
+new_interval_pool (MIntervalPool *root)
 {
   MIntervalPool *pool;
   int i;
 
   MSTRUCT_CALLOC (pool, MERROR_TEXTPROP);
-  for (i = 0; i < INTERVAL_POOL_SIZE; i++)
-    pool->intervals[i].end = -1;
-  pool->free_slot = 0;
-  pool->next = NULL;
+  for (i = INTERVAL_POOL_SIZE - 1; i >= 0; i--)
+    {
+      pool->intervals[i].length = -1;
+      pool->intervals[i].pool = pool;
+      pool->intervals[i].next = pool->free_list;
+      pool->free_list = pool->intervals + i;
+    }
+  if (root)
+    {
+      pool->root = root;
+      pool->prev = root;
+      pool->next = root->next;
+      if (pool->next)
+	pool->next->prev = pool;
+      root->next = pool;
+      pool->next_free = root->free_pools;
+      if (pool->next_free)
+	pool->next_free->prev_free = pool;
+      root->free_pools = pool;
+    }
+  else
+    {
+      pool->root = pool;
+      pool->free_pools = pool;
+#ifdef M17N_THREAD_SAFE
+      pthread_mutex_init (&pool->lock, NULL);
+#endif
+    }
   return pool;
 }
 
 
-/** Return a new interval for the region START and END.  */
+/** Free ROOT and the interval-pools chained from it.  */
+
+static void
+free_interval_pools (MIntervalPool *root)
+{
+  MIntervalPool *pool = root;
+
+#ifdef M17N_THREAD_SAFE
+  pthread_mutex_destroy (&root->lock);
+#endif
+  while (pool)
+    {
+      MIntervalPool *next = pool->next;
+
+      free (pool);
+      pool = next;
+    }
+}
+
+
+/** Set #interval_pool_root for the current thread.  */
+
+static void
+get_interval_pool_root ()
+{
+#ifdef M17N_THREAD_SAFE
+  MIntervalPool *root;
+
+  M17N_LOCK (interval_pool_lock);
+  for (root = interval_pool_roots; root && root->owned;
+       root = root->next_root);
+  if (! root)
+    {
+      root = new_interval_pool (NULL);
+      root->next_root = interval_pool_roots;
+      interval_pool_roots = root;
+    }
+  root->owned = 1;
+  M17N_UNLOCK (interval_pool_lock);
+  pthread_setspecific (interval_pool_key, root);
+  interval_pool_root = root;
+#else
+  interval_pool_root = new_interval_pool (NULL);
+#endif
+}
+
+
+/** Return a new interval of LENGTH characters.  It is not yet in any
+    chain nor search tree.  */
 
 static MInterval *
-new_interval (int start, int end)
+new_interval (int length)
 {
-  MIntervalPool *pool;
+  MIntervalPool *root, *pool;
   MInterval *interval;
 
-  for (pool = &interval_pool_root;
-       pool->free_slot >= INTERVAL_POOL_SIZE;
-       pool = pool->next)
+  if (! interval_pool_root)
+    get_interval_pool_root ();
+  root = interval_pool_root;
+  M17N_LOCK (root->lock);
+  pool = root->free_pools;
+  if (! pool)
+    pool = new_interval_pool (root);
+  interval = pool->free_list;
+  pool->free_list = interval->next;
+  pool->used++;
+  if (! pool->free_list)
     {
-      if (! pool->next)
-	pool->next = new_interval_pool ();
+      /* POOL is the first of the free pools.  */
+      root->free_pools = pool->next_free;
+      if (pool->next_free)
+	pool->next_free->prev_free = NULL;
+      pool->next_free = NULL;
     }
+  interval->length = interval->total = length;
+  M17N_UNLOCK (root->lock);
 
-  interval = &(pool->intervals[pool->free_slot]);
   interval->stack = NULL;
   interval->nprops = 0;
   interval->stack_length = 0;
   interval->prev = interval->next = NULL;
-  interval->start = start;
-  interval->end = end;
-
-  pool->free_slot++;
-  while (pool->free_slot < INTERVAL_POOL_SIZE
-	 && pool->intervals[pool->free_slot].end >= 0)
-    pool->free_slot++;
+  interval->parent = interval->left = interval->right = NULL;
+  interval_priority_seed ^= interval_priority_seed << 13;
+  interval_priority_seed ^= interval_priority_seed >> 17;
+  interval_priority_seed ^= interval_priority_seed << 5;
+  interval->priority = interval_priority_seed;
 
   return interval;
 }
 
 
 /** Free INTERVAL and return INTERVAL->next.  It assumes that INTERVAL
-    has no properties.  */
+    has no properties.  An interval-pool that gets empty is released
+    unless it is a root or the only one that has unused intervals.  */
 
 static MInterval *
 free_interval (MInterval *interval)
 {
-  MIntervalPool *pool = &interval_pool_root;
-  int i;
+  MIntervalPool *pool = interval->pool, *root = pool->root;
+  MInterval *next = interval->next;
 
   xassert (interval->nprops == 0);
   if (interval->stack)
     free (interval->stack);
-  while ((interval < pool->intervals
-	  || interval >= pool->intervals + INTERVAL_POOL_SIZE)
-	 && pool->next)
-    pool = pool->next;
 
-  i = interval - pool->intervals;
-  interval->end = -1;
-  if (i < pool->free_slot)
-    pool->free_slot = i;
-  return interval->next;
+  M17N_LOCK (root->lock);
+  interval->length = -1;
+  if (! pool->free_list)
+    {
+      pool->prev_free = NULL;
+      pool->next_free = root->free_pools;
+      if (pool->next_free)
+	pool->next_free->prev_free = pool;
+      root->free_pools = pool;
+    }
+  interval->next = pool->free_list;
+  pool->free_list = interval;
+  if (--pool->used == 0 && pool != root
+      && (pool->prev_free || pool->next_free))
+    {
+      if (pool->prev_free)
+	pool->prev_free->next_free = pool->next_free;
+      else
+	root->free_pools = pool->next_free;
+      if (pool->next_free)
+	pool->next_free->prev_free = pool->prev_free;
+      pool->prev->next = pool->next;
+      if (pool->next)
+	pool->next->prev = pool->prev;
+      free (pool);
+    }
+  M17N_UNLOCK (root->lock);
+  return next;
 }
 
 
@@ -308,7 +491,7 @@ free_interval (MInterval *interval)
 static MInterval *
 copy_interval (MInterval *interval, int mask_bits)
 {
-  MInterval *new = new_interval (interval->start, interval->end);
+  MInterval *new = new_interval (interval->length);
   int nprops = interval->nprops;
   MTextProperty **props = alloca (sizeof (MTextProperty *) * nprops);
   int i, n;
@@ -342,11 +525,10 @@ free_text_property (void *object)
 
 
 /** Return a newly allocated text property whose key is KEY and value
-    is VAL.  */
+    is VAL.  It is not yet attached to any interval.  */
 
 static MTextProperty *
-new_text_property (MText *mt, int from, int to, MSymbol key, void *val,
-		   int control_bits)
+new_text_property (MText *mt, MSymbol key, void *val, int control_bits)
 {
   MTextProperty *prop;
 
@@ -354,12 +536,11 @@ new_text_property (MText *mt, int from, int to, MSymbol key, void *val,
   prop->control.flag = control_bits;
   prop->attach_count = 0;
   prop->mt = mt;
-  prop->start = from;
-  prop->end = to;
+  prop->first = prop->last = NULL;
   prop->key = key;
   prop->val = val;
   if (key->managing_key)
-    M17N_OBJECT_REF (val);    
+    M17N_OBJECT_REF (val);
   M17N_OBJECT_REGISTER (text_property_table, prop);
   return prop;
 }
@@ -368,40 +549,213 @@ new_text_property (MText *mt, int from, int to, MSymbol key, void *val,
 /** Return a newly allocated copy of text property PROP.  */
 
 #define COPY_TEXT_PROPERTY(prop)				\
-  new_text_property ((prop)->mt, (prop)->start, (prop)->end,	\
-		     (prop)->key, (prop)->val, (prop)->control.flag)
+  new_text_property ((prop)->mt, (prop)->key, (prop)->val,	\
+		     (prop)->control.flag)
 
 
-/** Split text property PROP at position INTERVAL->start, and make all
+/** Split text property PROP at the start of INTERVAL, and make all
     the following intervals contain the copy of PROP instead of PROP.
     It assumes that PROP starts before INTERVAL.  */
 
 static void
 split_property (MTextProperty *prop, MInterval *interval)
 {
-  int end = prop->end;
+  MInterval *last = prop->last;
   MTextProperty *copy;
   int i;
 
-  prop->end = interval->start;
+  prop->last = interval->prev;
   copy = COPY_TEXT_PROPERTY (prop);
-  copy->start = interval->start;
-  copy->end = end;
+  copy->first = interval;
+  copy->last = last;
   /* Check all stacks of the following intervals, and if it contains
      PROP, change it to the copy of it.  */
-  for (; interval && interval->start < end; interval = interval->next)
-    for (i = 0; i < interval->nprops; i++)
-      if (interval->stack[i] == prop)
+  while (1)
+    {
+      for (i = 0; i < interval->nprops; i++)
+	if (interval->stack[i] == prop)
+	  {
+	    interval->stack[i] = copy;
+	    M17N_OBJECT_REF (copy);
+	    copy->attach_count++;
+	    prop->attach_count--;
+	    M17N_OBJECT_UNREF (prop);
+	  }
+      if (interval == last)
+	break;
+      interval = interval->next;
+    }
+  M17N_OBJECT_UNREF (copy);
+}
+
+
+/** Sum of the lengths of the intervals in the search tree rooted at
+    INTERVAL, which may be NULL.  */
+
+#define TREE_LENGTH(interval) ((interval) ? (interval)->total : 0)
+
+#define UPDATE_TOTAL(interval)					\
+  ((interval)->total = ((interval)->length			\
+			+ TREE_LENGTH ((interval)->left)	\
+			+ TREE_LENGTH ((interval)->right)))
+
+
+/** Return the start position of INTERVAL.  It is the sum of the
+    lengths of the intervals preceding INTERVAL in the search tree.  */
+
+static int
+interval_start (MInterval *interval)
+{
+  int pos = TREE_LENGTH (interval->left);
+
+  for (; interval->parent; interval = interval->parent)
+    if (interval->parent->right == interval)
+      pos += TREE_LENGTH (interval->parent->left) + interval->parent->length;
+  return pos;
+}
+
+
+/** Return the end position of INTERVAL.  */
+
+static int
+interval_end (MInterval *interval)
+{
+  return interval_start (interval) + interval->length;
+}
+
+
+/** Add DIFF to the length of INTERVAL, which is in a search tree.
+    The positions of all the following intervals move by DIFF.  */
+
+static void
+resize_interval (MInterval *interval, int diff)
+{
+  interval->length += diff;
+  for (; interval; interval = interval->parent)
+    interval->total += diff;
+}
+
+
+/** Rotate INTERVAL of PLIST's search tree up over its parent.  */
+
+static void
+rotate_interval (MTextPlist *plist, MInterval *interval)
+{
+  MInterval *parent = interval->parent, *grand = parent->parent;
+
+  if (parent->left == interval)
+    {
+      parent->left = interval->right;
+      if (interval->right)
+	interval->right->parent = parent;
+      interval->right = parent;
+    }
+  else
+    {
+      parent->right = interval->left;
+      if (interval->left)
+	interval->left->parent = parent;
+      interval->left = parent;
+    }
+  parent->parent = interval;
+  interval->parent = grand;
+  if (! grand)
+    plist->root = interval;
+  else if (grand->left == parent)
+    grand->left = interval;
+  else
+    grand->right = interval;
+  UPDATE_TOTAL (parent);
+  UPDATE_TOTAL (interval);
+}
+
+
+/** Build the search tree of PLIST from the chain of intervals.  */
+
+static void
+build_interval_tree (MTextPlist *plist)
+{
+  MInterval *interval, *last = NULL;
+
+  plist->root = NULL;
+  for (interval = plist->head; interval; interval = interval->next)
+    {
+      MInterval *above = last, *below = NULL;
+
+      /* Pop the right spine until a node of higher priority.  The
+	 subtrees of the popped nodes are complete.  */
+      while (above && above->priority < interval->priority)
 	{
-	  interval->stack[i] = copy;
-	  M17N_OBJECT_REF (copy);
-	  copy->attach_count++;
-	  prop->attach_count--;
-	  M17N_OBJECT_UNREF (prop);
+	  UPDATE_TOTAL (above);
+	  below = above, above = above->parent;
 	}
-  M17N_OBJECT_UNREF (copy);
+      interval->left = below;
+      if (below)
+	below->parent = interval;
+      interval->right = NULL;
+      interval->parent = above;
+      if (above)
+	above->right = interval;
+      else
+	plist->root = interval;
+      last = interval;
+    }
+  for (; last; last = last->parent)
+    UPDATE_TOTAL (last);
 }
 
+
+/** Register INTERVAL, which has just been chained to PLIST, in the
+    search tree of PLIST.  NEXT is the interval following INTERVAL
+    among those already registered (or NULL).  */
+
+static void
+link_interval (MTextPlist *plist, MInterval *interval, MInterval *next)
+{
+  MInterval *prev = interval->prev, *parent;
+
+  interval->left = interval->right = NULL;
+  interval->total = interval->length;
+  if (prev && ! prev->right)
+    prev->right = interval, interval->parent = prev;
+  else
+    {
+      xassert (next && ! next->left);
+      next->left = interval, interval->parent = next;
+    }
+  for (parent = interval->parent; parent; parent = parent->parent)
+    parent->total += interval->length;
+  while (interval->parent && interval->parent->priority < interval->priority)
+    rotate_interval (plist, interval);
+}
+
+
+/** Remove INTERVAL from the search tree of PLIST.  */
+
+static void
+unlink_interval (MTextPlist *plist, MInterval *interval)
+{
+  MInterval *child, *parent;
+
+  while (interval->left && interval->right)
+    rotate_interval (plist, (interval->left->priority
+			     > interval->right->priority
+			     ? interval->left : interval->right));
+  child = interval->left ? interval->left : interval->right;
+  parent = interval->parent;
+  if (child)
+    child->parent = parent;
+  if (! parent)
+    plist->root = child;
+  else if (parent->left == interval)
+    parent->left = child;
+  else
+    parent->right = child;
+  for (; parent; parent = parent->parent)
+    parent->total -= interval->length;
+}
+
+
 /** Divide INTERVAL of PLIST at POS if POS is in between the range of
     INTERVAL.  */
 
@@ -409,12 +763,14 @@ static void
 divide_interval (MTextPlist *plist, MInterval *interval, int pos)
 {
   MInterval *new;
+  int start = interval_start (interval);
   int i;
 
-  if (pos == interval->start || pos == interval->end)
+  if (pos == start || pos == start + interval->length)
     return;
   new = copy_interval (interval, 0);
-  interval->end = new->start = pos;
+  new->length = start + interval->length - pos;
+  resize_interval (interval, - new->length);
   new->prev = interval;
   new->next = interval->next;
   interval->next = new;
@@ -422,10 +778,13 @@ divide_interval (MTextPlist *plist, MInterval *interval, int pos)
     new->next->prev = new;
   if (plist->tail == interval)
     plist->tail = new;
+  link_interval (plist, new, new->next);
   for (i = 0; i < new->nprops; i++)
     {
       new->stack[i]->attach_count++;
       M17N_OBJECT_REF (new->stack[i]);
+      if (new->stack[i]->last == interval)
+	new->stack[i]->last = new;
     }
 }
 
@@ -452,7 +811,8 @@ maybe_merge_interval (MTextPlist *plist, MInterval *interval)
 
       if (prop != old
 	  && (prop->val != old->val
-	      || prop->end != old->start
+	      || prop->last != interval
+	      || old->first != next
 	      || prop->control.flag & MTEXTPROP_NO_MERGE
 	      || old->control.flag & MTEXTPROP_NO_MERGE))
 	return interval->next;
@@ -468,164 +828,91 @@ maybe_merge_interval (MTextPlist *plist, MInterval *interval)
 	{
 	  MInterval *tail;
 
-	  for (tail = next->next; tail && tail->start < old->end;
-	       tail = tail->next)
-	    for (j = 0; j < tail->nprops; j++)
-	      if (tail->stack[j] == old)
-		{
-		  old->attach_count--;
-		  xassert (old->attach_count);
-		  tail->stack[j] = prop;
-		  prop->attach_count++;
-		  M17N_OBJECT_REF (prop);
-		}
+	  for (tail = next; tail != old->last; )
+	    {
+	      tail = tail->next;
+	      for (j = 0; j < tail->nprops; j++)
+		if (tail->stack[j] == old)
+		  {
+		    old->attach_count--;
+		    xassert (old->attach_count);
+		    tail->stack[j] = prop;
+		    prop->attach_count++;
+		    M17N_OBJECT_REF (prop);
+		  }
+	    }
 	  xassert (old->attach_count == 1);
 	  old->mt = NULL;
-	  prop->end = old->end;
+	  prop->last = old->last;
 	}
       old->attach_count--;
       M17N_OBJECT_UNREF (old);
+      if (prop->last == next)
+	prop->last = interval;
     }
 
-  interval->end = next->end;
   interval->next = next->next;
   if (next->next)
     next->next->prev = interval;
   if (plist->tail == next)
     plist->tail = interval;
-  plist->cache = interval;
+  unlink_interval (plist, next);
+  resize_interval (interval, next->length);
   next->nprops = 0;
   free_interval (next);
   return interval;
 }
 
 
-/** Adjust start and end positions of intervals between HEAD and TAIL
-     (both inclusive) by diff.  Adjust also start and end positions
-     of text properties belonging to those intervals.  */
-
-static void
-adjust_intervals (MInterval *head, MInterval *tail, int diff)
-{
-  int i;
-  MTextProperty *prop;
-
-  if (diff < 0)
-    {
-      /* Adjust end positions of properties starting before HEAD.  */
-      for (i = 0; i < head->nprops; i++)
-	{
-	  prop = head->stack[i];
-	  if (prop->start < head->start)
-	    prop->end += diff;
-	}
-
-      /* Adjust start and end positions of properties starting at
-	 HEAD, and adjust HEAD itself.  */
-      while (1)
-	{
-	  for (i = 0; i < head->nprops; i++)
-	    {
-	      prop = head->stack[i];
-	      if (prop->start == head->start)
-		prop->start += diff, prop->end += diff;
-	    }
-	  head->start += diff;
-	  head->end += diff;
-	  if (head == tail)
-	    break;
-	  head = head->next;
-	}
-    }
-  else
-    {
-      /* Adjust start poistions of properties ending after TAIL.  */
-      for (i = 0; i < tail->nprops; i++)
-	{
-	  prop = tail->stack[i];
-	  if (prop->end > tail->end)
-	    prop->start += diff;
-	}
-
-      /* Adjust start and end positions of properties ending at
-	 TAIL, and adjust TAIL itself.  */
-      while (1)
-	{
-	  for (i = 0; i < tail->nprops; i++)
-	    {
-	      prop = tail->stack[i];
-	      if (prop->end == tail->end)
-		prop->start += diff, prop->end += diff;
-	    }
-	  tail->start += diff;
-	  tail->end += diff;
-	  if (tail == head)
-	    break;
-	  tail = tail->prev;
-	}
-    }
-}
-
-/* Return an interval of PLIST that covers the position POS.  */
+/* Return an interval of PLIST that covers the position POS, or NULL
+   if POS is at the end of the M-text.  */
 
 static MInterval *
 find_interval (MTextPlist *plist, int pos)
 {
-  MInterval *interval;
-  MInterval *highest;
+  MInterval *interval = plist->root;
+  int left;
 
-  if (pos < plist->head->end)
+  if (pos < plist->head->length)
     return plist->head;
-  if (pos >= plist->tail->start)
-    return (pos < plist->tail->end ? plist->tail : NULL);
+  if (pos >= interval->total - plist->tail->length)
+    return (pos < interval->total ? plist->tail : NULL);
 
-  interval = plist->cache;
-
-  if (pos < interval->start)
-    highest = interval->prev, interval = plist->head->next;
-  else if (pos < interval->end)
-    return interval;
-  else
-    highest = plist->tail->prev, interval = interval->next;
-
-  if (pos - interval->start < highest->end - pos)
-    {
-      while (interval->end <= pos)
-	/* Here, we are sure that POS is not included in PLIST->tail,
-	   thus, INTERVAL->next always points a valid next
-	   interval.  */
-	interval = interval->next;
-    }
-  else
+  while (1)
     {
-      while (highest->start > pos)
-	highest = highest->prev;
-      interval = highest;
+      left = TREE_LENGTH (interval->left);
+      if (pos < left)
+	interval = interval->left;
+      else if ((pos -= left) < interval->length)
+	return interval;
+      else
+	pos -= interval->length, interval = interval->right;
     }
-  plist->cache = interval;
-  return interval;
 }
 
-/* Push text property PROP on the stack of INTERVAL.  */
-
-#define PUSH_PROP(interval, prop)		\
-  do {						\
-    int n = (interval)->nprops;			\
-						\
-    PREPARE_INTERVAL_STACK ((interval), n + 1);	\
-    (interval)->stack[n] = (prop);		\
-    (interval)->nprops += 1;			\
-    (prop)->attach_count++;			\
-    M17N_OBJECT_REF (prop);			\
-    if ((prop)->start > (interval)->start)	\
-      (prop)->start = (interval)->start;	\
-    if ((prop)->end < (interval)->end)		\
-      (prop)->end = (interval)->end;		\
+/* Push text property PROP on the stack of INTERVAL.  INTERVAL must be
+   adjacent to the intervals PROP is already attached to, if any.  */
+
+#define PUSH_PROP(interval, prop)			\
+  do {							\
+    int n = (interval)->nprops;				\
+							\
+    PREPARE_INTERVAL_STACK ((interval), n + 1);		\
+    (interval)->stack[n] = (prop);			\
+    (interval)->nprops += 1;				\
+    if (! (prop)->attach_count)				\
+      (prop)->first = (prop)->last = (interval);	\
+    else if ((prop)->first == (interval)->next)		\
+      (prop)->first = (interval);			\
+    else if ((prop)->last == (interval)->prev)		\
+      (prop)->last = (interval);			\
+    (prop)->attach_count++;				\
+    M17N_OBJECT_REF (prop);				\
   } while (0)
 
 
 /* Pop the topmost text property of INTERVAL from the stack.  If it
-   ends after INTERVAL->end, split it.  */
+   ends after INTERVAL, split it.  */
 
 #define POP_PROP(interval)				\
   do {							\
@@ -635,14 +922,14 @@ find_interval (MTextPlist *plist, int pos)
     prop = (interval)->stack[(interval)->nprops];	\
     xassert (prop->control.ref_count > 0);		\
     xassert (prop->attach_count > 0);			\
-    if (prop->start < (interval)->start)		\
+    if (prop->first != (interval))			\
       {							\
-	if (prop->end > (interval)->end)		\
+	if (prop->last != (interval))			\
 	  split_property (prop, (interval)->next);	\
-	prop->end = (interval)->start;			\
+	prop->last = (interval)->prev;			\
       }							\
-    else if (prop->end > (interval)->end)		\
-      prop->start = (interval)->end;			\
+    else if (prop->last != (interval))			\
+      prop->first = (interval)->next;			\
     prop->attach_count--;				\
     if (! prop->attach_count)				\
       prop->mt = NULL;					\
@@ -670,16 +957,45 @@ find_interval (MTextPlist *plist, int pos)
 
 
 #ifdef TEXT_PROP_DEBUG
+/* Check the subtree rooted at INTERVAL of a search tree.  *NEXT is
+   the interval expected to come first in order, and is updated to the
+   one following the subtree.  */
+
 static int
-check_plist (MTextPlist *plist, int start)
+check_interval_tree (MInterval *interval, MInterval *parent, MInterval **next)
+{
+  if (! interval)
+    return 0;
+  if (interval->parent != parent
+      || (parent && parent->priority < interval->priority)
+      || interval->total != (interval->length
+			     + TREE_LENGTH (interval->left)
+			     + TREE_LENGTH (interval->right))
+      || check_interval_tree (interval->left, interval, next)
+      || interval != *next)
+    return mdebug_hook ();
+  *next = interval->next;
+  return check_interval_tree (interval->right, interval, next);
+}
+
+/* Return 1 if INTERVAL has PROP in its stack, else return 0.  */
+
+static int
+interval_has_prop (MInterval *interval, MTextProperty *prop)
+{
+  int i;
+
+  for (i = 0; i < interval->nprops; i++)
+    if (interval->stack[i] == prop)
+      return 1;
+  return 0;
+}
+
+static int
+check_plist (MTextPlist *plist)
 {
   MInterval *interval = plist->head;
-  MInterval *cache = plist->cache;
-  int cache_found = 0;
 
-  if (interval->start != start
-      || interval->start >= interval->end)
-    return mdebug_hook ();
   while (interval)
     {
       int i;
@@ -687,95 +1003,64 @@ check_plist (MTextPlist *plist, int start)
       if (interval == interval->next)
 	return mdebug_hook ();
 
-      if (interval == cache)
-	cache_found = 1;
-
-      if (interval->start >= interval->end)
+      if (interval->length <= 0)
 	return mdebug_hook ();
       if ((interval->next
-	   ? (interval->end != interval->next->start
-	      || interval != interval->next->prev)
+	   ? interval != interval->next->prev
 	   : interval != plist->tail))
 	return mdebug_hook ();
       for (i = 0; i < interval->nprops; i++)
 	{
-	  if (interval->stack[i]->start > interval->start
-	      || interval->stack[i]->end < interval->end)
-	    return mdebug_hook ();
+	  MTextProperty *prop = interval->stack[i];
 
-	  if (! interval->stack[i]->attach_count)
+	  if (! prop->attach_count)
 	    return mdebug_hook ();
-	  if (! interval->stack[i]->mt)
+	  if (! prop->mt)
 	    return mdebug_hook ();
-	  if (interval->stack[i]->start == interval->start)
+	  if (interval_start (prop->first) > interval_start (interval)
+	      || interval_end (prop->last) < interval_end (interval))
+	    return mdebug_hook ();
+	  if (prop->first == interval)
 	    {
-	      MTextProperty *prop = interval->stack[i];
+	      /* PROP must be in all the intervals from PROP->first to
+		 PROP->last, and only in them.  */
 	      int count = prop->attach_count - 1;
 	      MInterval *interval2;
 
-	      for (interval2 = interval->next;
-		   interval2 && interval2->start < prop->end;
+	      for (interval2 = interval; interval2 != prop->last;
 		   count--, interval2 = interval2->next)
-		if (count == 0)
+		if (count == 0 || ! interval2->next
+		    || ! interval_has_prop (interval2->next, prop))
 		  return mdebug_hook ();
-	    }	      
-
-	  if (interval->stack[i]->end > interval->end)
-	    {
-	      MTextProperty *prop = interval->stack[i];
-	      MInterval *interval2;
-	      int j;
-
-	      for (interval2 = interval->next;
-		   interval2 && interval2->start < prop->end;
-		   interval2 = interval2->next)
-		{
-		  for (j = 0; j < interval2->nprops; j++)
-		    if (interval2->stack[j] == prop)
-		      break;
-		  if (j == interval2->nprops)
-		    return mdebug_hook ();
-		}
-	    }
-	  if (interval->stack[i]->start < interval->start)
-	    {
-	      MTextProperty *prop = interval->stack[i];
-	      MInterval *interval2;
-	      int j;
-
-	      for (interval2 = interval->prev;
-		   interval2 && interval2->end > prop->start;
-		   interval2 = interval2->prev)
-		{
-		  for (j = 0; j < interval2->nprops; j++)
-		    if (interval2->stack[j] == prop)
-		      break;
-		  if (j == interval2->nprops)
-		    return mdebug_hook ();
-		}
+	      if (count != 0)
+		return mdebug_hook ();
 	    }
+	  else if (! interval->prev
+		   || ! interval_has_prop (interval->prev, prop))
+	    return mdebug_hook ();
 	}
       interval = interval->next;
     }
-  if (! cache_found)
-    return mdebug_hook ();
   if (plist->head->prev || plist->tail->next)
-    return mdebug_hook ();    
+    return mdebug_hook ();
+  interval = plist->head;
+  if (check_interval_tree (plist->root, NULL, &interval) || interval)
+    return mdebug_hook ();
   return 0;
 }
 #endif
 
 
 /** Return a copy of plist that contains intervals between FROM and TO
-    of PLIST.  The copy goes to the position POS of M-text MT.  */
+    of PLIST for M-text MT.  Positions in the copy start from 0.  */
 
 static MTextPlist *
-copy_single_property (MTextPlist *plist, int from, int to, MText *mt, int pos)
+copy_single_property (MTextPlist *plist, int from, int to, MText *mt)
 {
   MTextPlist *new;
-  MInterval *interval1, *interval2;
-  MTextProperty *prop;
-  int diff = pos - from;
+  MInterval *interval1, *interval2, *orig;
+  MTextProperty *prop, *copy;
+  int end;
   int i, j;
   int mask_bits = MTEXTPROP_VOLATILE_STRONG | MTEXTPROP_VOLATILE_WEAK;
 
@@ -783,46 +1068,48 @@ copy_single_property (MTextPlist *plist, int from, int to, MText *mt, int pos)
   new->key = plist->key;
   new->next = NULL;
 
-  interval1 = find_interval (plist, from);
+  orig = interval1 = find_interval (plist, from);
+  end = interval_end (interval1);
   new->head = copy_interval (interval1, mask_bits);
+  new->head->length = end - from;
   for (interval1 = interval1->next, interval2 = new->head;
-       interval1 && interval1->start < to;
-       interval1 = interval1->next, interval2 = interval2->next)
+       interval1 && end < to;
+       end += interval1->length,
+	 interval1 = interval1->next, interval2 = interval2->next)
     {
       interval2->next = copy_interval (interval1, mask_bits);
       interval2->next->prev = interval2;
     }
   new->tail = interval2;
-  new->head->start = from;
-  new->tail->end = to;
-  for (interval1 = new->head; interval1; interval1 = interval1->next)
+  new->tail->length -= end - to;
+  /* ORIG walks through the intervals of PLIST from which those of
+     NEW are copied.  */
+  for (interval1 = new->head; interval1;
+       interval1 = interval1->next, orig = orig->next)
     for (i = 0; i < interval1->nprops; i++)
-      if (interval1->start == interval1->stack[i]->start
+      if (interval1->stack[i]->first == orig
 	  || interval1 == new->head)
 	{
 	  prop = interval1->stack[i];
-	  interval1->stack[i] = COPY_TEXT_PROPERTY (prop);
-	  interval1->stack[i]->mt = mt;
-	  interval1->stack[i]->attach_count++;
-	  if (interval1->stack[i]->start < from)
-	    interval1->stack[i]->start = from;
-	  if (interval1->stack[i]->end > to)
-	    interval1->stack[i]->end = to;
+	  copy = interval1->stack[i] = COPY_TEXT_PROPERTY (prop);
+	  copy->mt = mt;
+	  copy->attach_count++;
+	  copy->first = copy->last = interval1;
 	  for (interval2 = interval1->next; interval2;
 	       interval2 = interval2->next)
 	    for (j = 0; j < interval2->nprops; j++)
 	      if (interval2->stack[j] == prop)
 		{
-		  interval2->stack[j] = interval1->stack[i];
-		  interval1->stack[i]->attach_count++;
-		  M17N_OBJECT_REF (interval1->stack[i]);
+		  interval2->stack[j] = copy;
+		  copy->attach_count++;
+		  copy->last = interval2;
+		  M17N_OBJECT_REF (copy);
 		}
 	}
-  adjust_intervals (new->head, new->tail, diff);
-  new->cache = new->head;
+  build_interval_tree (new);
   for (interval1 = new->head; interval1 && interval1->next;
        interval1 = maybe_merge_interval (new, interval1));
-  xassert (check_plist (new, pos) == 0);
+  xassert (check_plist (new) == 0);
   if (new->head == new->tail
       && new->head->nprops == 0)
     {
@@ -843,9 +1130,9 @@ new_plist (MText *mt, MSymbol key)
 
   MSTRUCT_MALLOC (plist, MERROR_TEXTPROP);
   plist->key = key;
-  plist->head = new_interval (0, mtext_nchars (mt));
+  plist->head = new_interval (mtext_nchars (mt));
   plist->tail = plist->head;
-  plist->cache = plist->head;
+  plist->root = plist->head;
   plist->next = mt->plist;
   mt->plist = plist;
   return plist;
@@ -888,37 +1175,30 @@ get_plist_create (MText *mt, MSymbol key, int create)
   return plist;
 }
 
-/* Detach PROP.  INTERVAL (if not NULL) contains PROP.  */
+/* Detach PROP from PLIST.  */
 
 static void
-detach_property (MTextPlist *plist, MTextProperty *prop, MInterval *interval)
+detach_property (MTextPlist *plist, MTextProperty *prop)
 {
-  MInterval *head;
-  int to = prop->end;
+  MInterval *head = prop->first, *tail = prop->last, *interval;
+  int to = interval_end (tail);
 
   xassert (prop->mt);
   xassert (plist);
 
   M17N_OBJECT_REF (prop);
-  if (interval)
-    while (interval->start > prop->start)
-      interval = interval->prev;
-  else
-    interval = find_interval (plist, prop->start);
-  head = interval;
-  while (1)
+  for (interval = head; ; interval = interval->next)
     {
       REMOVE_PROP (interval, prop);
-      if (interval->end == to)
+      if (interval == tail)
 	break;
-      interval = interval->next;
     }
   xassert (prop->attach_count == 0 && prop->mt == NULL);
   M17N_OBJECT_UNREF (prop);
 
-  while (head && head->end <= to)
+  while (head && interval_end (head) <= to)
     head = maybe_merge_interval (plist, head);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
 }
 
 /* Delete text properties of PLIST between FROM and TO.  MASK_BITS
@@ -941,25 +1221,26 @@ delete_properties (MTextPlist *plist, int from, int to,
 
  retry:
   for (interval = find_interval (plist, from);
-       interval && interval->start < to;
+       interval && interval_start (interval) < to;
        interval = interval->next)
     for (i = 0; i < interval->nprops; i++)
       {
 	MTextProperty *prop = interval->stack[i];
+	int start = MTEXTPROP_START (prop), end = MTEXTPROP_END (prop);
 
 	if (prop->control.flag & mask_bits)
 	  {
-	    if (prop->start < modified_from)
-	      modified_from = prop->start;
-	    if (prop->end > modified_to)
-	      modified_to = prop->end;
-	    detach_property (plist, prop, interval);
+	    if (start < modified_from)
+	      modified_from = start;
+	    if (end > modified_to)
+	      modified_to = end;
+	    detach_property (plist, prop);
 	    modified++;
 	    goto retry;
 	  }
-	else if (deleting && prop->start >= from && prop->end <= to)
+	else if (deleting && start >= from && end <= to)
 	  {
-	    detach_property (plist, prop, interval);
+	    detach_property (plist, prop);
 	    modified++;
 	    goto retry;
 	  }
@@ -968,7 +1249,7 @@ delete_properties (MTextPlist *plist, int from, int to,
   if (modified)
     {
       interval = find_interval (plist, modified_from);
-      while (interval && interval->start < modified_to)
+      while (interval && interval_start (interval) < modified_to)
 	interval = maybe_merge_interval (plist, interval);
     }
 
@@ -987,34 +1268,35 @@ MInterval *
 pop_all_properties (MTextPlist *plist, int from, int to)
 {
   MInterval *interval;
+  int end;
 
   /* Be sure to have interval boundary at TO.  */
   interval = find_interval (plist, to);
-  if (interval && interval->start < to)
+  if (interval)
     divide_interval (plist, interval, to);
 
   /* Be sure to have interval boundary at FROM.  */
   interval = find_interval (plist, from);
-  if (interval->start < from)
+  if (interval_start (interval) < from)
     {
       divide_interval (plist, interval, from);
       interval = interval->next;
     }
 
   pop_interval_properties (interval);
-  while (interval->end < to)
+  for (end = from + interval->length; end < to; )
     {
       MInterval *next = interval->next;
 
       pop_interval_properties (next);
-      interval->end = next->end;
+      end += next->length;
       interval->next = next->next;
       if (interval->next)
 	interval->next->prev = interval;
       if (next == plist->tail)
 	plist->tail = interval;
-      if (plist->cache == next)
-	plist->cache = interval;
+      unlink_interval (plist, next);
+      resize_interval (interval, next->length);
       free_interval (next);
     }
   return interval;
@@ -1057,15 +1339,17 @@ extract_text_properties (MText *mt, int from, int to, MSymbol key,
   MPlist *top;
   MTextPlist *list = get_plist_create (mt, key, 0);
   MInterval *interval;
+  int start;
 
   if (! list)
     return;
   interval = find_interval (list, from);
+  start = interval_start (interval);
   if (interval->nprops == 0
-      && interval->start <= from && interval->end >= to)
+      && start <= from && start + interval->length >= to)
     return;
   top = plist;
-  while (interval && interval->start < to)
+  while (interval && start < to)
     {
       if (interval->nprops == 0)
 	top = mplist_find_by_key (top, Mnil);
@@ -1095,6 +1379,7 @@ extract_text_properties (MText *mt, int from, int to, MSymbol key,
 		}
 	    }
 	}
+      start += interval->length;
       interval = interval->next;
     }
   return;
@@ -1128,13 +1413,15 @@ dump_interval (MInterval *interval, int indent)
   prefix[indent] = 0;
 
   fprintf (mdebug__output, "(interval %d-%d (%d)",
-	   interval->start, interval->end, interval->nprops);
+	   interval_start (interval), interval_end (interval),
+	   interval->nprops);
   for (i = 0; i < interval->nprops; i++)
     fprintf (mdebug__output, "\n%s (%d %d/%d %d-%d 0x%x)",
 	     prefix, i,
 	     interval->stack[i]->control.ref_count,
 	     interval->stack[i]->attach_count,
-	     interval->stack[i]->start, interval->stack[i]->end,
+	     MTEXTPROP_START (interval->stack[i]),
+	     MTEXTPROP_END (interval->stack[i]),
 	     (unsigned) interval->stack[i]->val);
   fprintf (mdebug__output, ")");
 }
@@ -1156,12 +1443,13 @@ dump_textplist (MTextPlist *plist, int indent)
       while (plist)
 	{
 	  MInterval *interval = plist->head;
+	  int start = 0;
 
 	  fprintf (mdebug__output, "%s (%s", prefix, msymbol_name (plist->key));
 	  while (interval)
 	    {
 	      fprintf (mdebug__output, " (%d %d",
-		       interval->start, interval->end);
+		       start, start + interval->length);
 	      if (interval->nprops > 0)
 		{
 		  int i;
@@ -1171,10 +1459,11 @@ dump_textplist (MTextPlist *plist, int indent)
 			     (int) interval->stack[i]->val);
 		}
 	      fprintf (mdebug__output, ")");
+	      start += interval->length;
 	      interval = interval->next;
 	    }
 	  fprintf (mdebug__output, ")\n");
-	  xassert (check_plist (plist, 0) == 0);
+	  xassert (check_plist (plist) == 0);
 	  plist = plist->next;
 	}
     }
@@ -1187,6 +1476,9 @@ int
 mtext__prop_init ()
 {
   M17N_OBJECT_ADD_ARRAY (text_property_table, "Text property");
+#ifdef M17N_THREAD_SAFE
+  pthread_key_create (&interval_pool_key, release_interval_pool_root);
+#endif
   Mtext_prop_serializer = msymbol ("text-prop-serializer");
   Mtext_prop_deserializer = msymbol ("text-prop-deserializer");
   return 0;
@@ -1195,15 +1487,19 @@ mtext__prop_init ()
 void
 mtext__prop_fini ()
 {
-  MIntervalPool *pool = interval_pool_root.next;
-
-  while (pool)
+#ifdef M17N_THREAD_SAFE
+  pthread_key_delete (interval_pool_key);
+  while (interval_pool_roots)
     {
-      MIntervalPool *next = pool->next;
-      free (pool);
-      pool = next;
+      MIntervalPool *root = interval_pool_roots;
+
+      interval_pool_roots = root->next_root;
+      free_interval_pools (root);
     }
-  interval_pool_root.next = NULL;  
+#else
+  free_interval_pools (interval_pool_root);
+#endif
+  interval_pool_root = NULL;
 }
 
 
@@ -1225,18 +1521,18 @@ mtext__free_plist (MText *mt){
     M-text MT.  */
 
 MTextPlist *
-mtext__copy_plist (MTextPlist *plist, int from, int to, MText *mt, int pos)
+mtext__copy_plist (MTextPlist *plist, int from, int to, MText *mt)
 {
   MTextPlist *copy, *this;
 
   if (from == to)
     return NULL;
   for (copy = NULL; plist && ! copy; plist = plist->next)
-    copy = copy_single_property (plist, from, to, mt, pos);
+    copy = copy_single_property (plist, from, to, mt);
   if (! plist)
     return copy;
   for (; plist; plist = plist->next)
-    if ((this = copy_single_property (plist, from, to, mt, pos)))
+    if ((this = copy_single_property (plist, from, to, mt)))
       {
 	this->next = copy;
 	copy = this;
@@ -1245,6 +1541,11 @@ mtext__copy_plist (MTextPlist *plist, int from, int to, MText *mt, int pos)
   return copy;
 }
 
+/* As the position of an interval is computed from the lengths of the
+   preceding intervals, the functions below have only to resize,
+   insert, or remove intervals around the modified region.  The
+   intervals and the text properties after it move with them.  */
+
 void
 mtext__adjust_plist_for_delete (MText *mt, int pos, int len)
 {
@@ -1257,7 +1558,7 @@ mtext__adjust_plist_for_delete (MText *mt, int pos, int len)
     {
       mtext__free_plist (mt);
       return;
-    }      
+    }
 
   to = pos + len;
   prepare_to_modify (mt, pos, to, Mnil, 1);
@@ -1266,22 +1567,19 @@ mtext__adjust_plist_for_delete (MText *mt, int pos, int len)
       MInterval *interval = pop_all_properties (plist, pos, to);
       MInterval *prev = interval->prev, *next = interval->next;
 
+      unlink_interval (plist, interval);
       if (prev)
 	prev->next = next;
       else
 	plist->head = next;
       if (next)
-	{
-	  adjust_intervals (next, plist->tail, -len);
-	  next->prev = prev;
-	}
+	next->prev = prev;
       else
 	plist->tail = prev;
       if (prev && next)
-	next = maybe_merge_interval (plist, prev);
-      plist->cache = next ? next : prev;
+	maybe_merge_interval (plist, prev);
       free_interval (interval);
-      xassert (check_plist (plist, 0) == 0);
+      xassert (check_plist (plist) == 0);
     }
 }
 
@@ -1313,23 +1611,23 @@ mtext__adjust_plist_for_insert (MText *mt, int pos, int nchars,
       else
 	{
 	  next = find_interval (pl, pos);
-	  if (next->start < pos)
+	  if (interval_start (next) < pos)
 	    {
 	      divide_interval (pl, next, pos);
 	      next = next->next;
 	    }
 	  for (i = 0; i < next->nprops; i++)
-	    if (next->stack[i]->start < pos)
+	    if (next->stack[i]->first != next)
 	      split_property (next->stack[i], next);
 	  prev = next->prev;
 	}
 
-      xassert (check_plist (pl, 0) == 0);
+      xassert (check_plist (pl) == 0);
       for (p = NULL, pl2 = plist; pl2 && pl->key != pl2->key;
 	   p = pl2, pl2 = p->next);
       if (pl2)
 	{
-	  xassert (check_plist (pl2, pl2->head->start) == 0);
+	  xassert (check_plist (pl2) == 0);
 	  if (p)
 	    p->next = pl2->next;
 	  else
@@ -1341,7 +1639,7 @@ mtext__adjust_plist_for_insert (MText *mt, int pos, int nchars,
 	}
       else
 	{
-	  head = tail = new_interval (pos, pos + nchars);
+	  head = tail = new_interval (nchars);
 	}
       head->prev = prev;
       tail->next = next;
@@ -1353,10 +1651,10 @@ mtext__adjust_plist_for_insert (MText *mt, int pos, int nchars,
 	next->prev = tail;
       else
 	pl->tail = tail;
-      if (next)
-	adjust_intervals (next, pl->tail, nchars);
+      for (interval = head; interval != next; interval = interval->next)
+	link_interval (pl, interval, next);
 
-      xassert (check_plist (pl, 0) == 0);
+      xassert (check_plist (pl) == 0);
       if (prev && prev->nprops > 0)
 	{
 	  for (interval = prev;
@@ -1370,7 +1668,7 @@ mtext__adjust_plist_for_insert (MText *mt, int pos, int nchars,
 		  PUSH_PROP (interval->next, prop);
 	      }
 	}
-      xassert (check_plist (pl, 0) == 0);
+      xassert (check_plist (pl) == 0);
       if (next && next->nprops > 0)
 	{
 	  for (interval = next;
@@ -1386,10 +1684,9 @@ mtext__adjust_plist_for_insert (MText *mt, int pos, int nchars,
 	}
 
       interval = prev ? prev : pl->head;
-      pl->cache = interval;
-      while (interval && interval->start <= pos + nchars)
+      while (interval && interval_start (interval) <= pos + nchars)
 	interval = maybe_merge_interval (pl, interval);
-      xassert (check_plist (pl, 0) == 0);
+      xassert (check_plist (pl) == 0);
     }
 
   if (pl_last)
@@ -1399,33 +1696,33 @@ mtext__adjust_plist_for_insert (MText *mt, int pos, int nchars,
 
   for (; plist; plist = plist->next)
     {
-      plist->cache = plist->head;
       if (pos > 0)
 	{
 	  if (plist->head->nprops)
 	    {
-	      interval = new_interval (0, pos);
+	      interval = new_interval (pos);
 	      interval->next = plist->head;
 	      plist->head->prev = interval;
 	      plist->head = interval;
+	      link_interval (plist, interval, interval->next);
 	    }
 	  else
-	    plist->head->start = 0;
+	    resize_interval (plist->head, pos);
 	}
       if (pos < mtext_nchars (mt))
 	{
 	  if (plist->tail->nprops)
 	    {
-	      interval = new_interval (pos + nchars,
-				       mtext_nchars (mt) + nchars);
+	      interval = new_interval (mtext_nchars (mt) - pos);
 	      interval->prev = plist->tail;
 	      plist->tail->next = interval;
 	      plist->tail = interval;
+	      link_interval (plist, interval, NULL);
 	    }
 	  else
-	    plist->tail->end = mtext_nchars (mt) + nchars;
+	    resize_interval (plist->tail, mtext_nchars (mt) - pos);
 	}
-      xassert (check_plist (plist, 0) == 0);
+      xassert (check_plist (plist) == 0);
     }
 }
 
@@ -1440,37 +1737,11 @@ mtext__adjust_plist_for_change (MText *mt, int pos, int len1, int len2)
 
   if (len1 < len2)
     {
-      int diff = len2 - len1;
       MTextPlist *plist;
 
+      /* Extend the interval covering the last replaced character.  */
       for (plist = mt->plist; plist; plist = plist->next)
-	{
-	  MInterval *head = find_interval (plist, pos2);
-	  MInterval *tail = plist->tail;
-	  MTextProperty *prop;
-	  int i;
-
-	  if (head)
-	    {
-	      if (head->start == pos2)
-		head = head->prev;
-	      while (tail != head)
-		{
-		  for (i = 0; i < tail->nprops; i++)
-		    {
-		      prop = tail->stack[i];
-		      if (prop->start == tail->start)
-			prop->start += diff, prop->end += diff;
-		    }
-		  tail->start += diff;
-		  tail->end += diff;
-		  tail = tail->prev;
-		}
-	    }
-	  for (i = 0; i < tail->nprops; i++)
-	    tail->stack[i]->end += diff;
-	  tail->end += diff;
-	}
+	resize_interval (find_interval (plist, pos2 - 1), len2 - len1);
     }
   else if (len1 > len2)
     {
@@ -1478,6 +1749,24 @@ mtext__adjust_plist_for_change (MText *mt, int pos, int len1, int len2)
     }
 }
 
+/** Return the start position of text property PROP attached to an
+    M-text.  */
+
+int
+mtext__prop_start (MTextProperty *prop)
+{
+  return interval_start (prop->first);
+}
+
+/** Return the end position of text property PROP attached to an
+    M-text.  */
+
+int
+mtext__prop_end (MTextProperty *prop)
+{
+  return interval_end (prop->last);
+}
+
 
 /*** @} */
 #endif /* !FOR_DOXYGEN || DOXYGEN_INTERNAL_MODULE */
@@ -1786,14 +2075,14 @@ mtext_put_prop (MText *mt, int from, int to, MSymbol key, void *val)
   prepare_to_modify (mt, from, to, key, 0);
   plist = get_plist_create (mt, key, 1);
   interval = pop_all_properties (plist, from, to);
-  prop = new_text_property (mt, from, to, key, val, 0);
+  prop = new_text_property (mt, key, val, 0);
   PUSH_PROP (interval, prop);
   M17N_OBJECT_UNREF (prop);
   if (interval->next)
     maybe_merge_interval (plist, interval);
   if (interval->prev)
     maybe_merge_interval (plist, interval->prev);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   return 0;
 }
 
@@ -1853,7 +2142,7 @@ mtext_put_prop_values (MText *mt, int from, int to,
       for (i = 0; i < num; i++)
 	{
 	  MTextProperty *prop
-	    = new_text_property (mt, from, to, key, values[i], 0);
+	    = new_text_property (mt, key, values[i], 0);
 	  PUSH_PROP (interval, prop);
 	  M17N_OBJECT_UNREF (prop);
 	}
@@ -1862,7 +2151,7 @@ mtext_put_prop_values (MText *mt, int from, int to,
     maybe_merge_interval (plist, interval);
   if (interval->prev)
     maybe_merge_interval (plist, interval->prev);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   return 0;
 }
 
@@ -1949,7 +2238,7 @@ mtext_push_prop (MText *mt, int from, int to,
   head = find_interval (plist, from);
 
   /* If the found interval starts before FROM, divide it at FROM.  */
-  if (head->start < from)
+  if (interval_start (head) < from)
     {
       divide_interval (plist, head, from);
       head = head->next;
@@ -1960,12 +2249,12 @@ mtext_push_prop (MText *mt, int from, int to,
 
   /* Find an interval that ends at TO.  If TO is not at the end of an
      interval, make one that ends at TO.  */
-  if (head->end == to)
+  if (interval_end (head) == to)
     {
       tail = head;
       check_tail = 1;
     }
-  else if (head->end > to)
+  else if (interval_end (head) > to)
     {
       divide_interval (plist, head, to);
       tail = head;
@@ -1979,7 +2268,7 @@ mtext_push_prop (MText *mt, int from, int to,
 	  tail = plist->tail;
 	  check_tail = 0;
 	}
-      else if (tail->start == to)
+      else if (interval_start (tail) == to)
 	{
 	  tail = tail->prev;
 	  check_tail = 1;
@@ -1991,7 +2280,7 @@ mtext_push_prop (MText *mt, int from, int to,
 	}
     }
 
-  prop = new_text_property (mt, from, to, key, val, 0);
+  prop = new_text_property (mt, key, val, 0);
 
   /* Push PROP to the current values of intervals between HEAD and TAIL
      (both inclusive).  */
@@ -2014,7 +2303,7 @@ mtext_push_prop (MText *mt, int from, int to,
   if (head->prev && check_head)
     maybe_merge_interval (plist, head->prev);
 
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   return 0;
 }
 
@@ -2102,7 +2391,7 @@ mtext_pop_prop (MText *mt, int from, int to, MSymbol key)
 
   /* Find an interval that covers the position FROM.  */
   head = find_interval (plist, from);
-  if (head->end >= to
+  if (interval_end (head) >= to
       && head->nprops == 0)
     /* No property to pop.  */
     return 0;
@@ -2111,7 +2400,7 @@ mtext_pop_prop (MText *mt, int from, int to, MSymbol key)
 
   /* If the found interval starts before FROM and has value(s), divide
      it at FROM.  */
-  if (head->start < from)
+  if (interval_start (head) < from)
     {
       if (head->nprops > 0)
 	{
@@ -2119,42 +2408,42 @@ mtext_pop_prop (MText *mt, int from, int to, MSymbol key)
 	  check_head = 0;
 	}
       else
-	from = head->end;
+	from = interval_end (head);
       head = head->next;
     }
 
   /* Pop the topmost text property from each interval following HEAD.
      Stop at an interval that ends after TO.  */
-  for (tail = head; tail && tail->end <= to; tail = tail->next)
+  for (tail = head; tail && interval_end (tail) <= to; tail = tail->next)
     if (tail->nprops > 0)
       POP_PROP (tail);
 
   if (tail)
     {
-      if (tail->start < to)
+      if (interval_start (tail) < to)
 	{
 	  if (tail->nprops > 0)
 	    {
 	      divide_interval (plist, tail, to);
 	      POP_PROP (tail);
 	    }
-	  to = tail->start;
+	  to = interval_start (tail);
 	}
       else
-	to = tail->end;
+	to = interval_end (tail);
     }
   else
-    to = plist->tail->start;
+    to = interval_start (plist->tail);
 
   /* If there is a possibility that HEAD now has the same text
      properties as the previous one, check it and concatenate them if
      necessary.  */
   if (head->prev && check_head)
     head = head->prev;
-  while (head && head->end <= to)
+  while (head && interval_end (head) <= to)
     head = maybe_merge_interval (plist, head);
 
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   return 0;
 }
 
@@ -2243,8 +2532,8 @@ mtext_prop_range (MText *mt, MSymbol key, int pos,
   nprops = interval->nprops;
   if (deeper || ! nprops)
     {
-      if (from) *from = interval->start;
-      if (to) *to = interval->end;
+      if (from) *from = interval_start (interval);
+      if (to) *to = interval_end (interval);
       return interval->nprops;
     }
 
@@ -2259,7 +2548,7 @@ mtext_prop_range (MText *mt, MSymbol key, int pos,
 		    && (val == temp->prev->stack[temp->prev->nprops - 1]))
 		 : ! nprops);
 	   temp = temp->prev);
-      *from = temp->start;
+      *from = interval_start (temp);
     }
 
   if (to)
@@ -2271,7 +2560,7 @@ mtext_prop_range (MText *mt, MSymbol key, int pos,
 		    && val == temp->next->stack[temp->next->nprops - 1])
 		 : ! nprops);
 	   temp = temp->next);
-      *to = temp->end;
+      *to = interval_end (temp);
     }
 
   return nprops;
@@ -2300,7 +2589,7 @@ mtext_prop_range (MText *mt, MSymbol key, int pos,
 MTextProperty *
 mtext_property (MSymbol key, void *val, int control_bits)
 {
-  return new_text_property (NULL, 0, 0, key, val, control_bits);
+  return new_text_property (NULL, key, val, control_bits);
 }
 
 /***en
@@ -2377,7 +2666,7 @@ mtext_property_value (MTextProperty *prop)
 int
 mtext_property_start (MTextProperty *prop)
 {
-  return (prop->mt ? prop->start : -1);
+  return (prop->mt ? MTEXTPROP_START (prop) : -1);
 }
 
 /***en
@@ -2398,7 +2687,7 @@ mtext_property_start (MTextProperty *prop)
 int
 mtext_property_end (MTextProperty *prop)
 {
-  return (prop->mt ? prop->end : -1);
+  return (prop->mt ? MTEXTPROP_END (prop) : -1);
 }
 
 /***en
@@ -2553,20 +2842,18 @@ mtext_attach_property (MText *mt, int from, int to, MTextProperty *prop)
     mtext_detach_property (prop);
   prepare_to_modify (mt, from, to, prop->key, 0);
   plist = get_plist_create (mt, prop->key, 1);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   interval = pop_all_properties (plist, from, to);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   prop->mt = mt;
-  prop->start = from;
-  prop->end = to;
   PUSH_PROP (interval, prop);
   M17N_OBJECT_UNREF (prop);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   if (interval->next)
     maybe_merge_interval (plist, interval);
   if (interval->prev)
     maybe_merge_interval (plist, interval->prev);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   return 0;
 }
 
@@ -2591,14 +2878,14 @@ int
 mtext_detach_property (MTextProperty *prop)
 {
   MTextPlist *plist;
-  int start = prop->start, end = prop->end;
 
   if (! prop->mt)
     return 0;
-  prepare_to_modify (prop->mt, start, end, prop->key, 0);
+  prepare_to_modify (prop->mt, MTEXTPROP_START (prop), MTEXTPROP_END (prop),
+		     prop->key, 0);
   plist = get_plist_create (prop->mt, prop->key, 0);
   xassert (plist);
-  detach_property (plist, prop, NULL);
+  detach_property (plist, prop);
   return 0;
 }
 
@@ -2641,14 +2928,12 @@ mtext_push_property (MText *mt, int from, int to, MTextProperty *prop)
   prepare_to_modify (mt, from, to, prop->key, 0);
   plist = get_plist_create (mt, prop->key, 1);
   prop->mt = mt;
-  prop->start = from;
-  prop->end = to;
 
   /* Find an interval that covers the position FROM.  */
   head = find_interval (plist, from);
 
   /* If the found interval starts before FROM, divide it at FROM.  */
-  if (head->start < from)
+  if (interval_start (head) < from)
     {
       divide_interval (plist, head, from);
       head = head->next;
@@ -2659,12 +2944,12 @@ mtext_push_property (MText *mt, int from, int to, MTextProperty *prop)
 
   /* Find an interval that ends at TO.  If TO is not at the end of an
      interval, make one that ends at TO.  */
-  if (head->end == to)
+  if (interval_end (head) == to)
     {
       tail = head;
       check_tail = 1;
     }
-  else if (head->end > to)
+  else if (interval_end (head) > to)
     {
       divide_interval (plist, head, to);
       tail = head;
@@ -2678,7 +2963,7 @@ mtext_push_property (MText *mt, int from, int to, MTextProperty *prop)
 	  tail = plist->tail;
 	  check_tail = 0;
 	}
-      else if (tail->start == to)
+      else if (interval_start (tail) == to)
 	{
 	  tail = tail->prev;
 	  check_tail = 1;
@@ -2710,7 +2995,7 @@ mtext_push_property (MText *mt, int from, int to, MTextProperty *prop)
     maybe_merge_interval (plist, head->prev);
 
   M17N_OBJECT_UNREF (prop);
-  xassert (check_plist (plist, 0) == 0);
+  xassert (check_plist (plist) == 0);
   return 0;
 }
 
@@ -2860,6 +3145,8 @@ mtext_serialize (MText *mt, int from, int to, MPlist *property_list)
   if (mt->format != MTEXT_FORMAT_US_ASCII
       && mt->format != MTEXT_FORMAT_UTF_8)
     mtext__adjust_format (mt, MTEXT_FORMAT_UTF_8);
+  else if (MTEXT_BORROWED_P (mt))
+    mtext__enlarge (mt, 0);
   if (MTEXT_DATA (mt)[mtext_nbytes (mt)] != 0)
     MTEXT_DATA (mt)[mtext_nbytes (mt)] = 0;
   doc = xmlParseMemory (XML_TEMPLATE, strlen (XML_TEMPLATE) + 1);
@@ -2895,9 +3182,9 @@ mtext_serialize (MText *mt, int from, int to, MPlist *property_list)
       xmlSetProp (child, (xmlChar *) "key",
 		  (xmlChar *) MSYMBOL_NAME (prop->key));
       xmlSetProp (child, (xmlChar *) "value", (xmlChar *) MTEXT_DATA (work));
-      sprintf (buf, "%d", prop->start - from);
+      sprintf (buf, "%d", MTEXTPROP_START (prop) - from);
       xmlSetProp (child, (xmlChar *) "from", (xmlChar *) buf);
-      sprintf (buf, "%d", prop->end - from);
+      sprintf (buf, "%d", MTEXTPROP_END (prop) - from);
       xmlSetProp (child, (xmlChar *) "to", (xmlChar *) buf);
       sprintf (buf, "%d", prop->control.flag);
       xmlSetProp (child, (xmlChar *) "control", (xmlChar *) buf);
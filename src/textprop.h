@@ -24,8 +24,8 @@
 #define _M17N_TEXTPROP_H_
 
 /** MTextProperty is the structure for a text property object.  While
-    attached, it is stored in the stacks of intervals covering the
-    range from MTextProperty->start to MTextProperty->end.  */
+    attached, it is stored in the stacks of intervals from
+    MTextProperty->first to MTextProperty->last.  */
 
 struct MTextProperty
 {
@@ -40,8 +40,10 @@ struct MTextProperty
       that the property is detached.  */
   MText *mt;
 
-  /** Region of <mt> if the property is attached to it.  */
-  int start, end;
+  /** The first and last intervals containing the property if it is
+      attached to <mt>.  The region of the property is computed from
+      them by MTEXTPROP_START () and MTEXTPROP_END ().  */
+  struct MInterval *first, *last;
 
   /** Key of the property.  */
   MSymbol key;
@@ -50,14 +52,18 @@ struct MTextProperty
   void *val;
 };
 
-#define MTEXTPROP_START(prop) (prop)->start
-#define MTEXTPROP_END(prop) (prop)->end
+#define MTEXTPROP_START(prop) mtext__prop_start (prop)
+#define MTEXTPROP_END(prop) mtext__prop_end (prop)
 #define MTEXTPROP_KEY(prop) (prop)->key
 #define MTEXTPROP_VAL(prop) (prop)->val
 
+extern int mtext__prop_start (MTextProperty *prop);
+
+extern int mtext__prop_end (MTextProperty *prop);
+
 extern struct MTextPlist *mtext__copy_plist (struct MTextPlist *, 
 					     int from, int to,
-					     MText *mt, int pos);
+					     MText *mt);
 
 extern void mtext__free_plist (MText *mt);
 